@@ -61,10 +61,9 @@ int main() {
             }
         }
         else if (auto bufferView = image.bufferView()) {
-            // image is in the GLB chunk. You might want to cache the buffer because you're going to read from it multiple times.
-            std::vector<unsigned char> buffer;
-            if (bufferView.buffer().load(buffer)) {
-                // Image::createFromFileMemory(imageData.data() + bufferView.byteOffset(), bufferView.byteLength());
+            // image is in the GLB chunk. The buffer is loaded once by the Gltf object and shared by all of its buffer views.
+            if (auto imageData = bufferView.data()) {
+                // Image::createFromFileMemory(imageData.data(), imageData.byteLength());
             }
         }
     }
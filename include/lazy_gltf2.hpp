@@ -14,10 +14,50 @@
 #include <sstream>
 #include <vector>
 #include <array>
+#include <algorithm>
 #include <memory>
+#include <cmath>
 #include <cstdint>
-#ifndef _WIN32
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <list>
+#include <unordered_map>
+#include <functional>
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
 #include <libgen.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// SIMD code paths are selected at compile time. Define LAZY_GLTF2_NO_SIMD to only use the scalar code.
+#ifndef LAZY_GLTF2_NO_SIMD
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LAZY_GLTF2_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(__SSSE3__) || defined(__AVX2__)
+#define LAZY_GLTF2_SSSE3
+#include <tmmintrin.h>
+#endif
+#if defined(__AVX2__)
+#define LAZY_GLTF2_AVX2
+#include <immintrin.h>
+#endif
 #endif
 
 #define LAZY_GLTF2_DATA_APP_BASE64 "data:application/octet-stream;base64,"
@@ -52,6 +92,7 @@ class Sampler;
 class Animation;
 class Channel;
 class Material;
+class PbrMetallicRoughness;
 class MorphTarget;
 class Image;
 class Skin;
@@ -70,6 +111,135 @@ using JsonDocument = ::rapidjson::Document;
 using JsonValue = ::rapidjson::Document::GenericValue;
 using unique_file_ptr = ::std::unique_ptr<FILE, FileCloser>;
 
+/// The name of a JSON member with a precomputed length.
+/// String literals and character arrays convert implicitly. Other strings must be wrapped explicitly, like JsonKey(name).
+class JsonKey {
+public:
+    /// The array may hold a shorter string so the length is measured up to the first null.
+    /// The compiler folds the measurement for string literals.
+    template<size_t N>
+    JsonKey(const char (&str)[N]) noexcept : m_str(str), m_length(length(str, N)) {}
+    explicit JsonKey(const char* str) noexcept : m_str(str), m_length(str != nullptr ? strlen(str) : 0) {}
+
+    const char* c_str() const noexcept {
+        return m_str;
+    }
+    size_t length() const noexcept {
+        return m_length;
+    }
+    bool operator==(const JsonValue& name) const noexcept {
+        return name.GetStringLength() == m_length && memcmp(name.GetString(), m_str, m_length) == 0;
+    }
+private:
+    static size_t length(const char* str, size_t size) noexcept {
+        const void* end = memchr(str, '\0', size);
+        return end != nullptr ? static_cast<const char*>(end) - str : size;
+    }
+
+    const char* m_str;
+    size_t m_length;
+};
+
+/// Finds a member of a JSON object.
+/// The length of the key is known so most members are rejected by comparing lengths.
+static JsonValue::ConstMemberIterator findMember(const JsonValue& json, const JsonKey& key) noexcept {
+    const auto end = json.MemberEnd();
+    for (auto it = json.MemberBegin(); it != end; ++it) {
+        if (key == it->name) {
+            return it;
+        }
+    }
+    return end;
+}
+
+/// A read only memory mapped file.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() {
+        close();
+    }
+    // don't support copying or moving
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /// Maps the whole file into memory.
+    /// @param[in] path Path to the file to map.
+    /// @return True if the file was mapped; false otherwise.
+    bool open(const char* path) noexcept;
+    /// Unmaps the file. Pointers returned by data() become invalid.
+    void close() noexcept;
+
+    const unsigned char* data() const noexcept {
+        return m_data;
+    }
+    size_t size() const noexcept {
+        return m_size;
+    }
+    operator bool() const noexcept {
+        return m_data != nullptr;
+    }
+private:
+    const unsigned char* m_data = nullptr;
+    size_t m_size = 0;
+#ifdef _WIN32
+    HANDLE m_file = INVALID_HANDLE_VALUE;
+    HANDLE m_mapping = nullptr;
+#endif
+};
+
+/// A non-owning view of the bytes of a Buffer or BufferView.
+/// The pointer becomes invalid when the Gltf object it came from loads a new file or is destroyed.
+class DataView {
+public:
+    DataView() = default;
+    DataView(const unsigned char* data, size_t byteLength, size_t byteStride = 0) noexcept
+        : m_data(data), m_byteLength(byteLength), m_byteStride(byteStride) {}
+
+    /// Returns a pointer to the first byte. May be null.
+    const unsigned char* data() const noexcept {
+        return m_data;
+    }
+    size_t byteLength() const noexcept {
+        return m_byteLength;
+    }
+    /// Returns the byteStride of the BufferView this view came from. Zero means tightly packed.
+    size_t byteStride() const noexcept {
+        return m_byteStride;
+    }
+    const unsigned char* begin() const noexcept {
+        return m_data;
+    }
+    const unsigned char* end() const noexcept {
+        return m_data + m_byteLength;
+    }
+    operator bool() const noexcept {
+        return m_data != nullptr;
+    }
+private:
+    const unsigned char* m_data = nullptr;
+    size_t m_byteLength = 0;
+    size_t m_byteStride = 0;
+};
+
+/// The top level arrays of a glTF document.
+enum class Collection {
+    SCENES,
+    NODES,
+    MESHES,
+    CAMERAS,
+    ACCESSORS,
+    BUFFERS,
+    BUFFER_VIEWS,
+    ANIMATIONS,
+    IMAGES,
+    TEXTURES,
+    SAMPLERS,
+    MATERIALS,
+    SKINS,
+    COUNT
+};
+
 /// Animation target path.
 enum class TargetPath {
     TRANSLATION,
@@ -87,6 +257,8 @@ enum class Interpolation {
 };
 
 static constexpr float DEFAULT_ASPECT_RATIO = 16.0f / 9.0f;
+/// The smallest number of base64 characters that is worth decoding on its own thread.
+static constexpr size_t BASE64_MIN_CHUNK_LENGTH = 256 * 1024;
 /// First 4 bytes of GLB file.
 static constexpr std::uint32_t MAGIC = 0x46546C67;
 static constexpr std::uint32_t JSON_CHUNK_TYPE = 0x4E4F534A;
@@ -121,1721 +293,5052 @@ namespace GLValue {
     };
 }
 
-/// The root glTF object.
-/// Use this class to load a gltf or glb file.
-class Gltf {
+/// A file opened for reading by a FileSystem.
+class InputFile {
 public:
-    Gltf() = default;
-    /// Creates a Gltf object and loads a file.
-    /// @param path Path to the file to load.
-    explicit Gltf(const char* path) {
-        load(path);
+    virtual ~InputFile() = default;
+    /// Returns the size of the file in bytes.
+    virtual size_t size() const noexcept = 0;
+    /// Reads up to size bytes starting at offset.
+    /// @return The number of bytes that were read.
+    virtual size_t read(size_t offset, void* data, size_t size) noexcept = 0;
+    /// Maps the whole file into memory. The view stays valid until this file is destroyed.
+    /// Mapping is optional; the default implementation returns an empty view.
+    virtual DataView map() noexcept {
+        return DataView();
     }
-    virtual ~Gltf() = default;
-
-    // support moving
-    Gltf(Gltf&&) = default;
-    Gltf& operator=(Gltf&&) = default;
-
-    // don't support copying
-    Gltf(const Gltf&) = delete;
-    Gltf& operator=(const Gltf&) = delete;
-
-    /// Loads a glTF 2.0 file.
-    /// @param[in] path Path to the file to load.
-    /// @return True if json file was loaded successful; false otherwise.
-    bool load(const char* path) noexcept;
+};
 
-    /// Returns the base directory of the file that was loaded.
-    /// The path will use forward slashes regardless of OS.
-    /// If you opened "res/box.gltf" then the returned string will be "res/"
-    const std::string& baseDir() const {
-        return m_baseDir;
+/// The file access used by a Gltf to load .gltf, .glb and external buffer files.
+/// Set a custom file system with Gltf::setFileSystem() to read from archives, use pread or load from memory.
+class FileSystem {
+public:
+    FileSystem() noexcept : m_id(nextId()) {}
+    FileSystem(const FileSystem&) noexcept : m_id(nextId()) {}
+    FileSystem& operator=(const FileSystem&) noexcept {
+        return *this;
     }
+    virtual ~FileSystem() = default;
+    /// Opens a file for reading.
+    /// @return The opened file or null if the file can't be opened.
+    virtual std::unique_ptr<InputFile> open(const char* path) noexcept = 0;
 
-    /// Returns true if a glTF 2.0 file was loaded successfully.
-    operator bool() const noexcept {
-        return m_doc != nullptr;
+    /// Returns a number that is unique to this file system object, even after other file systems are destroyed.
+    /// Buffer cache keys include it so that a shared cache never mixes up files of different file systems.
+    std::uint64_t id() const noexcept {
+        return m_id;
+    }
+private:
+    static std::uint64_t nextId() noexcept {
+        static std::atomic<std::uint64_t> fileSystemCount(0);
+        return ++fileSystemCount;
     }
 
-    /// Returns the index of the default scene.
-    bool defaultScene(size_t& index) {
-        if (m_doc) {
-            const auto& it = m_doc->FindMember("scene");
-            if (it != m_doc->MemberEnd()) {
-                if (it->value.IsNumber()) {
-                    index = it->value.GetUint();
-                    return true;
+    std::uint64_t m_id;
+};
+
+/// The default FileSystem. Files are read with the C standard library and mapped with MappedFile.
+class StdFileSystem : public FileSystem {
+    class File : public InputFile {
+    public:
+        File(unique_file_ptr file, size_t size, const char* path) : m_file(std::move(file)), m_size(size), m_path(path) {}
+        size_t size() const noexcept override {
+            return m_size;
+        }
+        size_t read(size_t offset, void* data, size_t size) noexcept override {
+            if (offset != m_position) {
+                if (offset > m_size || std::fseek(m_file.get(), static_cast<long>(offset), SEEK_SET)) {
+                    return 0;
                 }
+                m_position = offset;
             }
+            const size_t bytesRead = fread(data, 1, size, m_file.get());
+            m_position += bytesRead;
+            return bytesRead;
         }
-        return false;
+        DataView map() noexcept override {
+            if (!m_mapped) {
+                m_mapped.open(m_path.c_str());
+            }
+            return DataView(m_mapped.data(), m_mapped.size());
+        }
+    private:
+        unique_file_ptr m_file;
+        size_t m_size;
+        size_t m_position = 0;
+        std::string m_path;
+        MappedFile m_mapped;
+    };
+public:
+    std::unique_ptr<InputFile> open(const char* path) noexcept override {
+        unique_file_ptr file(fopen(path, "rb"));
+        FILE* fp = file.get();
+        if (!fp || std::fseek(fp, 0, SEEK_END)) {
+            return nullptr;
+        }
+        const long size = std::ftell(fp);
+        if (size < 0 || std::fseek(fp, 0, SEEK_SET)) {
+            return nullptr;
+        }
+        return std::unique_ptr<InputFile>(new File(std::move(file), static_cast<size_t>(size), path));
     }
 
-    /// Returns the default scene. This may not be the scene at index zero.
-    Scene scene() const noexcept;
-    Scene defaultScene() const noexcept;
-
-    Scene scene(size_t index) const noexcept;
-    /// Returns the number of scenes.
-    size_t sceneCount() const noexcept {
-        return count("scenes");
+    /// Returns the instance used by Gltf objects that don't have a file system set.
+    static const std::shared_ptr<FileSystem>& instance() {
+        static const std::shared_ptr<FileSystem> fileSystem = std::make_shared<StdFileSystem>();
+        return fileSystem;
     }
-    std::vector<Scene> scenes() const noexcept;
+};
 
-    Node node(size_t index) const noexcept;
-    size_t nodeCount() const noexcept {
-        return count("nodes");
-    }
-    std::vector<Node> nodes() const noexcept;
+/// A rapidjson read stream over an InputFile that reads one block at a time.
+/// Works like rapidjson::FileReadStream.
+class InputFileStream {
+public:
+    typedef char Ch;
 
-    Mesh mesh(size_t index) const noexcept;
-    size_t meshCount() const noexcept {
-        return count("meshes");
+    InputFileStream(InputFile& file, char* buffer, size_t bufferSize)
+        : m_file(file), m_buffer(buffer), m_bufferSize(bufferSize), m_end(buffer), m_current(buffer) {
+        read();
     }
-    std::vector<Mesh> meshes() const noexcept;
-
-    Camera camera(size_t index) const noexcept;
-    size_t cameraCount() const noexcept {
-        return count("cameras");
+    Ch Peek() const {
+        return *m_current;
     }
-    std::vector<Camera> cameras() const noexcept;
-
-    Accessor accessor(size_t index) const noexcept;
-    size_t accessorCount() const noexcept {
-        return count("accessors");
+    Ch Take() {
+        const Ch c = *m_current;
+        read();
+        return c;
     }
-    std::vector<Accessor> accessors() const noexcept;
-
-    Buffer buffer(size_t index) const noexcept;
-    size_t bufferCount() const noexcept {
-        return count("buffers");
+    size_t Tell() const {
+        return m_count + static_cast<size_t>(m_current - m_buffer);
     }
-    std::vector<Buffer> buffers() const noexcept;
 
-    BufferView bufferView(size_t index) const noexcept;
-    size_t bufferViewCount() const noexcept {
-        return count("bufferViews");
+    // not implemented
+    void Put(Ch) {}
+    void Flush() {}
+    Ch* PutBegin() {
+        return nullptr;
+    }
+    size_t PutEnd(Ch*) {
+        return 0;
     }
-    std::vector<BufferView> bufferViews() const noexcept;
 
-    Animation animation(size_t index) const noexcept;
-    size_t animationCount() const noexcept {
-        return count("animations");
+private:
+    void read() {
+        if (m_current + 1 < m_end) {
+            ++m_current;
+        }
+        else if (!m_eof) {
+            m_count += m_readCount;
+            m_readCount = m_file.read(m_count, m_buffer, m_bufferSize - 1);
+            m_end = m_buffer + m_readCount;
+            m_current = m_buffer;
+            if (m_readCount < m_bufferSize - 1) {
+                m_buffer[m_readCount] = '\0';
+                ++m_end;
+                m_eof = true;
+            }
+        }
     }
-    std::vector<Animation> animations() const noexcept;
 
-    Image image(size_t index) const noexcept;
-    size_t imageCount() const noexcept {
-        return count("images");
+    InputFile& m_file;
+    char* m_buffer;
+    size_t m_bufferSize;
+    /// One past the last character that can be taken.
+    char* m_end;
+    char* m_current;
+    size_t m_readCount = 0;
+    size_t m_count = 0;
+    bool m_eof = false;
+};
+
+/// A cache of loaded buffer data with an optional memory budget.
+/// Each Gltf object has its own unlimited cache by default. A cache may be shared by many Gltf objects
+/// with Gltf::setBufferCache() so that external .bin files are only loaded once.
+/// When the cached bytes exceed the budget, the least recently used buffers that are not pinned are evicted.
+/// All methods are thread safe.
+class BufferCache {
+    struct Entry {
+        explicit Entry(std::vector<unsigned char>&& bytes) : data(std::move(bytes)), pins(0) {}
+        std::vector<unsigned char> data;
+        std::atomic<size_t> pins;
+    };
+public:
+    /// A handle that pins a cached buffer.
+    /// The buffer won't be evicted while a handle refers to it and its data stays valid until the handle
+    /// is destroyed, even if the buffer is released from the cache.
+    class Handle {
+    public:
+        Handle() = default;
+        Handle(std::shared_ptr<Entry> entry, DataView view) noexcept : m_entry(std::move(entry)), m_view(view) {
+            if (m_entry) {
+                ++m_entry->pins;
+            }
+        }
+        ~Handle() {
+            reset();
+        }
+        Handle(Handle&& other) noexcept : m_entry(std::move(other.m_entry)), m_view(other.m_view) {
+            other.m_view = DataView();
+        }
+        Handle& operator=(Handle&& other) noexcept {
+            if (this != &other) {
+                reset();
+                m_entry = std::move(other.m_entry);
+                m_view = other.m_view;
+                other.m_view = DataView();
+            }
+            return *this;
+        }
+        Handle(const Handle&) = delete;
+        Handle& operator=(const Handle&) = delete;
+
+        /// Unpins the buffer.
+        void reset() noexcept {
+            if (m_entry) {
+                --m_entry->pins;
+                m_entry.reset();
+            }
+            m_view = DataView();
+        }
+        const DataView& view() const noexcept {
+            return m_view;
+        }
+        const unsigned char* data() const noexcept {
+            return m_view.data();
+        }
+        size_t byteLength() const noexcept {
+            return m_view.byteLength();
+        }
+        operator bool() const noexcept {
+            return m_view;
+        }
+    private:
+        std::shared_ptr<Entry> m_entry;
+        DataView m_view;
+    };
+
+    /// Creates a cache.
+    /// @param[in] budget The number of bytes that can be cached before buffers are evicted. Zero means unlimited.
+    explicit BufferCache(size_t budget = 0) : m_budget(budget) {}
+
+    // don't support copying
+    BufferCache(const BufferCache&) = delete;
+    BufferCache& operator=(const BufferCache&) = delete;
+
+    void setBudget(size_t budget) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_budget = budget;
+        evict();
+    }
+    size_t budget() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_budget;
+    }
+    /// Returns the number of bytes held by the cache.
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_size;
+    }
+    /// Returns the number of buffers held by the cache.
+    size_t count() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_entries.size();
+    }
+
+    /// Finds a buffer and marks it as the most recently used.
+    /// @return A handle that pins the buffer or an empty handle if the key isn't cached.
+    Handle find(const std::string& key) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const auto it = m_entries.find(key);
+        if (it == m_entries.end()) {
+            return Handle();
+        }
+        m_lru.splice(m_lru.begin(), m_lru, it->second);
+        const auto& entry = it->second->second;
+        return Handle(entry, DataView(entry->data.data(), entry->data.size()));
+    }
+
+    /// Adds a buffer to the cache, evicting other buffers if the budget is exceeded.
+    /// If the key is already cached then the existing buffer is returned and data is discarded.
+    /// @return A handle that pins the buffer.
+    Handle insert(const std::string& key, std::vector<unsigned char>&& data) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_entries.find(key);
+        if (it != m_entries.end()) {
+            m_lru.splice(m_lru.begin(), m_lru, it->second);
+        }
+        else {
+            m_size += data.size();
+            m_lru.emplace_front(key, std::make_shared<Entry>(std::move(data)));
+            it = m_entries.emplace(key, m_lru.begin()).first;
+        }
+        const auto& entry = it->second->second;
+        Handle handle(entry, DataView(entry->data.data(), entry->data.size()));
+        evict();
+        return handle;
+    }
+
+    /// Removes a buffer from the cache, such as after it was uploaded to the GPU.
+    /// The memory is freed once no Handle refers to it.
+    /// @return True if the key was cached.
+    bool release(const std::string& key) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const auto it = m_entries.find(key);
+        if (it == m_entries.end()) {
+            return false;
+        }
+        erase(it->second);
+        return true;
     }
-    std::vector<Image> images() const noexcept;
 
-    Texture texture(size_t index) const noexcept;
-    size_t textureCount() const noexcept {
-        return count("textures");
+    /// Evicts buffers that aren't pinned until the cache fits in the budget.
+    void trim() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        evict();
     }
-    std::vector<Texture> textures() const noexcept;
 
-    Sampler sampler(size_t index) const noexcept;
-    size_t samplerCount() const noexcept {
-        return count("samplers");
+    /// Removes all buffers from the cache.
+    void clear() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_entries.clear();
+        m_lru.clear();
+        m_size = 0;
     }
-    std::vector<Sampler> samplers() const noexcept;
+private:
+    using Lru = std::list<std::pair<std::string, std::shared_ptr<Entry>>>;
 
-    Material material(size_t index) const noexcept;
-    size_t materialCount() const noexcept {
-        return count("materials");
+    void erase(Lru::iterator it) {
+        m_size -= it->second->data.size();
+        m_entries.erase(it->first);
+        m_lru.erase(it);
     }
-    std::vector<Material> materials() const noexcept;
 
-    Skin skin(size_t index) const noexcept;
-    size_t skinCount() const noexcept {
-        return count("skins");
+    void evict() {
+        if (m_budget == 0) {
+            return;
+        }
+        auto it = m_lru.end();
+        while (m_size > m_budget && it != m_lru.begin()) {
+            --it;
+            if (it->second->pins == 0) {
+                erase(it++);
+            }
+        }
     }
-    std::vector<Skin> skins() const noexcept;
 
-    Asset asset() const noexcept;
+    mutable std::mutex m_mutex;
+    Lru m_lru; // most recently used first
+    std::unordered_map<std::string, Lru::iterator> m_entries;
+    size_t m_size = 0;
+    size_t m_budget;
+};
 
-    /// Finds a node by name.
-    Node findNode(const char* name);
-    /// Finds a mesh by name.
-    Mesh findMesh(const char* name);
-    /// Finds a skin by name.
-    Skin findSkin(const char* name);
-    /// Finds a material by name.
-    Material findMaterial(const char* name);
+/// A reusable memory pool for the JSON document of a Gltf.
+/// Set it with Gltf::setArena(). Each call to Gltf::load() resets the arena instead of freeing it,
+/// and when a document outgrew the backing buffer the buffer is grown to the high water mark,
+/// so loading many files of a similar size settles into a single allocation.
+/// An arena may only be used by one Gltf at a time because loading resets it.
+class JsonArena {
+public:
+    using Allocator = JsonDocument::AllocatorType;
+
+    /// Creates an arena that owns its backing buffer.
+    /// @param[in] capacity The initial size of the backing buffer in bytes. Zero allocates on demand.
+    explicit JsonArena(size_t capacity = 0) {
+        grow(capacity);
+    }
+    /// Creates an arena that uses a caller provided buffer first.
+    /// The buffer must be 8 byte aligned and outlive the arena. It is never freed by the arena and is
+    /// replaced by an owned buffer if a document doesn't fit.
+    JsonArena(void* buffer, size_t size) {
+        if (buffer != nullptr && size >= MIN_BUFFER_SIZE) {
+            m_allocator.reset(new Allocator(buffer, size));
+            m_capacity = m_allocator->Capacity();
+        }
+        else {
+            m_allocator.reset(new Allocator());
+        }
+    }
 
-    std::vector<const char*> extensionsRequired() const noexcept;
-    std::vector<const char*> extensionsUsed() const noexcept;
+    // don't support copying
+    JsonArena(const JsonArena&) = delete;
+    JsonArena& operator=(const JsonArena&) = delete;
 
-    template<typename T>
-    bool loadGlbData(std::vector<T>& data) const noexcept;
+    Allocator& allocator() noexcept {
+        return *m_allocator;
+    }
+    /// Returns the number of bytes used by the current document.
+    size_t size() const noexcept {
+        return m_allocator->Size();
+    }
+    /// Returns the number of bytes in the backing buffer that are reused by reset().
+    size_t capacity() const noexcept {
+        return m_capacity;
+    }
+    /// Returns the largest number of bytes used by a document since the arena was created.
+    size_t highWaterMark() const noexcept {
+        return std::max(m_highWaterMark, size());
+    }
 
-    /// Returns a pointer to the json document. May be null.
-    const JsonDocument* doc() const noexcept {
-        return m_doc.get();
+    /// Releases everything allocated by the arena while keeping the backing buffer.
+    /// Any document that was allocated from the arena must already have been destroyed.
+    void reset() {
+        m_highWaterMark = highWaterMark();
+        if (m_highWaterMark > m_capacity) {
+            grow(m_highWaterMark);
+        }
+        else {
+            m_allocator->Clear();
+        }
     }
 
-    friend bool operator==(const Gltf& lhs, const Gltf& rhs);
-    friend bool operator!=(const Gltf& lhs, const Gltf& rhs);
 private:
-
-    /// Class that holds the GLB meta data.
-    class GlbData {
-    public:
-        std::string path;
-        std::uint32_t chunkLength = 0;
-        std::uint32_t offset = 0;
-        GlbData() = default;
-        ~GlbData() = default;
-        // Support moving
-        GlbData(GlbData&&) = default;
-        GlbData& operator=(GlbData&&) = default;
-        // Don't support copying
-        GlbData(const GlbData&) = delete;
-        GlbData& operator=(const GlbData&) = delete;
+    enum : size_t {
+        MIN_BUFFER_SIZE = 1024
     };
 
-    size_t count(const char* key) const noexcept {
-        if (m_doc) {
-            const auto& it = m_doc->FindMember(key);
-            if (it != m_doc->MemberEnd()) {
-                return it->value.Size();
+    void grow(size_t capacity) {
+        m_allocator.reset(nullptr);
+        m_buffer.reset(nullptr);
+        m_capacity = 0;
+        if (capacity != 0) {
+            // leave room for the allocator's bookkeeping
+            const size_t size = std::max<size_t>(capacity + capacity / 8, MIN_BUFFER_SIZE);
+            m_buffer.reset(new (std::nothrow) char[size]);
+            if (m_buffer) {
+                m_allocator.reset(new Allocator(m_buffer.get(), size));
+                m_capacity = m_allocator->Capacity();
+                return;
             }
         }
-        return 0;
+        m_allocator.reset(new Allocator());
     }
 
-    template<typename T>
-    T findByName(const char* key, const char* name) {
-        const auto& it = m_doc->FindMember(key);
-        if (name != nullptr && it != m_doc->MemberEnd() && it->value.IsArray()) {
-            const auto size = it->value.Size();
-            for (size_t i = 0; i < size; ++i) {
-                const auto& v = it->value[i];
-                const auto& nameIt = v.FindMember("name");
-                if (nameIt != v.MemberEnd() && nameIt->value.IsString()) {
-                    if (strcmp(name, nameIt->value.GetString()) == 0) {
-                        return T(this, &v);
-                    }
-                }
-            }
+    std::unique_ptr<char[]> m_buffer;
+    std::unique_ptr<Allocator> m_allocator;
+    size_t m_capacity = 0;
+    size_t m_highWaterMark = 0;
+};
+
+/// Flattened copies of the most frequently used properties of a glTF document, built by Gltf::compile().
+/// Each table is a struct of arrays indexed like the matching top level array of the document.
+/// Vector valued properties are stored contiguously, such as 3 floats per node in Nodes::translation.
+/// Lists, like the children of a node, are stored as one array of values plus an array of count + 1 offsets.
+/// Enums are stored as their glTF values. The tables don't refer to the JSON document so they stay valid
+/// after Gltf::releaseDocument().
+class CompiledGltf {
+public:
+    /// The value used for missing indices.
+    enum : std::uint32_t {
+        NONE = 0xFFFFFFFF
+    };
+
+    struct Nodes {
+        enum Flags : std::uint8_t {
+            HAS_TRANSLATION = 1,
+            HAS_ROTATION = 2,
+            HAS_SCALE = 4,
+            HAS_MATRIX = 8
+        };
+        /// The properties that are present. Missing properties hold their default values in the tables.
+        std::vector<std::uint8_t> flags;
+        std::vector<float> translation; // 3 per node
+        std::vector<float> rotation;    // 4 per node
+        std::vector<float> scale;       // 3 per node
+        std::vector<float> matrix;      // 16 per node
+        std::vector<std::uint32_t> mesh;
+        std::vector<std::uint32_t> camera;
+        std::vector<std::uint32_t> skin;
+        std::vector<std::uint32_t> childOffsets;
+        std::vector<std::uint32_t> children;
+        size_t size() const noexcept {
+            return flags.size();
         }
-        return T();
-    }
+    };
 
-    bool loadGlbMetaData(const char* path);
+    struct Accessors {
+        std::vector<std::uint32_t> bufferView;
+        std::vector<std::uint32_t> byteOffset;
+        std::vector<std::uint32_t> count;
+        std::vector<std::uint16_t> componentType;
+        /// The index of Accessor::Type.
+        std::vector<std::uint8_t> type;
+        std::vector<std::uint8_t> normalized;
+        size_t size() const noexcept {
+            return count.size();
+        }
+    };
 
-    void clear() noexcept {
-        m_doc.reset(nullptr);
-        m_glb.reset(nullptr);
-        m_baseDir.clear();
-    }
+    struct BufferViews {
+        std::vector<std::uint32_t> buffer;
+        std::vector<std::uint32_t> byteOffset;
+        std::vector<std::uint32_t> byteLength;
+        std::vector<std::uint32_t> byteStride;
+        std::vector<std::uint16_t> target;
+        size_t size() const noexcept {
+            return buffer.size();
+        }
+    };
 
-    std::unique_ptr<JsonDocument> m_doc;
-    std::unique_ptr<GlbData> m_glb;
-    std::string m_baseDir;
-};
+    struct Meshes {
+        /// The primitives of mesh i are primitives [primitiveOffsets[i], primitiveOffsets[i + 1]).
+        std::vector<std::uint32_t> primitiveOffsets;
+        size_t size() const noexcept {
+            return primitiveOffsets.empty() ? 0 : primitiveOffsets.size() - 1;
+        }
+    };
 
-inline bool operator==(const Gltf& lhs, const Gltf& rhs) {
-    return lhs.m_doc == rhs.m_doc && lhs.m_glb == rhs.m_glb && lhs.m_baseDir == rhs.m_baseDir;
-}
-inline bool operator!=(const Gltf& lhs, const Gltf& rhs) {
-    return !(lhs == rhs);
-}
-inline bool operator==(const Gltf& lhs, std::nullptr_t) noexcept {
-    return !lhs;
-}
-inline bool operator==(std::nullptr_t, const Gltf& rhs) noexcept {
-    return !rhs;
-}
-inline bool operator!=(const Gltf& lhs, std::nullptr_t) noexcept {
-    return lhs;
-}
-inline bool operator!=(std::nullptr_t, const Gltf& rhs) noexcept {
-    return rhs;
-}
+    /// The primitives of all meshes.
+    struct Primitives {
+        std::vector<std::uint32_t> mesh;
+        std::vector<std::uint8_t> mode;
+        std::vector<std::uint32_t> indices;
+        std::vector<std::uint32_t> material;
+        std::vector<std::uint32_t> attributeOffsets;
+        std::vector<std::string> attributeNames;
+        std::vector<std::uint32_t> attributes;
+        size_t size() const noexcept {
+            return mesh.size();
+        }
+    };
 
-// functions
+    struct Materials {
+        std::vector<float> baseColorFactor; // 4 per material
+        std::vector<float> metallicFactor;
+        std::vector<float> roughnessFactor;
+        std::vector<float> emissiveFactor;  // 3 per material
+        /// The index of Material::AlphaMode.
+        std::vector<std::uint8_t> alphaMode;
+        std::vector<float> alphaCutoff;
+        std::vector<std::uint8_t> doubleSided;
+        std::vector<std::uint32_t> baseColorTexture;
+        std::vector<std::uint32_t> metallicRoughnessTexture;
+        std::vector<std::uint32_t> normalTexture;
+        std::vector<std::uint32_t> occlusionTexture;
+        std::vector<std::uint32_t> emissiveTexture;
+        size_t size() const noexcept {
+            return alphaMode.size();
+        }
+    };
 
-static inline char lowercase(char ch) {
-    return ch >= 'A' && ch <= 'Z' ? ch | 0x20 : ch;
-}
+    struct Samplers {
+        std::vector<std::uint16_t> magFilter;
+        std::vector<std::uint16_t> minFilter;
+        std::vector<std::uint16_t> wrapS;
+        std::vector<std::uint16_t> wrapT;
+        size_t size() const noexcept {
+            return magFilter.size();
+        }
+    };
 
-/// Returns true if subject starts with prefix. Case sensitive.
-inline bool startsWith(const char* subject, const char* prefix) {
-    if (subject == prefix) {
-        return true;
+    struct Textures {
+        std::vector<std::uint32_t> sampler;
+        std::vector<std::uint32_t> source;
+        size_t size() const noexcept {
+            return source.size();
+        }
+    };
+
+    Nodes nodes;
+    Accessors accessors;
+    BufferViews bufferViews;
+    Meshes meshes;
+    Primitives primitives;
+    Materials materials;
+    Samplers samplers;
+    Textures textures;
+};
+
+/// The parents and children of the nodes and the root nodes of the scenes as flat index tables.
+/// Use Gltf::hierarchy() to get the tables. They are built from the JSON the first time they are used.
+/// Child and root indices that are out of range are left out.
+class NodeHierarchy {
+    friend Gltf;
+public:
+    enum : std::uint32_t {
+        NONE = 0xFFFFFFFF
+    };
+
+    size_t nodeCount() const noexcept {
+        return m_parents.size();
     }
-    if (subject == nullptr || prefix == nullptr) {
-        return false;
+    size_t sceneCount() const noexcept {
+        return m_rootOffsets.empty() ? 0 : m_rootOffsets.size() - 1;
     }
-    return strncmp(prefix, subject, strlen(prefix)) == 0;
-}
-
-inline std::string dirName(const char* path) {
-    // This is copied from the code I wrote in gameplay3d
-    if (path == nullptr || strlen(path) == 0) {
-        return "";
+    /// Returns the first parent of a node or NONE if the node is a root.
+    std::uint32_t parent(size_t node) const noexcept {
+        return m_parents[node];
     }
-#ifdef _WIN32
-    char drive[_MAX_DRIVE];
-    char dir[_MAX_DIR];
-    _splitpath_s(path, drive, _MAX_DRIVE, dir, _MAX_DIR, nullptr, 0, nullptr, 0);
-    std::string dirname;
-    size_t driveLength = strlen(drive);
-    if (driveLength > 0) {
-        dirname.reserve(driveLength + strlen(dir));
-        dirname.append(drive);
-        dirname.append(dir);
+    /// Returns the number of nodes that have this node as a child. More than one isn't valid glTF.
+    std::uint32_t parentCount(size_t node) const noexcept {
+        return m_parentCounts[node];
     }
-    else {
-        dirname.assign(dir);
+    size_t childCount(size_t node) const noexcept {
+        return m_childOffsets[node + 1] - m_childOffsets[node];
     }
-    std::replace(dirname.begin(), dirname.end(), '\\', '/');
-    return dirname;
-#else
-    // dirname() modifies the input string so create a temp string
-    std::string dirname;
-    char* tempPath = new char[strlen(path) + 1];
-    strcpy(tempPath, path);
-    char* dir = ::dirname(tempPath);
-    if (dir && strlen(dir) > 0) {
-        dirname.assign(dir);
-        // dirname() strips off the trailing '/' so add it back to be consistent with Windows
-        dirname.append("/");
+    /// Returns the childCount() children of a node.
+    const std::uint32_t* children(size_t node) const noexcept {
+        return m_children.data() + m_childOffsets[node];
     }
-    delete[] tempPath;
-    return dirname;
-#endif
-}
-
-template<typename T>
-static bool findNumber(const JsonValue* json, const char* key, T& value) {
-    if (json != nullptr) {
-        auto it = json->FindMember(key);
-        if (it != json->MemberEnd() && it->value.IsNumber()) {
-            value = it->value.Get<T>();
-            return true;
-        }
+    size_t rootCount(size_t scene) const noexcept {
+        return m_rootOffsets[scene + 1] - m_rootOffsets[scene];
     }
-    return false;
-}
+    /// Returns the rootCount() root nodes of a scene.
+    const std::uint32_t* roots(size_t scene) const noexcept {
+        return m_roots.data() + m_rootOffsets[scene];
+    }
+private:
+    std::vector<std::uint32_t> m_parents;
+    std::vector<std::uint32_t> m_parentCounts;
+    std::vector<std::uint32_t> m_childOffsets;
+    std::vector<std::uint32_t> m_children;
+    std::vector<std::uint32_t> m_rootOffsets;
+    std::vector<std::uint32_t> m_roots;
+};
 
-template<typename T>
-static bool findNumber(const JsonValue* json, const char* key, size_t index, T& value) {
-    if (json != nullptr) {
-        auto it = json->FindMember(key);
-        if (it != json->MemberEnd() && it->value.IsArray() && index < it->value.Size()) {
-            const auto& v = it->value[index];
-            if (v.IsNumber()) {
-                value = v.Get<T>();
-                return true;
+/// The animation channels of each node and the animations that target each node.
+/// Use Gltf::animationIndex() to get the index. It is built from the JSON the first time it is used.
+/// Channels without a target node or with a node that is out of range are left out.
+class AnimationIndex {
+    friend Gltf;
+public:
+    enum : std::uint32_t {
+        NONE = 0xFFFFFFFF
+    };
+
+    struct Entry {
+        std::uint32_t node;
+        TargetPath path;
+        std::uint32_t channel;
+    };
+
+    size_t animationCount() const noexcept {
+        return m_entryOffsets.empty() ? 0 : m_entryOffsets.size() - 1;
+    }
+    size_t nodeCount() const noexcept {
+        return m_animationOffsets.empty() ? 0 : m_animationOffsets.size() - 1;
+    }
+
+    /// Returns the channels of an animation that target a node, ordered by path and then by channel index.
+    /// @return The first entry. count is set to the number of entries.
+    const Entry* channels(size_t animation, size_t node, size_t& count) const noexcept {
+        const Entry* begin = m_entries.data() + m_entryOffsets[animation];
+        const Entry* end = m_entries.data() + m_entryOffsets[animation + 1];
+        const auto range = std::equal_range(begin, end, Entry{ static_cast<std::uint32_t>(node), TargetPath(), 0 },
+            [](const Entry& lhs, const Entry& rhs) { return lhs.node < rhs.node; });
+        count = static_cast<size_t>(range.second - range.first);
+        return range.first;
+    }
+    /// Returns the first channel of an animation that targets a path of a node or NONE.
+    std::uint32_t findChannel(size_t animation, size_t node, TargetPath path) const noexcept {
+        size_t count;
+        const Entry* entries = channels(animation, node, count);
+        for (size_t i = 0; i < count; ++i) {
+            if (entries[i].path == path) {
+                return entries[i].channel;
             }
         }
+        return NONE;
     }
-    return false;
-}
-
-template<typename T>
-static T findNumberOrDefault(const JsonValue* json, const char* key, T defaultValue) {
-    if (json != nullptr) {
-        auto it = json->FindMember(key);
-        if (it != json->MemberEnd() && it->value.IsNumber()) {
-            return it->value.Get<T>();
-        }
+    /// Returns the number of animations that target a node.
+    size_t animationCount(size_t node) const noexcept {
+        return m_animationOffsets[node + 1] - m_animationOffsets[node];
     }
-    return defaultValue;
-}
+    /// Returns the animationCount(node) animations that target a node in ascending order.
+    const std::uint32_t* animations(size_t node) const noexcept {
+        return m_animations.data() + m_animationOffsets[node];
+    }
+private:
+    /// The entries of each animation sorted by node, path and channel.
+    std::vector<Entry> m_entries;
+    std::vector<std::uint32_t> m_entryOffsets;
+    std::vector<std::uint32_t> m_animationOffsets;
+    std::vector<std::uint32_t> m_animations;
+};
 
-template<typename T>
-static T findNumberOrDefault(const JsonValue* json, const char* key, size_t index, T defaultValue) {
-    if (json != nullptr) {
-        auto it = json->FindMember(key);
-        if (it != json->MemberEnd() && it->value.IsArray() && index < it->value.Size()) {
-            const auto& v = it->value[index];
-            if (v.IsNumber()) {
-                return v.Get<T>();
+/// Visits the nodes below a set of roots without recursion, depth first in pre-order or breadth first.
+/// Each node is visited once. A node that is reached again through a cycle or a second parent is skipped and
+/// counted in revisits(). The pending nodes are kept in an array that is allocated by the constructor, so
+/// starting the same traversal again doesn't allocate.
+/// The traversal becomes invalid when the Gltf that owns the hierarchy loads a new file.
+class NodeTraversal {
+public:
+    enum class Order {
+        DEPTH_FIRST,
+        BREADTH_FIRST
+    };
+
+    struct Visit {
+        std::uint32_t node;
+        /// The node that the node was reached from or NodeHierarchy::NONE for the roots.
+        std::uint32_t parent;
+        /// Zero for the roots.
+        std::uint32_t depth;
+    };
+
+    /// Calls next() when incremented.
+    class iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Visit;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Visit*;
+        using reference = const Visit&;
+
+        iterator() = default;
+        explicit iterator(NodeTraversal* traversal) noexcept : m_traversal(traversal) {
+            ++*this;
+        }
+        const Visit& operator*() const noexcept {
+            return m_visit;
+        }
+        const Visit* operator->() const noexcept {
+            return &m_visit;
+        }
+        iterator& operator++() noexcept {
+            if (!m_traversal->next(m_visit)) {
+                m_traversal = nullptr;
             }
+            return *this;
+        }
+        bool operator==(const iterator& rhs) const noexcept {
+            return m_traversal == rhs.m_traversal;
         }
+        bool operator!=(const iterator& rhs) const noexcept {
+            return !(*this == rhs);
+        }
+    private:
+        NodeTraversal* m_traversal = nullptr;
+        Visit m_visit = Visit();
+    };
+
+    NodeTraversal() = default;
+    explicit NodeTraversal(const NodeHierarchy& hierarchy, Order order = Order::DEPTH_FIRST)
+        : m_hierarchy(&hierarchy), m_order(order), m_marks(hierarchy.nodeCount(), 0) {
+        m_pending.reserve(hierarchy.nodeCount());
     }
-    return defaultValue;
-}
 
-template<typename T>
-static bool findNumberInMap(const JsonValue* json, const char* key1, const char* key2, T& value) {
-    if (json != nullptr) {
-        auto it = json->FindMember(key1);
-        if (it != json->MemberEnd() && it->value.IsObject()) {
-            auto it2 = it->value.FindMember(key2);
-            if (it2 != it->value.MemberEnd() && it2->value.IsNumber()) {
-                value = it2->value.Get<T>();
-                return true;
-            }
+    /// Starts a traversal of the nodes of a scene.
+    void startScene(size_t scene) noexcept {
+        if (m_hierarchy != nullptr && scene < m_hierarchy->sceneCount()) {
+            start(m_hierarchy->roots(scene), m_hierarchy->rootCount(scene));
+        }
+        else {
+            start(nullptr, 0);
+        }
+    }
+    /// Starts a traversal of a node and its descendants.
+    void startNode(size_t node) noexcept {
+        const std::uint32_t root = static_cast<std::uint32_t>(node);
+        start(&root, m_hierarchy != nullptr && node < m_hierarchy->nodeCount() ? 1 : 0);
+    }
+    /// Starts a traversal of the given root nodes.
+    void start(const std::uint32_t* roots, size_t count) noexcept {
+        m_pending.clear();
+        m_head = 0;
+        m_revisits = 0;
+        if (++m_generation == 0) {
+            std::fill(m_marks.begin(), m_marks.end(), 0);
+            m_generation = 1;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            push(roots[i], NodeHierarchy::NONE, 0);
+        }
+        if (m_order == Order::DEPTH_FIRST) {
+            // the first root is visited first
+            std::reverse(m_pending.begin(), m_pending.end());
         }
     }
-    return false;
-}
 
-template<typename T>
-static std::vector<T> getNumberVector(const JsonValue* json, const char* key) {
-    std::vector<T> vec;
-    if (json != nullptr) {
-        auto it = json->FindMember(key);
-        if (it != json->MemberEnd() && it->value.IsArray()) {
-            const size_t size = it->value.Size();
-            for (size_t index = 0; index < size; ++index) {
-                const auto& v = it->value[index];
-                if (v.IsNumber()) {
-                    vec.push_back(v.Get<T>());
-                }
+    /// Visits the next node.
+    /// @return False when every node was visited.
+    bool next(Visit& visit) noexcept {
+        if (m_order == Order::DEPTH_FIRST) {
+            if (m_pending.empty()) {
+                return false;
             }
+            visit = m_pending.back();
+            m_pending.pop_back();
+            const size_t count = m_hierarchy->childCount(visit.node);
+            const std::uint32_t* children = m_hierarchy->children(visit.node);
+            const size_t first = m_pending.size();
+            for (size_t i = 0; i < count; ++i) {
+                push(children[i], visit.node, visit.depth + 1);
+            }
+            // the first child is visited first
+            std::reverse(m_pending.begin() + first, m_pending.end());
+            return true;
+        }
+        if (m_head == m_pending.size()) {
+            return false;
         }
+        visit = m_pending[m_head++];
+        const size_t count = m_hierarchy->childCount(visit.node);
+        const std::uint32_t* children = m_hierarchy->children(visit.node);
+        for (size_t i = 0; i < count; ++i) {
+            push(children[i], visit.node, visit.depth + 1);
+        }
+        return true;
     }
-    return vec;
-}
 
-template<typename T>
-static T findObject(const Gltf* gltf, const JsonValue* json, const char* key) {
-    if (json != nullptr) {
-        auto it = json->FindMember(key);
-        if (it != json->MemberEnd() && it->value.IsObject()) {
-            return T(gltf, &it->value);
-        }
+    /// Returns the number of times a node that was already reached was skipped.
+    /// Zero means the nodes form a tree.
+    size_t revisits() const noexcept {
+        return m_revisits;
     }
-    return T();
-}
 
-template<typename T>
-static T findObject(const Gltf* gltf, const JsonValue* json, const char* key, size_t index) {
-    if (json != nullptr) {
-        auto it = json->FindMember(key);
-        if (it != json->MemberEnd() && it->value.IsArray() && index < it->value.Size()) {
-            const auto& v = it->value[index];
-            if (v.IsObject()) {
-                return T(gltf, &v);
-            }
+    iterator begin() noexcept {
+        return iterator(this);
+    }
+    iterator end() noexcept {
+        return iterator();
+    }
+private:
+    void push(std::uint32_t node, std::uint32_t parent, std::uint32_t depth) noexcept {
+        if (m_marks[node] == m_generation) {
+            ++m_revisits;
+            return;
         }
+        // each node is pushed once so this never grows past the reserved size
+        m_marks[node] = m_generation;
+        m_pending.push_back(Visit{ node, parent, depth });
+    }
+
+    const NodeHierarchy* m_hierarchy = nullptr;
+    Order m_order = Order::DEPTH_FIRST;
+    std::vector<Visit> m_pending;
+    /// The next node to visit when breadth first.
+    size_t m_head = 0;
+    size_t m_revisits = 0;
+    /// The nodes that were reached are marked with the generation of the traversal.
+    std::vector<std::uint32_t> m_marks;
+    std::uint32_t m_generation = 0;
+};
+
+/// Unloads the file of a Gltf before the Gltf is move assigned.
+/// Base classes are assigned before members, so Gltf can use the defaulted move assignment.
+class GltfUnloader {
+protected:
+    GltfUnloader() = default;
+    GltfUnloader(GltfUnloader&&) = default;
+    GltfUnloader& operator=(GltfUnloader&& other) noexcept;
+    ~GltfUnloader() = default;
+};
+
+/// The root glTF object.
+/// Use this class to load a gltf or glb file.
+class Gltf : private GltfUnloader {
+public:
+    Gltf() : m_bufferCache(std::make_shared<BufferCache>()) {}
+    /// Creates a Gltf object and loads a file.
+    /// @param path Path to the file to load.
+    explicit Gltf(const char* path) : Gltf() {
+        load(path);
+    }
+    virtual ~Gltf() {
+        releaseEmbeddedBuffers();
     }
-    return T();
-}
 
-template<typename T>
-static T findGltfObject(const Gltf* gltf, const char* key, size_t index) {
-    return findGltfObject<T>(gltf, gltf->doc(), key, index);
-}
+    // support moving
+    Gltf(Gltf&&) = default;
+    /// Releases the embedded buffers of the loaded file from the buffer cache before taking the state of other.
+    Gltf& operator=(Gltf&&) = default;
 
-template<typename T>
-static T findGltfObject(const Gltf* gltf, const JsonValue* json, const char* key, size_t index) {
-    if (json) {
-        const auto it = json->FindMember(key);
-        if (it != json->MemberEnd()) {
-            const auto& values = it->value;
-            if (values.IsArray() && index < values.Size()) {
-                return T(gltf, &values[index]);
-            }
-        }
+    // don't support copying
+    Gltf(const Gltf&) = delete;
+    Gltf& operator=(const Gltf&) = delete;
+
+    /// Loads the data of an external URI, like a .bin file, into data.
+    /// @return True if the URI was resolved; false otherwise.
+    using UriResolver = std::function<bool(const char* uri, std::vector<unsigned char>& data)>;
+
+    /// Loads a glTF 2.0 file.
+    /// @param[in] path Path to the file to load.
+    /// @return True if json file was loaded successful; false otherwise.
+    bool load(const char* path) noexcept;
+
+    /// Loads a .gltf or .glb file from memory. A GLB is detected by its magic header.
+    /// The JSON is parsed straight from data (or in-situ from a copy if in-situ parsing is enabled)
+    /// and Buffer::data() returns a view into the BIN chunk of data, so data must outlive this Gltf.
+    /// @param[in] data     The file contents.
+    /// @param[in] size     The size of data in bytes.
+    /// @param[in] resolver Loads external buffers. If null, only GLB and base64 buffers can be loaded because
+    ///                     relative URIs have no base directory.
+    /// @return True if json file was loaded successful; false otherwise.
+    bool load(const void* data, size_t size, UriResolver resolver = nullptr) noexcept;
+
+    /// Returns the resolver for external URIs that was given to load(). May be empty.
+    const UriResolver& uriResolver() const noexcept {
+        return m_uriResolver;
+    }
+    /// Returns true if the file was loaded from memory instead of from a path.
+    bool loadedFromMemory() const noexcept {
+        return m_loadedFromMemory;
     }
-    return T();
-}
 
-template<typename T>
-static std::vector<T> getObjectVector(const Gltf* gltf, const JsonValue* json, const char* key) {
-    std::vector<T> vec;
-    const auto& it = json->FindMember(key);
-    if (it != json->MemberEnd() && it->value.IsArray()) {
-        const auto size = it->value.Size();
-        vec.reserve(size);
-        for (size_t i = 0; i < size; ++i) {
-            const auto& v = it->value[i];
-            vec.emplace_back(gltf, &v);
-        }
+    /// Enables memory mapping of GLB files. Takes effect on the next call to load().
+    /// When enabled the whole .glb file is mapped once, the JSON chunk is parsed directly from the mapping
+    /// and Buffer::data() and BufferView::data() return views into the mapped BIN chunk instead of copying it.
+    void setMemoryMapping(bool enabled) noexcept {
+        m_memoryMapping = enabled;
+    }
+    /// Returns true if GLB files will be memory mapped.
+    bool memoryMapping() const noexcept {
+        return m_memoryMapping;
     }
-    return vec;
-}
 
-template<typename T>
-static std::vector<T> getObjectVector(const Gltf* gltf, const char* key) {
-    return getObjectVector<T>(gltf, gltf->doc(), key);
-}
+    /// Enables in-situ parsing of the JSON. Takes effect on the next call to load().
+    /// When enabled the .gltf file (or the JSON chunk of a .glb file that isn't memory mapped) is read into a buffer
+    /// owned by this Gltf and parsed in place, so strings like names and base64 URIs aren't copied again.
+    void setInSituParsing(bool enabled) noexcept {
+        m_inSituParsing = enabled;
+    }
+    /// Returns true if the JSON will be parsed in place.
+    bool inSituParsing() const noexcept {
+        return m_inSituParsing;
+    }
 
-static std::vector<const char*> getKeys(const JsonValue* json, const char* key) {
-    std::vector<const char*> vec;
-    if (json != nullptr) {
-        auto it = json->FindMember(key);
-        if (it != json->MemberEnd() && it->value.IsObject()) {
-            auto& value = it->value;
-            const size_t size = value.MemberCount();
-            vec.reserve(size);
-            for (auto member = value.MemberBegin(); member != value.MemberEnd(); ++member) {
-                vec.push_back(member->name.GetString());
-            }
-        }
+    /// Sets the file system used to open the .gltf, .glb and external buffer files.
+    /// Null uses StdFileSystem.
+    void setFileSystem(std::shared_ptr<FileSystem> fileSystem) noexcept {
+        m_fileSystem = std::move(fileSystem);
+    }
+    /// Returns the file system used to open files.
+    FileSystem& fileSystem() const noexcept {
+        return m_fileSystem ? *m_fileSystem : *StdFileSystem::instance();
     }
-    return vec;
-}
 
-static std::vector<const char*> getStrings(const JsonValue* json, const char* key) {
-    std::vector<const char*> vec;
-    if (json != nullptr) {
-        auto it = json->FindMember(key);
-        if (it != json->MemberEnd() && it->value.IsArray()) {
-            const auto size = it->value.Size();
-            vec.reserve(size);
-            for (size_t i = 0; i < size; ++i) {
-                vec.push_back(it->value[i].GetString());
-            }
-        }
+    /// Sets the maximum number of threads used to decode large base64 buffers.
+    /// Zero uses std::thread::hardware_concurrency(). The default is 1.
+    void setDecodeThreadCount(size_t count) noexcept {
+        m_decodeThreadCount = count;
+    }
+    /// Returns the maximum number of threads used to decode large base64 buffers.
+    size_t decodeThreadCount() const noexcept {
+        return m_decodeThreadCount != 0 ? m_decodeThreadCount : std::max(1u, std::thread::hardware_concurrency());
     }
-    return vec;
-}
 
-/// Copys numbers from a json element
-/// @return True if the numbers were copied.
-template<typename T>
-static bool copyNumbers(const JsonValue* json, const char* key, size_t count, T* m) noexcept {
-    if (json != nullptr && m != nullptr) {
-        auto it = json->FindMember(key);
-        if (it != json->MemberEnd() && it->value.IsArray() && count <= it->value.Size()) {
-            for (auto& v : it->value.GetArray()) {
-                *m++ = v.Get<T>();
+    /// Returns the base directory of the file that was loaded.
+    /// The path will use forward slashes regardless of OS.
+    /// If you opened "res/box.gltf" then the returned string will be "res/"
+    const std::string& baseDir() const {
+        return m_baseDir;
+    }
+
+    /// Returns true if a glTF 2.0 file was loaded successfully.
+    operator bool() const noexcept {
+        return m_doc != nullptr;
+    }
+
+    /// Returns the index of the default scene.
+    bool defaultScene(size_t& index) {
+        if (m_doc) {
+            const auto& it = findMember(*m_doc, "scene");
+            if (it != m_doc->MemberEnd()) {
+                if (it->value.IsNumber()) {
+                    index = it->value.GetUint();
+                    return true;
+                }
             }
-            return true;
         }
+        return false;
     }
-    return false;
-}
 
-/// Decodes a base64 string.
-/// @param[in]  text       The base64 text to decode.
-/// @param[in]  byteLength The expected number of bytes to read.
-/// @param[out] data       The vector to copy the data to.
-/// @return True if the base64 text was decoded successfully; false otherwise.
-template<typename T>
-bool readBase64(const char* text, size_t byteLength, std::vector<T>&data) {
-    std::istringstream in(text);
-    data.clear();
-    data.reserve(byteLength);
-    lib64::decoder decoder;
-    lib64::base64_init_decodestate(&decoder._state);
-    std::array<char, 1024> code;
-    std::array<char, 1024> plaintext;
-    int codelength;
-    do {
-        in.read(code.data(), code.size());
-        codelength = static_cast<int>(in.gcount());
-        int plainlength = decoder.decode(code.data(), codelength, plaintext.data());
-        data.insert(data.end(), plaintext.begin(), plaintext.begin() + plainlength);
-    } while (in.good() && codelength > 0);
-    base64_init_decodestate(&decoder._state);
-    return true;
-}
+    /// Returns the default scene. This may not be the scene at index zero.
+    Scene scene() const noexcept;
+    Scene defaultScene() const noexcept;
 
-/// Reads a binary file and copies the data to the given vector.
-/// @param[in]  path       The path to the file.
-/// @param[in]  byteLength The number of bytes to read.
-/// @param[out] data       The vector to copy the data to.
-/// @retrun True if the file was loaded successfully; false otherwise.
-template<typename T>
-bool readBinaryFile(const char* path, size_t byteLength, std::vector<T>& data) {
-    unique_file_ptr file(fopen(path, "rb"));
-    FILE* fp = file.get();
-    if (!fp) {
-        return false;
+    Scene scene(size_t index) const noexcept;
+    /// Returns the number of scenes.
+    size_t sceneCount() const noexcept {
+        return count(Collection::SCENES);
     }
-    data.resize(byteLength);
-    if (fread(data.data(), 1, byteLength, fp) == byteLength) {
-        return true;
+    std::vector<Scene> scenes() const noexcept;
+
+    Node node(size_t index) const noexcept;
+    size_t nodeCount() const noexcept {
+        return count(Collection::NODES);
     }
-    return false;
-}
+    std::vector<Node> nodes() const noexcept;
 
-/// Base class for GLTF objects.
-class Object {
-public:
-    Object() : m_gltf(nullptr), m_json(nullptr) {}
-    Object(const Gltf* gltf, const JsonValue* json) : m_gltf(gltf), m_json(json) {}
-    virtual ~Object() = default;
-    bool isNull() const noexcept { return m_gltf == nullptr; }
-    /// Returns true if this Object is not null. (Meaning it is usable)
-    operator bool() const noexcept { return m_gltf != nullptr; }
+    Mesh mesh(size_t index) const noexcept;
+    size_t meshCount() const noexcept {
+        return count(Collection::MESHES);
+    }
+    std::vector<Mesh> meshes() const noexcept;
 
-    /// Returns a string property from this GLTF object.
-    /// The string returned by the method will become invalid when the json document is unloaded
-    /// make a copy if you need it long term.
-    /// @param key The key of the property.
-    /// @return The string or null if not found.
-    const char* str(const char* key) const noexcept {
-        if (m_json != nullptr && key != nullptr) {
-            auto it = m_json->FindMember(key);
-            if (it != m_json->MemberEnd() && it->value.IsString()) {
-                return it->value.GetString();
-            }
-        }
-        return nullptr;
+    Camera camera(size_t index) const noexcept;
+    size_t cameraCount() const noexcept {
+        return count(Collection::CAMERAS);
     }
-    friend bool operator==(const Object& lhs, const Object& rhs);
-protected:
-    /// Returns the size of an array or the number of members in an object.
-    size_t count(const char* key) const noexcept {
-        if (m_json != nullptr) {
-            auto it = m_json->FindMember(key);
-            if (it != m_json->MemberEnd()) {
-                if (it->value.IsArray()) {
-                    return it->value.Size();
-                }
-                else if (it->value.MemberCount()) {
-                    return it->value.MemberCount();
-                }
-            }
-        }
-        return 0;
+    std::vector<Camera> cameras() const noexcept;
+
+    Accessor accessor(size_t index) const noexcept;
+    size_t accessorCount() const noexcept {
+        return count(Collection::ACCESSORS);
     }
-    bool copyFloats(const char* key, size_t count, float* m) const noexcept {
-        // TODO remove and replace with tempalte?
-        if (m_json != nullptr && m != nullptr) {
-            auto it = m_json->FindMember(key);
-            if (it != m_json->MemberEnd() && it->value.IsArray() && count <= it->value.Size()) {
-                for (auto& v : it->value.GetArray()) {
-                    *m++ = v.GetFloat();
-                }
-                return true;
-            }
+    std::vector<Accessor> accessors() const noexcept;
+
+    Buffer buffer(size_t index) const noexcept;
+    size_t bufferCount() const noexcept {
+        return count(Collection::BUFFERS);
+    }
+    std::vector<Buffer> buffers() const noexcept;
+
+    BufferView bufferView(size_t index) const noexcept;
+    size_t bufferViewCount() const noexcept {
+        return count(Collection::BUFFER_VIEWS);
+    }
+    std::vector<BufferView> bufferViews() const noexcept;
+
+    Animation animation(size_t index) const noexcept;
+    size_t animationCount() const noexcept {
+        return count(Collection::ANIMATIONS);
+    }
+    std::vector<Animation> animations() const noexcept;
+
+    Image image(size_t index) const noexcept;
+    size_t imageCount() const noexcept {
+        return count(Collection::IMAGES);
+    }
+    std::vector<Image> images() const noexcept;
+
+    Texture texture(size_t index) const noexcept;
+    size_t textureCount() const noexcept {
+        return count(Collection::TEXTURES);
+    }
+    std::vector<Texture> textures() const noexcept;
+
+    Sampler sampler(size_t index) const noexcept;
+    size_t samplerCount() const noexcept {
+        return count(Collection::SAMPLERS);
+    }
+    std::vector<Sampler> samplers() const noexcept;
+
+    Material material(size_t index) const noexcept;
+    size_t materialCount() const noexcept {
+        return count(Collection::MATERIALS);
+    }
+    std::vector<Material> materials() const noexcept;
+
+    Skin skin(size_t index) const noexcept;
+    size_t skinCount() const noexcept {
+        return count(Collection::SKINS);
+    }
+    std::vector<Skin> skins() const noexcept;
+
+    Asset asset() const noexcept;
+
+    /// Finds the first object with the given name in one of the top level arrays.
+    /// The names of an array are hashed the first time it is searched, so later searches are O(1).
+    /// @return True if an object was found.
+    bool findIndex(Collection collection, const char* name, size_t& index) const;
+    /// Returns the indices of all of the objects with the given name in ascending order.
+    std::vector<size_t> findIndices(Collection collection, const char* name) const;
+
+    /// Finds a node by name.
+    Node findNode(const char* name) const;
+    /// Finds a node by the names of it and its ancestors separated by '/', like "Root/Arm/Hand".
+    /// The first name must belong to a node that isn't the child of another node.
+    /// When names are duplicated every matching branch is searched and the first match is returned.
+    Node findNodeByPath(const char* path) const;
+
+    /// Returns the parents and children of the nodes and the roots of the scenes.
+    /// The tables are built the first time this is called and stay valid until the next load().
+    const NodeHierarchy& hierarchy() const;
+    /// Returns the animation channels of each node and the animations that target each node.
+    /// The index is built the first time this is called and stays valid until the next load().
+    const AnimationIndex& animationIndex() const;
+    /// Finds a mesh by name.
+    Mesh findMesh(const char* name) const;
+    /// Finds a skin by name.
+    Skin findSkin(const char* name) const;
+    /// Finds a material by name.
+    Material findMaterial(const char* name) const;
+    /// Finds a scene by name.
+    Scene findScene(const char* name) const;
+    /// Finds a camera by name.
+    Camera findCamera(const char* name) const;
+    /// Finds an accessor by name.
+    Accessor findAccessor(const char* name) const;
+    /// Finds a buffer by name.
+    Buffer findBuffer(const char* name) const;
+    /// Finds a buffer view by name.
+    BufferView findBufferView(const char* name) const;
+    /// Finds an animation by name.
+    Animation findAnimation(const char* name) const;
+    /// Finds an image by name.
+    Image findImage(const char* name) const;
+    /// Finds a texture by name.
+    Texture findTexture(const char* name) const;
+    /// Finds a sampler by name.
+    Sampler findSampler(const char* name) const;
+
+    std::vector<const char*> extensionsRequired() const noexcept;
+    std::vector<const char*> extensionsUsed() const noexcept;
+
+    template<typename T>
+    bool loadGlbData(std::vector<T>& data) const noexcept;
+
+    /// Returns a view of the data of the buffer at the given index.
+    /// The buffer is loaded into the buffer cache the first time it is requested, so every BufferView
+    /// that refers to it shares the same bytes. Memory mapped GLB buffers are not copied.
+    /// With the default unlimited cache the view is valid until this Gltf object loads a new file or is destroyed.
+    /// If the cache has a budget then the buffer may be evicted when other buffers are loaded;
+    /// use pinBuffer() to keep it resident.
+    /// @return The view or an empty view if the buffer could not be loaded.
+    DataView bufferData(size_t index) const noexcept;
+
+    /// Loads the buffer at the given index into the buffer cache and pins it.
+    /// @return A handle that keeps the buffer resident or an empty handle if it could not be loaded.
+    BufferCache::Handle pinBuffer(size_t index) const noexcept;
+
+    /// Removes the buffer at the given index from the buffer cache, such as after it was uploaded to the GPU.
+    /// Views returned by bufferData() for this buffer become invalid unless the buffer is pinned.
+    /// @return True if the buffer was cached.
+    bool releaseBuffer(size_t index) const noexcept;
+
+    /// Sets the cache used to hold loaded buffers. The cache can be shared by many Gltf objects.
+    /// Buffers of the currently loaded file that were cached by the old cache are not moved.
+    /// Null uses a cache of this Gltf that is cleared every time a new file is loaded.
+    void setBufferCache(std::shared_ptr<BufferCache> cache) noexcept {
+        m_defaultBufferCache = !cache;
+        m_bufferCache = cache ? std::move(cache) : std::make_shared<BufferCache>();
+    }
+    /// Returns the cache used to hold loaded buffers.
+    const std::shared_ptr<BufferCache>& bufferCache() const noexcept {
+        return m_bufferCache;
+    }
+
+    /// Sets the arena that the JSON document is parsed into. Takes effect on the next call to load().
+    /// Null uses a new allocator for every document.
+    void setArena(std::shared_ptr<JsonArena> arena) noexcept {
+        m_arena = std::move(arena);
+    }
+    /// Returns the arena that the JSON document will be parsed into.
+    const std::shared_ptr<JsonArena>& arena() const noexcept {
+        return m_arena;
+    }
+
+    /// Returns a view of the GLB BIN chunk if the file was memory mapped or loaded from memory;
+    /// otherwise an empty view.
+    DataView glbData() const noexcept {
+        if (m_glb && m_glb->bytes) {
+            return DataView(m_glb->bytes.data() + m_glb->offset, m_glb->chunkLength);
         }
-        return false;
+        return DataView();
     }
 
-    float findFloat(const char* key, float defaultValue = 0.0f) const noexcept {
-        if (m_json != nullptr) {
-            auto it = m_json->FindMember(key);
-            if (it != m_json->MemberEnd() && it->value.IsNumber()) {
-                return it->value.GetFloat();
+    /// Returns a pointer to the json document. May be null.
+    const JsonDocument* doc() const noexcept {
+        return m_doc.get();
+    }
+
+    /// Flattens the frequently used properties of the document into the compact tables of CompiledGltf.
+    /// Afterwards the getters of Node, Mesh, Primitive, Accessor, BufferView, Material, PbrMetallicRoughness,
+    /// TextureInfo, Texture and Sampler read from the tables instead of searching the JSON.
+    /// The tables are rebuilt by every call and released by load().
+    /// @return The tables or null if no document is loaded.
+    std::shared_ptr<const CompiledGltf> compile();
+    /// Returns the tables built by compile(). May be null.
+    const CompiledGltf* compiled() const noexcept {
+        return m_compiled.get();
+    }
+    /// Frees the JSON document to save memory after compile().
+    /// The nodes, meshes, accessors, buffer views, materials, samplers and textures can still be counted and
+    /// found by index and their compiled properties keep working, as does hierarchy(). Everything else,
+    /// such as names, scenes, animations and buffers, is gone and existing objects must not be used.
+    /// Properties that aren't compiled read as if they were missing from the file, so they return their defaults.
+    /// Without compile() nothing can be found anymore.
+    void releaseDocument();
+
+    /// Returns the number of objects in one of the top level arrays.
+    size_t count(Collection collection) const noexcept {
+        // a moved from Gltf has no document but still has the old table
+        return m_doc || m_stubs ? m_collections[static_cast<size_t>(collection)].size : 0;
+    }
+    /// Returns the json object at index in one of the top level arrays or null if index is out of range.
+    /// The arrays are resolved once when the file is loaded so this is a bounds checked array access.
+    const JsonValue* object(Collection collection, size_t index) const noexcept {
+        const auto& table = m_collections[static_cast<size_t>(collection)];
+        return (m_doc || m_stubs) && index < table.size ? table.values + index : nullptr;
+    }
+
+    friend bool operator==(const Gltf& lhs, const Gltf& rhs);
+    friend bool operator!=(const Gltf& lhs, const Gltf& rhs);
+    friend GltfUnloader;
+private:
+
+    /// Class that holds the GLB meta data.
+    class GlbData {
+    public:
+        std::string path;
+        std::uint32_t chunkLength = 0;
+        std::uint32_t offset = 0;
+        /// Only open when the GLB was loaded with memory mapping enabled.
+        std::unique_ptr<InputFile> file;
+        /// The whole GLB file when it was memory mapped or loaded from memory.
+        DataView bytes;
+        GlbData() = default;
+        ~GlbData() = default;
+        // Don't support copying
+        GlbData(const GlbData&) = delete;
+        GlbData& operator=(const GlbData&) = delete;
+    };
+
+    template<typename T>
+    T findByName(Collection collection, const char* name) const {
+        size_t index;
+        return findIndex(collection, name, index) ? T(this, object(collection, index)) : T();
+    }
+
+    /// Hash of a null terminated string.
+    struct StringHash {
+        size_t operator()(const char* str) const noexcept {
+            // FNV-1a
+            std::uint32_t hash = 2166136261u;
+            for (; *str != '\0'; ++str) {
+                hash = (hash ^ static_cast<unsigned char>(*str)) * 16777619u;
             }
+            return hash;
         }
-        return defaultValue;
+    };
+    struct StringEqual {
+        bool operator()(const char* lhs, const char* rhs) const noexcept {
+            return strcmp(lhs, rhs) == 0;
+        }
+    };
+
+    /// Hash tables of the names of the objects in the top level arrays, the node hierarchy and the animation index.
+    /// Each table is built on first use. The keys point into the document.
+    class NameIndex {
+    public:
+        enum : std::uint32_t {
+            NONE = 0xFFFFFFFF
+        };
+        struct Table {
+            /// The first object with each name.
+            std::unordered_map<const char*, std::uint32_t, StringHash, StringEqual> first;
+            /// The next object with the same name as each object or NONE.
+            std::vector<std::uint32_t> next;
+        };
+        NameIndex() = default;
+        /// Uses a hierarchy that was built from a document that is gone.
+        explicit NameIndex(NodeHierarchy&& prebuilt) : hierarchy(std::move(prebuilt)), hierarchyAdopted(true) {}
+
+        std::array<Table, static_cast<size_t>(Collection::COUNT)> tables;
+        std::array<std::once_flag, static_cast<size_t>(Collection::COUNT)> built;
+        NodeHierarchy hierarchy;
+        std::once_flag hierarchyBuilt;
+        const bool hierarchyAdopted = false;
+        AnimationIndex animations;
+        std::once_flag animationsBuilt;
+    };
+    const NameIndex::Table& nameTable(Collection collection) const;
+
+    bool loadGlbMetaData(const char* path);
+    bool loadMappedGlb(const char* path);
+    /// Parses a GLB that is entirely in memory. glb->bytes must be set.
+    bool parseGlb(std::unique_ptr<GlbData> glb, bool inSitu);
+    /// Returns a unique id for each load so that embedded buffers get unique cache keys.
+    static std::uint64_t nextLoadId() noexcept {
+        static std::atomic<std::uint64_t> loadCount(0);
+        return ++loadCount;
+    }
+    /// Creates an empty document that allocates from the arena if there is one.
+    void createDocument();
+    /// Parses the JSON from a rapidjson stream.
+    template<typename Stream>
+    void parseStream(Stream& stream) {
+        createDocument();
+        m_doc->ParseStream(stream);
+        resolveCollections();
+    }
+    /// Parses the first size bytes of m_json in place. m_json must have room for a null terminator.
+    void parseInSitu(size_t size);
+    /// Resolves the top level arrays of the document or of the stubs after releaseDocument().
+    void resolveCollections() noexcept;
+    /// Creates empty objects in place of the compiled objects of the document, keeping only the
+    /// sub-objects that the getters look for, so that the objects can still be found by index.
+    std::unique_ptr<JsonDocument> createStubs() const;
+
+    /// Returns the key of a buffer in the buffer cache.
+    /// Buffers that come from files use the file system and path so that they can be shared by other Gltf objects.
+    std::string bufferKey(size_t index) const;
+    /// Removes the buffers of the loaded file that no other Gltf can use, like base64 buffers, from the buffer cache.
+    void releaseEmbeddedBuffers() noexcept;
+    /// Adds the cache keys of the buffers that only this Gltf can use.
+    void collectEmbeddedKeys(std::vector<std::string>& keys) const;
+
+    /// Releases the embedded buffers and destroys the document before the text and arena that it was parsed from.
+    void unload() noexcept {
+        releaseEmbeddedBuffers();
+        m_doc.reset(nullptr);
     }
 
-    bool findBool(const char* key, bool defaultValue = false) const noexcept {
-        if (m_json != nullptr) {
-            auto it = m_json->FindMember(key);
-            if (it != m_json->MemberEnd() && it->value.IsBool()) {
-                return it->value.GetBool();
-            }
+    void clear() noexcept {
+        unload();
+        if (!m_bufferCache) {
+            m_bufferCache = std::make_shared<BufferCache>();
+            m_defaultBufferCache = true;
         }
-        return defaultValue;
+        else if (m_defaultBufferCache) {
+            // no other Gltf uses the default cache so the buffers of the last file are dropped
+            m_bufferCache->clear();
+        }
+        m_stubs.reset(nullptr);
+        m_docArena.reset();
+        std::vector<char>().swap(m_json);
+        m_glb.reset(nullptr);
+        m_compiled.reset();
+        m_names.reset(new NameIndex());
+        m_collections.fill(CollectionTable());
+        m_baseDir.clear();
+        m_uriResolver = nullptr;
+        m_loadedFromMemory = false;
     }
 
-    const Gltf* m_gltf;
-    const JsonValue* m_json;
+    /// The text that m_doc was parsed from when parsing in-situ. Must outlive m_doc.
+    std::vector<char> m_json;
+    /// The arena that m_doc was allocated from. Must outlive m_doc.
+    std::shared_ptr<JsonArena> m_docArena;
+    std::shared_ptr<JsonArena> m_arena;
+    std::unique_ptr<JsonDocument> m_doc;
+    /// Stands in for m_doc after releaseDocument() if the document was compiled.
+    std::unique_ptr<JsonDocument> m_stubs;
+    struct CollectionTable {
+        const JsonValue* values = nullptr;
+        size_t size = 0;
+    };
+    std::array<CollectionTable, static_cast<size_t>(Collection::COUNT)> m_collections;
+    std::shared_ptr<const CompiledGltf> m_compiled;
+    std::unique_ptr<NameIndex> m_names;
+    /// The cache keys of embedded buffers after the document was released.
+    std::vector<std::string> m_embeddedKeys;
+    std::unique_ptr<GlbData> m_glb;
+    std::shared_ptr<BufferCache> m_bufferCache;
+    /// True if m_bufferCache was created by this Gltf instead of set with setBufferCache().
+    bool m_defaultBufferCache = true;
+    std::uint64_t m_loadId = 0;
+    std::string m_baseDir;
+    UriResolver m_uriResolver;
+    bool m_loadedFromMemory = false;
+    std::shared_ptr<FileSystem> m_fileSystem;
+    bool m_memoryMapping = false;
+    bool m_inSituParsing = false;
+    size_t m_decodeThreadCount = 1;
 };
 
-inline bool operator==(const Object& lhs, const Object& rhs) {
-    return lhs.m_gltf == rhs.m_gltf && lhs.m_json == rhs.m_json;
+inline bool operator==(const Gltf& lhs, const Gltf& rhs) {
+    return lhs.m_doc == rhs.m_doc && lhs.m_glb == rhs.m_glb && lhs.m_baseDir == rhs.m_baseDir;
 }
-inline bool operator!=(const Object& lhs, const Object& rhs) {
+inline bool operator!=(const Gltf& lhs, const Gltf& rhs) {
     return !(lhs == rhs);
 }
-inline bool operator==(const Object& lhs, std::nullptr_t) noexcept {
+
+inline GltfUnloader& GltfUnloader::operator=(GltfUnloader&& other) noexcept {
+    if (this != &other) {
+        static_cast<Gltf*>(this)->unload();
+    }
+    return *this;
+}
+inline bool operator==(const Gltf& lhs, std::nullptr_t) noexcept {
     return !lhs;
 }
-inline bool operator==(std::nullptr_t, const Object& rhs) noexcept {
+inline bool operator==(std::nullptr_t, const Gltf& rhs) noexcept {
     return !rhs;
 }
-inline bool operator!=(const Object& lhs, std::nullptr_t) noexcept {
+inline bool operator!=(const Gltf& lhs, std::nullptr_t) noexcept {
     return lhs;
 }
-inline bool operator!=(std::nullptr_t, const Object& rhs) noexcept {
+inline bool operator!=(std::nullptr_t, const Gltf& rhs) noexcept {
     return rhs;
 }
 
-/// A gltf object that has a string name.
-class Named : public Object {
-public:
-    Named() {}
-    Named(const Gltf* gltf, const JsonValue* json) : Object(gltf, json) {}
-    const char* name() const noexcept {
-        return str("name");
+// functions
+
+static inline char lowercase(char ch) {
+    return ch >= 'A' && ch <= 'Z' ? ch | 0x20 : ch;
+}
+
+/// Returns true if subject starts with prefix. Case sensitive.
+inline bool startsWith(const char* subject, const char* prefix) {
+    if (subject == prefix) {
+        return true;
     }
-};
+    if (subject == nullptr || prefix == nullptr) {
+        return false;
+    }
+    return strncmp(prefix, subject, strlen(prefix)) == 0;
+}
 
-/// Orthographic camera
-class Orthographic : public Object {
-public:
-    Orthographic() {}
-    Orthographic(const Gltf* gltf, const JsonValue* json) : Object(gltf, json) {}
+inline std::string dirName(const char* path) {
+    // This is copied from the code I wrote in gameplay3d
+    if (path == nullptr || strlen(path) == 0) {
+        return "";
+    }
+#ifdef _WIN32
+    char drive[_MAX_DRIVE];
+    char dir[_MAX_DIR];
+    _splitpath_s(path, drive, _MAX_DRIVE, dir, _MAX_DIR, nullptr, 0, nullptr, 0);
+    std::string dirname;
+    size_t driveLength = strlen(drive);
+    if (driveLength > 0) {
+        dirname.reserve(driveLength + strlen(dir));
+        dirname.append(drive);
+        dirname.append(dir);
+    }
+    else {
+        dirname.assign(dir);
+    }
+    std::replace(dirname.begin(), dirname.end(), '\\', '/');
+    return dirname;
+#else
+    // dirname() modifies the input string so create a temp string
+    std::string dirname;
+    char* tempPath = new char[strlen(path) + 1];
+    strcpy(tempPath, path);
+    char* dir = ::dirname(tempPath);
+    if (dir && strlen(dir) > 0) {
+        dirname.assign(dir);
+        // dirname() strips off the trailing '/' so add it back to be consistent with Windows
+        dirname.append("/");
+    }
+    delete[] tempPath;
+    return dirname;
+#endif
+}
 
-    float xmag() const noexcept {
-        return findFloat("xmag");
+template<typename T>
+static bool findNumber(const JsonValue* json, const JsonKey& key, T& value) {
+    if (json != nullptr) {
+        auto it = findMember(*json, key);
+        if (it != json->MemberEnd() && it->value.IsNumber()) {
+            value = it->value.Get<T>();
+            return true;
+        }
     }
-    float ymag() const noexcept {
-        return findFloat("ymag");
+    return false;
+}
+
+template<typename T>
+static bool findNumber(const JsonValue* json, const JsonKey& key, size_t index, T& value) {
+    if (json != nullptr) {
+        auto it = findMember(*json, key);
+        if (it != json->MemberEnd() && it->value.IsArray() && index < it->value.Size()) {
+            const auto& v = it->value[index];
+            if (v.IsNumber()) {
+                value = v.Get<T>();
+                return true;
+            }
+        }
     }
-    float zfar() const noexcept {
-        return findFloat("zfar");
+    return false;
+}
+
+template<typename T>
+static T findNumberOrDefault(const JsonValue* json, const JsonKey& key, T defaultValue) {
+    if (json != nullptr) {
+        auto it = findMember(*json, key);
+        if (it != json->MemberEnd() && it->value.IsNumber()) {
+            return it->value.Get<T>();
+        }
+    }
+    return defaultValue;
+}
+
+template<typename T>
+static T findNumberOrDefault(const JsonValue* json, const JsonKey& key, size_t index, T defaultValue) {
+    if (json != nullptr) {
+        auto it = findMember(*json, key);
+        if (it != json->MemberEnd() && it->value.IsArray() && index < it->value.Size()) {
+            const auto& v = it->value[index];
+            if (v.IsNumber()) {
+                return v.Get<T>();
+            }
+        }
+    }
+    return defaultValue;
+}
+
+template<typename T>
+static bool findNumberInMap(const JsonValue* json, const JsonKey& key1, const JsonKey& key2, T& value) {
+    if (json != nullptr) {
+        auto it = findMember(*json, key1);
+        if (it != json->MemberEnd() && it->value.IsObject()) {
+            auto it2 = findMember(it->value, key2);
+            if (it2 != it->value.MemberEnd() && it2->value.IsNumber()) {
+                value = it2->value.Get<T>();
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+template<typename T>
+static std::vector<T> getNumberVector(const JsonValue* json, const JsonKey& key) {
+    std::vector<T> vec;
+    if (json != nullptr) {
+        auto it = findMember(*json, key);
+        if (it != json->MemberEnd() && it->value.IsArray()) {
+            const size_t size = it->value.Size();
+            for (size_t index = 0; index < size; ++index) {
+                const auto& v = it->value[index];
+                if (v.IsNumber()) {
+                    vec.push_back(v.Get<T>());
+                }
+            }
+        }
+    }
+    return vec;
+}
+
+template<typename T>
+static T findObject(const Gltf* gltf, const JsonValue* json, const JsonKey& key) {
+    if (json != nullptr) {
+        auto it = findMember(*json, key);
+        if (it != json->MemberEnd() && it->value.IsObject()) {
+            return T(gltf, &it->value);
+        }
+    }
+    return T();
+}
+
+template<typename T>
+static T findObject(const Gltf* gltf, const JsonValue* json, const JsonKey& key, size_t index) {
+    if (json != nullptr) {
+        auto it = findMember(*json, key);
+        if (it != json->MemberEnd() && it->value.IsArray() && index < it->value.Size()) {
+            const auto& v = it->value[index];
+            if (v.IsObject()) {
+                return T(gltf, &v);
+            }
+        }
+    }
+    return T();
+}
+
+template<typename T>
+static T findGltfObject(const Gltf* gltf, Collection collection, size_t index) {
+    const JsonValue* json = gltf->object(collection, index);
+    return json != nullptr ? T(gltf, json) : T();
+}
+
+template<typename T>
+static T findGltfObject(const Gltf* gltf, const JsonValue* json, const JsonKey& key, size_t index) {
+    if (json) {
+        const auto it = findMember(*json, key);
+        if (it != json->MemberEnd()) {
+            const auto& values = it->value;
+            if (values.IsArray() && index < values.Size()) {
+                return T(gltf, &values[index]);
+            }
+        }
+    }
+    return T();
+}
+
+/// Finds the index of a json object in one of the root arrays of the gltf document.
+/// @return True if the object was found in the array.
+static bool findGltfIndex(const Gltf* gltf, Collection collection, const JsonValue* json, size_t& index) {
+    if (gltf != nullptr && json != nullptr) {
+        const JsonValue* first = gltf->object(collection, 0);
+        if (first != nullptr && json >= first && json < first + gltf->count(collection)) {
+            index = static_cast<size_t>(json - first);
+            return true;
+        }
+    }
+    return false;
+}
+
+template<typename T>
+static std::vector<T> getObjectVector(const Gltf* gltf, const JsonValue* json, const JsonKey& key) {
+    std::vector<T> vec;
+    const auto& it = findMember(*json, key);
+    if (it != json->MemberEnd() && it->value.IsArray()) {
+        const auto size = it->value.Size();
+        vec.reserve(size);
+        for (size_t i = 0; i < size; ++i) {
+            const auto& v = it->value[i];
+            vec.emplace_back(gltf, &v);
+        }
+    }
+    return vec;
+}
+
+template<typename T>
+static std::vector<T> getObjectVector(const Gltf* gltf, Collection collection) {
+    std::vector<T> vec;
+    const size_t size = gltf->count(collection);
+    vec.reserve(size);
+    for (size_t i = 0; i < size; ++i) {
+        vec.emplace_back(gltf, gltf->object(collection, i));
+    }
+    return vec;
+}
+
+static std::vector<const char*> getKeys(const JsonValue* json, const JsonKey& key) {
+    std::vector<const char*> vec;
+    if (json != nullptr) {
+        auto it = findMember(*json, key);
+        if (it != json->MemberEnd() && it->value.IsObject()) {
+            auto& value = it->value;
+            const size_t size = value.MemberCount();
+            vec.reserve(size);
+            for (auto member = value.MemberBegin(); member != value.MemberEnd(); ++member) {
+                vec.push_back(member->name.GetString());
+            }
+        }
+    }
+    return vec;
+}
+
+static std::vector<const char*> getStrings(const JsonValue* json, const JsonKey& key) {
+    std::vector<const char*> vec;
+    if (json != nullptr) {
+        auto it = findMember(*json, key);
+        if (it != json->MemberEnd() && it->value.IsArray()) {
+            const auto size = it->value.Size();
+            vec.reserve(size);
+            for (size_t i = 0; i < size; ++i) {
+                vec.push_back(it->value[i].GetString());
+            }
+        }
+    }
+    return vec;
+}
+
+/// Copys numbers from a json element
+/// @return True if the numbers were copied.
+template<typename T>
+static bool copyNumbers(const JsonValue* json, const JsonKey& key, size_t count, T* m) noexcept {
+    if (json != nullptr && m != nullptr) {
+        auto it = findMember(*json, key);
+        if (it != json->MemberEnd() && it->value.IsArray() && count <= it->value.Size()) {
+            for (auto& v : it->value.GetArray()) {
+                *m++ = v.Get<T>();
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+/// Returns the number of bytes that base64 text decodes to. Trailing '=' padding is ignored.
+inline size_t base64DecodedSize(const char* text, size_t length) noexcept {
+    while (length > 0 && text[length - 1] == '=') {
+        --length;
+    }
+    const size_t remainder = length % 4;
+    return length / 4 * 3 + (remainder > 1 ? remainder - 1 : 0);
+}
+
+/// Maps base64 characters to their 6-bit values. Other characters map to 0xFF.
+struct Base64Table {
+    std::array<std::uint8_t, 256> values;
+    Base64Table() noexcept {
+        static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        values.fill(0xFF);
+        for (std::uint8_t i = 0; i < 64; ++i) {
+            values[static_cast<unsigned char>(alphabet[i])] = i;
+        }
+    }
+    static const Base64Table& instance() noexcept {
+        static const Base64Table table;
+        return table;
+    }
+};
+
+#if defined(LAZY_GLTF2_SSSE3)
+/// Translates 16 base64 characters to their 6-bit values.
+/// Uses the nibble lookup technique by Wojciech Mula: http://0x80.pl/notesen/2016-01-17-sse-base64-decoding.html
+/// @return False if any of the characters isn't in the base64 alphabet.
+inline bool base64Translate(__m128i& in) noexcept {
+    const __m128i lutLo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m128i lutHi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m128i lutRoll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i mask2F = _mm_set1_epi8(0x2F);
+    const __m128i hiNibbles = _mm_and_si128(_mm_srli_epi32(in, 4), mask2F);
+    const __m128i loNibbles = _mm_and_si128(in, mask2F);
+    const __m128i lo = _mm_shuffle_epi8(lutLo, loNibbles);
+    const __m128i hi = _mm_shuffle_epi8(lutHi, hiNibbles);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128())) != 0xFFFF) {
+        return false;
+    }
+    const __m128i eq2F = _mm_cmpeq_epi8(in, mask2F);
+    const __m128i roll = _mm_shuffle_epi8(lutRoll, _mm_add_epi8(eq2F, hiNibbles));
+    in = _mm_add_epi8(in, roll);
+    return true;
+}
+
+/// Packs 16 6-bit values into 12 bytes in the low 12 bytes of the result.
+inline __m128i base64Pack(__m128i values) noexcept {
+    const __m128i merged = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+    const __m128i packed = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+    return _mm_shuffle_epi8(packed, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+}
+#endif
+
+#if defined(LAZY_GLTF2_AVX2)
+/// The AVX2 version of base64Translate() for 32 characters.
+inline bool base64Translate(__m256i& in) noexcept {
+    const __m256i lutLo = _mm256_setr_epi8(
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m256i lutHi = _mm256_setr_epi8(
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m256i lutRoll = _mm256_setr_epi8(
+        0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i mask2F = _mm256_set1_epi8(0x2F);
+    const __m256i hiNibbles = _mm256_and_si256(_mm256_srli_epi32(in, 4), mask2F);
+    const __m256i loNibbles = _mm256_and_si256(in, mask2F);
+    const __m256i lo = _mm256_shuffle_epi8(lutLo, loNibbles);
+    const __m256i hi = _mm256_shuffle_epi8(lutHi, hiNibbles);
+    if (!_mm256_testz_si256(lo, hi)) {
+        return false;
+    }
+    const __m256i eq2F = _mm256_cmpeq_epi8(in, mask2F);
+    const __m256i roll = _mm256_shuffle_epi8(lutRoll, _mm256_add_epi8(eq2F, hiNibbles));
+    in = _mm256_add_epi8(in, roll);
+    return true;
+}
+
+/// Packs 32 6-bit values into 24 bytes in the low 24 bytes of the result.
+inline __m256i base64Pack(__m256i values) noexcept {
+    const __m256i merged = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+    const __m256i packed = _mm256_madd_epi16(merged, _mm256_set1_epi32(0x00011000));
+    const __m256i shuffled = _mm256_shuffle_epi8(packed, _mm256_setr_epi8(
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+    return _mm256_permutevar8x32_epi32(shuffled, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+}
+#endif
+
+/// Decodes base64 text using SSSE3 or AVX2 when they are enabled at compile time.
+/// The text must only contain base64 characters and optional '=' padding at the end.
+/// @param[in]  text   The base64 text to decode.
+/// @param[in]  length The number of characters in text.
+/// @param[out] out    Array of at least base64DecodedSize(text, length) bytes.
+/// @return True if the text was decoded; false if it contains a character that isn't base64.
+inline bool decodeBase64(const char* text, size_t length, unsigned char* out) noexcept {
+    while (length > 0 && text[length - 1] == '=') {
+        --length;
+    }
+    if (length % 4 == 1) {
+        return false;
+    }
+    size_t i = 0;
+    // The SIMD loops store more bytes than they decode so they stop early enough to stay inside out.
+#if defined(LAZY_GLTF2_AVX2)
+    for (; i + 48 <= length; i += 32) {
+        __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i));
+        if (!base64Translate(in)) {
+            return false;
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), base64Pack(in));
+        out += 24;
+    }
+#endif
+#if defined(LAZY_GLTF2_SSSE3)
+    for (; i + 24 <= length; i += 16) {
+        __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+        if (!base64Translate(in)) {
+            return false;
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), base64Pack(in));
+        out += 12;
+    }
+#endif
+    const auto& table = Base64Table::instance().values;
+    for (; i + 4 <= length; i += 4) {
+        const std::uint32_t a = table[static_cast<unsigned char>(text[i])];
+        const std::uint32_t b = table[static_cast<unsigned char>(text[i + 1])];
+        const std::uint32_t c = table[static_cast<unsigned char>(text[i + 2])];
+        const std::uint32_t d = table[static_cast<unsigned char>(text[i + 3])];
+        if ((a | b | c | d) & 0x80) {
+            return false;
+        }
+        const std::uint32_t bits = a << 18 | b << 12 | c << 6 | d;
+        out[0] = static_cast<unsigned char>(bits >> 16);
+        out[1] = static_cast<unsigned char>(bits >> 8);
+        out[2] = static_cast<unsigned char>(bits);
+        out += 3;
+    }
+    const size_t remainder = length - i;
+    if (remainder > 0) {
+        std::uint32_t bits = 0;
+        for (size_t j = 0; j < remainder; ++j) {
+            const std::uint32_t value = table[static_cast<unsigned char>(text[i + j])];
+            if (value & 0x80) {
+                return false;
+            }
+            bits |= value << (18 - 6 * j);
+        }
+        out[0] = static_cast<unsigned char>(bits >> 16);
+        if (remainder == 3) {
+            out[1] = static_cast<unsigned char>(bits >> 8);
+        }
+    }
+    return true;
+}
+
+/// Calls f(index) for every index in [0, count) using up to threadCount threads, including the calling thread.
+/// If a thread can't be created then the remaining work is done by the threads that were created,
+/// so this only throws if f throws.
+template<typename F>
+void parallelFor(size_t count, size_t threadCount, F f) {
+    if (threadCount <= 1 || count <= 1) {
+        for (size_t i = 0; i < count; ++i) {
+            f(i);
+        }
+        return;
+    }
+    threadCount = std::min(threadCount, count);
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t i = next++; i < count; i = next++) {
+            f(i);
+        }
+    };
+    std::vector<std::thread> threads;
+    try {
+        threads.reserve(threadCount - 1);
+        for (size_t i = 1; i < threadCount; ++i) {
+            threads.emplace_back(worker);
+        }
+    }
+    catch (const std::exception&) {
+        // out of threads or memory, use the threads that were created
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+/// Decodes base64 text in chunks on up to threadCount threads.
+/// The chunks start on 4 character boundaries so each thread writes to its own range of out.
+/// @see decodeBase64(const char*, size_t, unsigned char*)
+inline bool decodeBase64(const char* text, size_t length, unsigned char* out, size_t threadCount) noexcept {
+    if (threadCount <= 1) {
+        return decodeBase64(text, length, out);
+    }
+    // round the chunk size up to a multiple of 4 characters
+    const size_t chunkLength = ((length + threadCount - 1) / threadCount + 3) & ~size_t(3);
+    const size_t chunkCount = (length + chunkLength - 1) / chunkLength;
+    std::atomic<bool> valid(true);
+    parallelFor(chunkCount, threadCount, [&](size_t chunk) {
+        const size_t begin = chunk * chunkLength;
+        const size_t end = std::min(length, begin + chunkLength);
+        // only the last chunk may have padding
+        if (end != length && text[end - 1] == '=') {
+            valid = false;
+        }
+        else if (!decodeBase64(text + begin, end - begin, out + begin / 4 * 3)) {
+            valid = false;
+        }
+    });
+    return valid;
+}
+
+/// Decodes a base64 string.
+/// The data is decoded straight into an exactly sized vector with decodeBase64().
+/// Text that contains other characters, like line breaks, is decoded by libb64 which skips them.
+/// @param[in]  text       The base64 text to decode.
+/// @param[in]  byteLength  The expected number of bytes to read. Only used as a hint.
+/// @param[out] data        The vector to copy the data to.
+/// @param[in]  threadCount The maximum number of threads used to decode large text.
+///                         Each thread decodes at least BASE64_MIN_CHUNK_LENGTH characters.
+/// @return True if the base64 text was decoded successfully; false otherwise.
+template<typename T>
+bool readBase64(const char* text, size_t byteLength, std::vector<T>& data, size_t threadCount = 1) {
+    static_assert(sizeof(T) == 1, "vector type must be 1 byte (like char or unsigned char)");
+    if (text == nullptr) {
+        return false;
+    }
+    const size_t length = strlen(text);
+    data.resize(base64DecodedSize(text, length));
+    threadCount = std::max<size_t>(1, std::min(threadCount, length / BASE64_MIN_CHUNK_LENGTH));
+    if (decodeBase64(text, length, reinterpret_cast<unsigned char*>(data.data()), threadCount)) {
+        return true;
+    }
+    // libb64 writes at most 3 bytes for every 4 characters and touches the byte after the last one
+    data.resize(std::max(byteLength, (length + 3) / 4 * 3) + 1);
+    lib64::base64_decodestate state;
+    lib64::base64_init_decodestate(&state);
+    const int decoded = lib64::base64_decode_block(text, static_cast<int>(length), reinterpret_cast<char*>(data.data()), &state);
+    data.resize(static_cast<size_t>(decoded));
+    return true;
+}
+
+/// Reads a binary file using the given file system and copies the data to the given vector.
+/// @see readBinaryFile(const char*, size_t, std::vector<T>&)
+template<typename T>
+bool readBinaryFile(FileSystem& fileSystem, const char* path, size_t byteLength, std::vector<T>& data) {
+    const auto file = fileSystem.open(path);
+    if (!file) {
+        return false;
+    }
+    data.resize(byteLength);
+    if (file->read(0, data.data(), byteLength) == byteLength) {
+        return true;
+    }
+    return false;
+}
+
+/// Reads a binary file and copies the data to the given vector.
+/// @param[in]  path       The path to the file.
+/// @param[in]  byteLength The number of bytes to read.
+/// @param[out] data       The vector to copy the data to.
+/// @retrun True if the file was loaded successfully; false otherwise.
+template<typename T>
+bool readBinaryFile(const char* path, size_t byteLength, std::vector<T>& data) {
+    return readBinaryFile(*StdFileSystem::instance(), path, byteLength, data);
+}
+
+/// Moves bytes into data if the types match; otherwise copies them.
+inline void assignBytes(std::vector<unsigned char>&& bytes, std::vector<unsigned char>& data) {
+    data = std::move(bytes);
+}
+
+template<typename T>
+void assignBytes(std::vector<unsigned char>&& bytes, std::vector<T>& data) {
+    data.assign(bytes.begin(), bytes.end());
+}
+
+/// Base class for GLTF objects.
+class Object {
+public:
+    Object() : m_gltf(nullptr), m_json(nullptr) {}
+    Object(const Gltf* gltf, const JsonValue* json) : m_gltf(gltf), m_json(json) {}
+    virtual ~Object() = default;
+    bool isNull() const noexcept { return m_gltf == nullptr; }
+    /// Returns true if this Object is not null. (Meaning it is usable)
+    operator bool() const noexcept { return m_gltf != nullptr; }
+
+    /// Returns a string property from this GLTF object.
+    /// The string returned by the method will become invalid when the json document is unloaded
+    /// make a copy if you need it long term.
+    /// @param key The key of the property.
+    /// @return The string or null if not found.
+    const char* str(const char* key) const noexcept {
+        return str(JsonKey(key));
+    }
+    /// @see str(const char*)
+    const char* str(const JsonKey& key) const noexcept {
+        if (m_json != nullptr && key.c_str() != nullptr) {
+            auto it = findMember(*m_json, key);
+            if (it != m_json->MemberEnd() && it->value.IsString()) {
+                return it->value.GetString();
+            }
+        }
+        return nullptr;
+    }
+    friend bool operator==(const Object& lhs, const Object& rhs);
+protected:
+    /// Returns the size of an array or the number of members in an object.
+    size_t count(const JsonKey& key) const noexcept {
+        if (m_json != nullptr) {
+            auto it = findMember(*m_json, key);
+            if (it != m_json->MemberEnd()) {
+                if (it->value.IsArray()) {
+                    return it->value.Size();
+                }
+                else if (it->value.MemberCount()) {
+                    return it->value.MemberCount();
+                }
+            }
+        }
+        return 0;
+    }
+    bool copyFloats(const JsonKey& key, size_t count, float* m) const noexcept {
+        // TODO remove and replace with tempalte?
+        if (m_json != nullptr && m != nullptr) {
+            auto it = findMember(*m_json, key);
+            if (it != m_json->MemberEnd() && it->value.IsArray() && count <= it->value.Size()) {
+                for (auto& v : it->value.GetArray()) {
+                    *m++ = v.GetFloat();
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// Returns the compiled tables and the index of this object in a top level array if the Gltf was compiled.
+    const CompiledGltf* compiled(Collection collection, size_t& index) const noexcept {
+        const CompiledGltf* tables = m_gltf != nullptr ? m_gltf->compiled() : nullptr;
+        return tables != nullptr && findGltfIndex(m_gltf, collection, m_json, index) ? tables : nullptr;
+    }
+    /// Copies count floats of element index from a compiled table.
+    static bool copyFloats(bool present, const std::vector<float>& values, size_t index, size_t count, float* m) noexcept {
+        if (present && m != nullptr) {
+            std::copy(&values[index * count], &values[index * count] + count, m);
+            return true;
+        }
+        return false;
+    }
+    /// Reads an index from a compiled table.
+    static bool compiledIndex(std::uint32_t value, size_t& index) noexcept {
+        if (value != CompiledGltf::NONE) {
+            index = value;
+            return true;
+        }
+        return false;
+    }
+
+    float findFloat(const JsonKey& key, float defaultValue = 0.0f) const noexcept {
+        if (m_json != nullptr) {
+            auto it = findMember(*m_json, key);
+            if (it != m_json->MemberEnd() && it->value.IsNumber()) {
+                return it->value.GetFloat();
+            }
+        }
+        return defaultValue;
+    }
+
+    bool findBool(const JsonKey& key, bool defaultValue = false) const noexcept {
+        if (m_json != nullptr) {
+            auto it = findMember(*m_json, key);
+            if (it != m_json->MemberEnd() && it->value.IsBool()) {
+                return it->value.GetBool();
+            }
+        }
+        return defaultValue;
+    }
+
+    const Gltf* m_gltf;
+    const JsonValue* m_json;
+};
+
+inline bool operator==(const Object& lhs, const Object& rhs) {
+    return lhs.m_gltf == rhs.m_gltf && lhs.m_json == rhs.m_json;
+}
+inline bool operator!=(const Object& lhs, const Object& rhs) {
+    return !(lhs == rhs);
+}
+inline bool operator==(const Object& lhs, std::nullptr_t) noexcept {
+    return !lhs;
+}
+inline bool operator==(std::nullptr_t, const Object& rhs) noexcept {
+    return !rhs;
+}
+inline bool operator!=(const Object& lhs, std::nullptr_t) noexcept {
+    return lhs;
+}
+inline bool operator!=(std::nullptr_t, const Object& rhs) noexcept {
+    return rhs;
+}
+
+/// A gltf object that has a string name.
+class Named : public Object {
+public:
+    Named() {}
+    Named(const Gltf* gltf, const JsonValue* json) : Object(gltf, json) {}
+    const char* name() const noexcept {
+        return str("name");
+    }
+};
+
+/// Orthographic camera
+class Orthographic : public Object {
+public:
+    Orthographic() {}
+    Orthographic(const Gltf* gltf, const JsonValue* json) : Object(gltf, json) {}
+
+    float xmag() const noexcept {
+        return findFloat("xmag");
+    }
+    float ymag() const noexcept {
+        return findFloat("ymag");
+    }
+    float zfar() const noexcept {
+        return findFloat("zfar");
+    }
+    float znear() const noexcept {
+        return findFloat("znear");
+    }
+};
+
+/// Perspective camera
+class Perspective : public Object {
+public:
+    Perspective() {}
+    Perspective(const Gltf* gltf, const JsonValue* json) : Object(gltf, json) {}
+
+    float aspectRatio() const noexcept {
+        return findFloat("aspectRatio", DEFAULT_ASPECT_RATIO);
+    }
+
+    float yfov() const noexcept {
+        return findFloat("yfov");
+    }
+
+    float zfar() const noexcept {
+        return findFloat("zfar");
+    }
+
+    float znear() const noexcept {
+        return findFloat("znear");
+    }
+};
+
+class Camera : public Named {
+public:
+    Camera() {}
+    Camera(const Gltf* gltf, const JsonValue* json) : Named(gltf, json) {}
+
+    enum class Type {
+        ORTHOGRAPHIC,
+        PERSPECTIVE
+    };
+
+    Type type() const noexcept {
+        if (m_json != nullptr) {
+            auto it = findMember(*m_json, "type");
+            if (it != m_json->MemberEnd() && it->value.IsString()) {
+                const char* str = it->value.GetString();
+                return strcmp(str, "orthographic") == 0 ? Type::ORTHOGRAPHIC : Type::PERSPECTIVE;
+            }
+        }
+        return Type::PERSPECTIVE;
+    }
+
+    Orthographic orthographic() const noexcept {
+        return findObject<Orthographic>(m_gltf, m_json, "orthographic");
+    }
+
+    Perspective perspective() const noexcept {
+        return findObject<Perspective>(m_gltf, m_json, "perspective");
+    }
+};
+
+/// A node in the node hierarchy.
+class Node : public Named {
+public:
+    Node() {};
+    Node(const Gltf* gltf, const JsonValue* json) : Named(gltf, json) {}
+
+    Node operator[](size_t index) const noexcept {
+        return child(index);
+    }
+    Node child(size_t index) const noexcept {
+        size_t value;
+        if (const CompiledGltf* tables = compiled(Collection::NODES, value)) {
+            const auto& offsets = tables->nodes.childOffsets;
+            if (index < offsets[value + 1] - offsets[value]) {
+                return m_gltf->node(tables->nodes.children[offsets[value] + index]);
+            }
+            return Node();
+        }
+        if (findNumber(m_json, "children", index, value)) {
+            return m_gltf->node(value);
+        }
+        return Node();
+    }
+    Node node(size_t index) const noexcept {
+        return child(index);
+    }
+    size_t childCount() const noexcept {
+        size_t i;
+        if (const CompiledGltf* tables = compiled(Collection::NODES, i)) {
+            return tables->nodes.childOffsets[i + 1] - tables->nodes.childOffsets[i];
+        }
+        return count("children");
+    }
+    std::vector<size_t> children() const noexcept {
+        return getNumberVector<size_t>(m_json, "children");
+    }
+    std::vector<size_t> nodes() const noexcept {
+        return children();
+    }
+    /// Returns the parent of this node from Gltf::hierarchy() or an empty node if this is a root node.
+    Node parent() const;
+    bool parent(size_t& index) const;
+
+    bool matrix(float* m) const noexcept {
+        size_t i;
+        if (const CompiledGltf* tables = compiled(Collection::NODES, i)) {
+            const auto& nodes = tables->nodes;
+            return copyFloats((nodes.flags[i] & CompiledGltf::Nodes::HAS_MATRIX) != 0, nodes.matrix, i, 16, m);
+        }
+        return copyFloats("matrix", 16, m);
+    }
+    bool translation(float* m) const noexcept {
+        size_t i;
+        if (const CompiledGltf* tables = compiled(Collection::NODES, i)) {
+            const auto& nodes = tables->nodes;
+            return copyFloats((nodes.flags[i] & CompiledGltf::Nodes::HAS_TRANSLATION) != 0, nodes.translation, i, 3, m);
+        }
+        return copyFloats("translation", 3, m);
+    }
+    bool rotation(float* m) const noexcept {
+        size_t i;
+        if (const CompiledGltf* tables = compiled(Collection::NODES, i)) {
+            const auto& nodes = tables->nodes;
+            return copyFloats((nodes.flags[i] & CompiledGltf::Nodes::HAS_ROTATION) != 0, nodes.rotation, i, 4, m);
+        }
+        return copyFloats("rotation", 4, m);
+    }
+    bool scale(float* m) const noexcept {
+        size_t i;
+        if (const CompiledGltf* tables = compiled(Collection::NODES, i)) {
+            const auto& nodes = tables->nodes;
+            return copyFloats((nodes.flags[i] & CompiledGltf::Nodes::HAS_SCALE) != 0, nodes.scale, i, 3, m);
+        }
+        return copyFloats("scale", 3, m);
+    }
+
+    bool weight(float* p, size_t count) const noexcept {
+        return copyFloats("weights", count, p);
+    }
+    float weight(size_t index) const noexcept {
+        return findNumberOrDefault(m_json, "weights", index, 0.0f);
+    }
+    size_t weightCount() const noexcept {
+        return count("weights");
+    }
+
+    Mesh mesh() const noexcept;
+    bool mesh(size_t& index) const noexcept {
+        size_t i;
+        if (const CompiledGltf* tables = compiled(Collection::NODES, i)) {
+            return compiledIndex(tables->nodes.mesh[i], index);
+        }
+        return findNumber(m_json, "mesh", index);
+    }
+
+    Camera camera() const noexcept;
+    bool camera(size_t& index) const noexcept {
+        size_t i;
+        if (const CompiledGltf* tables = compiled(Collection::NODES, i)) {
+            return compiledIndex(tables->nodes.camera[i], index);
+        }
+        return findNumber(m_json, "camera", index);
+    }
+
+    Skin skin() const noexcept;
+    bool skin(size_t& index) const noexcept {
+        size_t i;
+        if (const CompiledGltf* tables = compiled(Collection::NODES, i)) {
+            return compiledIndex(tables->nodes.skin[i], index);
+        }
+        return findNumber(m_json, "skin", index);
+    }
+};
+
+/// The root nodes of a scene.
+class Scene : public Named {
+public:
+    Scene() {};
+    Scene(const Gltf* gltf, const JsonValue* json) : Named(gltf, json) {}
+
+    Node operator[](size_t index) const noexcept {
+        return node(index);
+    }
+
+    Node node(size_t index) const noexcept {
+        size_t value;
+        if (findNumber(m_json, "nodes", index, value)) {
+            return m_gltf->node(value);
+        }
+        return Node();
+    }
+
+    size_t nodeCount() const noexcept {
+        return count("nodes");
+    }
+
+    std::vector<size_t> nodes() const noexcept {
+        return getNumberVector<size_t>(m_json, "nodes");
+    }
+};
+
+class Buffer : public Named {
+public:
+    Buffer() {}
+    Buffer(const Gltf* gltf, const JsonValue* json) : Named(gltf, json) {}
+
+    /// Returns the uri string. May be null because GLB buffers don't have a uri.
+    const char* uri() const noexcept {
+        return str("uri");
+    }
+    size_t byteLength() const noexcept {
+        return findNumberOrDefault<size_t>(m_json, "byteLength", 0);
+    }
+
+    /// Loads data from the buffer.
+    /// This copies the data every time it is called. Use data() to share one copy that is owned by the Gltf.
+    /// @param[in] data The vector to load the data into. It will be resized to byteLength().
+    /// @return True if the buffer was loaded successfully; false otherwise.
+    template<typename T>
+    bool load(std::vector<T>& data) const noexcept;
+
+    /// Returns a view of the buffer's bytes.
+    /// The buffer is loaded at most once per Gltf (see Gltf::bufferData) and memory mapped GLB
+    /// buffers (see Gltf::setMemoryMapping) are not copied at all.
+    /// @return The view or an empty view if the buffer could not be loaded.
+    DataView data() const noexcept;
+};
+
+/// A view into a buffer generally representing a subset of the buffer.
+class BufferView : public Named {
+public:
+    BufferView() {}
+    BufferView(const Gltf* gltf, const JsonValue* json) : Named(gltf, json) {}
+
+    enum Target {
+        ARRAY_BUFFER = 34962,
+        ELEMENT_ARRAY_BUFFER = 34963,
+        UNKNOWN = 0
+    };
+
+    Buffer buffer() const noexcept {
+        size_t num;
+        if (buffer(num)) {
+            return m_gltf->buffer(num);
+        }
+        return Buffer();
+    }
+    bool buffer(size_t& index) const noexcept {
+        size_t i;
+        if (const CompiledGltf* tables = compiled(Collection::BUFFER_VIEWS, i)) {
+            return compiledIndex(tables->bufferViews.buffer[i], index);
+        }
+        return findNumber(m_json, "buffer", index);
+    }
+    size_t byteOffset() const noexcept {
+        size_t i;
+        if (const CompiledGltf* tables = compiled(Collection::BUFFER_VIEWS, i)) {
+            return tables->bufferViews.byteOffset[i];
+        }
+        return findNumberOrDefault(m_json, "byteOffset", 0);
+    }
+    size_t byteLength() const noexcept {
+        size_t i;
+        if (const CompiledGltf* tables = compiled(Collection::BUFFER_VIEWS, i)) {
+            return tables->bufferViews.byteLength[i];
+        }
+        return findNumberOrDefault(m_json, "byteLength", 1);
+    }
+    size_t byteStride() const noexcept {
+        size_t i;
+        if (const CompiledGltf* tables = compiled(Collection::BUFFER_VIEWS, i)) {
+            return tables->bufferViews.byteStride[i];
+        }
+        return findNumberOrDefault(m_json, "byteStride", 0);
+    }
+
+    Target target() const noexcept {
+        int num;
+        if (findNumber<int>(m_json, "target", num)) {
+            switch (num) {
+            case GLValue::ELEMENT_ARRAY_BUFFER:
+                return Target::ELEMENT_ARRAY_BUFFER;
+            case GLValue::ARRAY_BUFFER:
+                return Target::ARRAY_BUFFER;
+            }
+        }
+        return Target::UNKNOWN;
+    }
+
+    bool target(int& value) const noexcept {
+        return findNumber<int>(m_json, "target", value);
+    }
+
+    /// Returns a view of the bytes of this BufferView without copying them.
+    /// The view's byteStride() is the same as this BufferView's byteStride().
+    /// An empty view is returned if the buffer can't be loaded (see Buffer::data()) or the range is out of bounds.
+    DataView data() const noexcept {
+        const DataView bufferData = buffer().data();
+        const size_t offset = byteOffset();
+        const size_t length = byteLength();
+        if (!bufferData || offset > bufferData.byteLength() || length > bufferData.byteLength() - offset) {
+            return DataView();
+        }
+        return DataView(bufferData.data() + offset, length, byteStride());
+    }
+};
+
+class SparseValues : public Object {
+public:
+    SparseValues() {}
+    SparseValues(const Gltf* gltf, const JsonValue* json) : Object(gltf, json) {}
+
+    BufferView bufferView() const noexcept {
+        size_t index;
+        if (findNumber(m_json, "bufferView", index)) {
+            return m_gltf->bufferView(index);
+        }
+        return BufferView();
+    }
+
+    size_t byteOffset() const noexcept {
+        return findNumberOrDefault(m_json, "byteOffset", 0);
+    }
+};
+
+class SparseIndices : public Object {
+public:
+    SparseIndices() {}
+    SparseIndices(const Gltf* gltf, const JsonValue* json) : Object(gltf, json) {}
+
+    enum class ComponentType {
+        UNSIGNED_BYTE = 5121,
+        UNSIGNED_SHORT = 5123,
+        UNSIGNED_INT = 5125
+    };
+
+    BufferView bufferView() const noexcept {
+        size_t index;
+        if (findNumber(m_json, "bufferView", index)) {
+            return m_gltf->bufferView(index);
+        }
+        return BufferView();
+    }
+
+    size_t byteOffset() const noexcept {
+        return findNumberOrDefault(m_json, "byteOffset", 0);
+    }
+
+    ComponentType componentType() const noexcept {
+        int num;
+        if (findNumber<int>(m_json, "componentType", num)) {
+            switch (num) {
+            case GLValue::UNSIGNED_BYTE: return ComponentType::UNSIGNED_BYTE;
+            case GLValue::UNSIGNED_SHORT: return ComponentType::UNSIGNED_SHORT;
+            case GLValue::UNSIGNED_INT: return ComponentType::UNSIGNED_INT;
+            }
+        }
+        return ComponentType::UNSIGNED_INT;
+    }
+};
+
+class Sparse : public Object {
+public:
+    Sparse() {}
+    Sparse(const Gltf* gltf, const JsonValue* json) : Object(gltf, json) {}
+
+    size_t count() const noexcept {
+        return findNumberOrDefault<size_t>(m_json, "count", 1);
+    }
+
+    SparseIndices indices() const noexcept {
+        return findObject<SparseIndices>(m_gltf, m_json, "indices");
+    }
+
+    SparseValues values() const noexcept {
+        return findObject<SparseValues>(m_gltf, m_json, "values");
+    }
+};
+
+struct AccessorLayout;
+
+class Accessor : public Named {
+public:
+    Accessor() {}
+    Accessor(const Gltf* gltf, const JsonValue* json) : Named(gltf, json) {}
+
+    enum class Type {
+        SCALAR,
+        VEC2,
+        VEC3,
+        VEC4,
+        MAT2,
+        MAT3,
+        MAT4
+    };
+
+    enum class ComponentType {
+        BYTE = 5120,
+        UNSIGNED_BYTE = 5121,
+        SHORT = 5122,
+        UNSIGNED_SHORT = 5123,
+        UNSIGNED_INT = 5125,
+        FLOAT = 5126
+    };
+
+    Type type() const noexcept {
+        size_t i;
+        if (const CompiledGltf* tables = compiled(Collection::ACCESSORS, i)) {
+            return static_cast<Type>(tables->accessors.type[i]);
+        }
+        const char* s = str("type");
+        if (s != nullptr) {
+            switch (*s) {
+            case 'S':
+                return Accessor::Type::SCALAR;
+            case 'V':
+                switch (s[3]) {
+                case '2': return Accessor::Type::VEC2;
+                case '3': return Accessor::Type::VEC3;
+                case '4': return Accessor::Type::VEC4;
+                }
+                break;
+            case 'M':
+                switch (s[3]) {
+                case '2': return Accessor::Type::MAT2;
+                case '3': return Accessor::Type::MAT3;
+                case '4': return Accessor::Type::MAT4;
+                }
+            }
+        }
+        return Accessor::Type::SCALAR;
+    }
+    BufferView bufferView() const noexcept {
+        size_t num;
+        if (bufferView(num)) {
+            return m_gltf->bufferView(num);
+        }
+        return BufferView();
+    }
+    bool bufferView(size_t& index) const noexcept {
+        size_t i;
+        if (const CompiledGltf* tables = compiled(Collection::ACCESSORS, i)) {
+            return compiledIndex(tables->accessors.bufferView[i], index);
+        }
+        return findNumber<size_t>(m_json, "bufferView", index);
+    }
+    size_t byteOffset() const noexcept {
+        size_t i;
+        if (const CompiledGltf* tables = compiled(Collection::ACCESSORS, i)) {
+            return tables->accessors.byteOffset[i];
+        }
+        return findNumberOrDefault<size_t>(m_json, "byteOffset", 0);
+    }
+    ComponentType componentType() const noexcept {
+        size_t i;
+        if (const CompiledGltf* tables = compiled(Collection::ACCESSORS, i)) {
+            return static_cast<ComponentType>(tables->accessors.componentType[i]);
+        }
+        int num;
+        if (findNumber<int>(m_json, "componentType", num)) {
+            switch (num) {
+            case GLValue::BYTE: return ComponentType::BYTE;
+            case GLValue::UNSIGNED_BYTE: return ComponentType::UNSIGNED_BYTE;
+            case GLValue::SHORT: return ComponentType::SHORT;
+            case GLValue::UNSIGNED_SHORT: return ComponentType::UNSIGNED_SHORT;
+            case GLValue::UNSIGNED_INT: return ComponentType::UNSIGNED_INT;
+            case GLValue::FLOAT: return ComponentType::FLOAT;
+            }
+        }
+        return ComponentType::FLOAT;
+    }
+    bool normalized() const noexcept {
+        size_t i;
+        if (const CompiledGltf* tables = compiled(Collection::ACCESSORS, i)) {
+            return tables->accessors.normalized[i] != 0;
+        }
+        return findBool("normalized");
+    }
+    size_t count() const noexcept {
+        size_t i;
+        if (const CompiledGltf* tables = compiled(Collection::ACCESSORS, i)) {
+            return tables->accessors.count[i];
+        }
+        return findNumberOrDefault<size_t>(m_json, "count", 0);
+    }
+    bool max(float* p, size_t count) const noexcept {
+        return copyFloats("max", count, p);
+    }
+    float max(size_t index) const noexcept {
+        return findNumberOrDefault(m_json, "max", index, 0.0f);
+    }
+    std::vector<float> max() const noexcept {
+        return getNumberVector<float>(m_json, "max");
+    }
+    size_t maxCount() const noexcept {
+        return Object::count("max");
+    }
+    bool min(float* p, size_t count) const noexcept {
+        return copyFloats("min", count, p);
+    }
+    float min(size_t index) const noexcept {
+        return findNumberOrDefault(m_json, "min", index, 0.0f);
+    }
+    std::vector<float> min() const noexcept {
+        return getNumberVector<float>(m_json, "min");
+    }
+    size_t minCount() const noexcept {
+        return Object::count("min");
+    }
+    Sparse sparse() const noexcept {
+        return findObject<Sparse>(m_gltf, m_json, "sparse");
+    }
+
+    /// Reads the elements of this accessor, converting each component to T.
+    /// byteOffset(), the BufferView's byteStride() and the column padding of matrices are handled.
+    /// If normalized() is true and T is a floating point type then integer components are converted to
+    /// [0, 1] or [-1, 1]. An accessor without a bufferView reads as zeros.
+    /// If the accessor is sparse then the sparse values are written over the base values.
+    /// @param[out] out Array of at least count() * numberOfComponents(type()) values.
+    /// @return True if the data was read; false if the buffer could not be loaded or is too small.
+    template<typename T>
+    bool read(T* out) const noexcept;
+
+    /// Reads the elements of this accessor, converting each component to T.
+    /// @param[out] out The vector to read into. It will be resized to count() * numberOfComponents(type()).
+    /// @return True if the data was read.
+    template<typename T>
+    bool read(std::vector<T>& out) const noexcept;
+
+    /// Reads only the sparse values of this accessor without the base values,
+    /// such as the deltas of a sparse morph target.
+    /// @param[out] indices The indices of the elements that are replaced.
+    /// @param[out] values  indices.size() * numberOfComponents(type()) values, converted to T.
+    /// @return True if this accessor is sparse and the data was read.
+    template<typename T>
+    bool readSparse(std::vector<std::uint32_t>& indices, std::vector<T>& values) const noexcept;
+private:
+    template<typename T>
+    bool readSparseValues(std::vector<T>& values, AccessorLayout& layout,
+                          SparseIndices::ComponentType& indexType, const unsigned char*& indexData) const noexcept;
+    /// Writes the sparse values over the elements in out.
+    template<typename T>
+    bool applySparse(T* out) const noexcept;
+};
+
+class Asset : public Object {
+    friend Gltf;
+public:
+    Asset() {};
+    const char* copyright() const noexcept {
+        return str("copyright");
+    }
+    const char* generator() const noexcept {
+        return str("generator");
+    }
+    const char* version() const noexcept {
+        return str("version");
+    }
+    const char* minVersion() const noexcept {
+        return str("minVersion");
+    }
+private:
+    Asset(const Gltf* gltf, const JsonValue* json) : Object(gltf, json) {}
+};
+
+class Image : public Named {
+public:
+    Image() {}
+    Image(const Gltf* gltf, const JsonValue* json) : Named(gltf, json) {}
+
+    const char* uri() const noexcept {
+        return str("uri");
+    }
+    const char* mimeType() const noexcept {
+        return str("mimeType");
+    }
+    BufferView bufferView() const noexcept {
+        size_t num;
+        if (findNumber(m_json, "bufferView", num)) {
+            return m_gltf->bufferView(num);
+        }
+        return BufferView();
+    }
+    bool bufferView(size_t& index) const noexcept {
+        return findNumber(m_json, "bufferView", index);
+    }
+    bool isBase64() const {
+        const char* s = uri();
+        return startsWith(s, LAZY_GLTF2_DATA_IMAGE_JPG) || startsWith(s, LAZY_GLTF2_DATA_IMAGE_PNG);
+    }
+    template<typename T>
+    bool loadBase64(std::vector<T>& data) const;
+};
+
+/// Texture sampler
+class Sampler : public Named {
+public:
+    Sampler() {}
+    Sampler(const Gltf* gltf, const JsonValue* json) : Named(gltf, json) {}
+
+    enum class Wrap {
+        REPEAT = 10497,
+        CLAMP_TO_EDGE = 33071,
+        MIRRORED_REPEAT = 33648
+    };
+
+    enum class MinFilter {
+        NEAREST = 9728,
+        LINEAR = 9729,
+        NEAREST_MIPMAP_NEAREST = 9984,
+        LINEAR_MIPMAP_NEAREST = 9985,
+        NEAREST_MIPMAP_LINEAR = 9986,
+        LINEAR_MIPMAP_LINEAR = 9987
+    };
+
+    enum class MagFilter {
+        NEAREST = 9728,
+        LINEAR = 9729
+    };
+
+    MagFilter magFilter() const noexcept {
+        size_t i;
+        if (const CompiledGltf* tables = compiled(Collection::SAMPLERS, i)) {
+            return static_cast<MagFilter>(tables->samplers.magFilter[i]);
+        }
+        int num;
+        if (findNumber(m_json, "magFilter", num)) {
+            if (num == GLValue::NEAREST) {
+                return MagFilter::NEAREST;
+            }
+        }
+        return MagFilter::LINEAR;
+    }
+    MinFilter minFilter() const noexcept {
+        size_t i;
+        if (const CompiledGltf* tables = compiled(Collection::SAMPLERS, i)) {
+            return static_cast<MinFilter>(tables->samplers.minFilter[i]);
+        }
+        int num;
+        if (findNumber(m_json, "minFilter", num)) {
+            switch (num) {
+            case GLValue::NEAREST: return MinFilter::NEAREST;
+            case GLValue::LINEAR: return MinFilter::LINEAR;
+            case GLValue::NEAREST_MIPMAP_NEAREST: return MinFilter::NEAREST_MIPMAP_NEAREST;
+            case GLValue::LINEAR_MIPMAP_NEAREST: return MinFilter::LINEAR_MIPMAP_NEAREST;
+            case GLValue::NEAREST_MIPMAP_LINEAR: return MinFilter::NEAREST_MIPMAP_LINEAR;
+            case GLValue::LINEAR_MIPMAP_LINEAR: return MinFilter::LINEAR_MIPMAP_LINEAR;
+            }
+        }
+        return MinFilter::LINEAR_MIPMAP_LINEAR;
+    }
+    Wrap wrapS() const noexcept {
+        size_t i;
+        if (const CompiledGltf* tables = compiled(Collection::SAMPLERS, i)) {
+            return static_cast<Wrap>(tables->samplers.wrapS[i]);
+        }
+        int num;
+        if (findNumber(m_json, "wrapS", num)) {
+            switch (num) {
+            case GLValue::CLAMP_TO_EDGE: return Wrap::CLAMP_TO_EDGE;
+            case GLValue::MIRRORED_REPEAT: return Wrap::MIRRORED_REPEAT;
+            case GLValue::REPEAT: return Wrap::REPEAT;
+            }
+        }
+        return Wrap::REPEAT;
     }
-    float znear() const noexcept {
-        return findFloat("znear");
+    Wrap wrapT() const noexcept {
+        size_t i;
+        if (const CompiledGltf* tables = compiled(Collection::SAMPLERS, i)) {
+            return static_cast<Wrap>(tables->samplers.wrapT[i]);
+        }
+        int num;
+        if (findNumber(m_json, "wrapT", num)) {
+            switch (num) {
+            case GLValue::CLAMP_TO_EDGE: return Wrap::CLAMP_TO_EDGE;
+            case GLValue::MIRRORED_REPEAT: return Wrap::MIRRORED_REPEAT;
+            case GLValue::REPEAT: return Wrap::REPEAT;
+            }
+        }
+        return Wrap::REPEAT;
     }
 };
 
-/// Perspective camera
-class Perspective : public Object {
+class Texture : public Named {
 public:
-    Perspective() {}
-    Perspective(const Gltf* gltf, const JsonValue* json) : Object(gltf, json) {}
-
-    float aspectRatio() const noexcept {
-        return findFloat("aspectRatio", DEFAULT_ASPECT_RATIO);
-    }
-
-    float yfov() const noexcept {
-        return findFloat("yfov");
-    }
+    Texture() {}
+    Texture(const Gltf* gltf, const JsonValue* json) : Named(gltf, json) {}
 
-    float zfar() const noexcept {
-        return findFloat("zfar");
+    /// Returns the Image used by this texture. This method name is more obvious.
+    Image image() const noexcept {
+        size_t num;
+        if (source(num)) {
+            return m_gltf->image(num);
+        }
+        return Image();
     }
 
-    float znear() const noexcept {
-        return findFloat("znear");
+    /// Returns the Image used by this texture. Same as image().
+    Image source() const noexcept {
+        return image();
     }
-};
-
-class Camera : public Named {
-public:
-    Camera() {}
-    Camera(const Gltf* gltf, const JsonValue* json) : Named(gltf, json) {}
-
-    enum class Type {
-        ORTHOGRAPHIC,
-        PERSPECTIVE
-    };
 
-    Type type() const noexcept {
-        if (m_json != nullptr) {
-            auto it = m_json->FindMember("type");
-            if (it != m_json->MemberEnd() && it->value.IsString()) {
-                const char* str = it->value.GetString();
-                return strcmp(str, "orthographic") == 0 ? Type::ORTHOGRAPHIC : Type::PERSPECTIVE;
-            }
+    /// Gets the index of the image used by this texture.
+    /// @param[out] index The variable to copy the index to.
+    /// @return True if the source index of found.
+    bool source(size_t& index) const noexcept {
+        size_t i;
+        if (const CompiledGltf* tables = compiled(Collection::TEXTURES, i)) {
+            return compiledIndex(tables->textures.source[i], index);
         }
-        return Type::PERSPECTIVE;
+        return findNumber(m_json, "source", index);
     }
-
-    Orthographic orthographic() const noexcept {
-        return findObject<Orthographic>(m_gltf, m_json, "orthographic");
+    Sampler sampler() const noexcept {
+        size_t num;
+        if (sampler(num)) {
+            return m_gltf->sampler(num);
+        }
+        return Sampler();
     }
 
-    Perspective perspective() const noexcept {
-        return findObject<Perspective>(m_gltf, m_json, "perspective");
+    bool sampler(size_t& index) const noexcept {
+        size_t i;
+        if (const CompiledGltf* tables = compiled(Collection::TEXTURES, i)) {
+            return compiledIndex(tables->textures.sampler[i], index);
+        }
+        return findNumber(m_json, "sampler", index);
     }
 };
 
-/// A node in the node hierarchy.
-class Node : public Named {
+class TextureInfo : public Object {
+    friend Material;
+    friend PbrMetallicRoughness;
 public:
-    Node() {};
-    Node(const Gltf* gltf, const JsonValue* json) : Named(gltf, json) {}
+    TextureInfo() {}
+    TextureInfo(const Gltf* gltf, const JsonValue* json) : Object(gltf, json) {}
 
-    Node operator[](size_t index) const noexcept {
-        return child(index);
-    }
-    Node child(size_t index) const noexcept {
-        size_t value;
-        if (findNumber(m_json, "children", index, value)) {
-            return m_gltf->node(value);
+    /// Returns the texture instead of having to use index().
+    Texture texture() const noexcept {
+        if (m_gltf != nullptr) {
+            return m_gltf->texture(index());
         }
-        return Node();
-    }
-    Node node(size_t index) const noexcept {
-        return child(index);
-    }
-    size_t childCount() const noexcept {
-        return count("children");
-    }
-    std::vector<size_t> children() const noexcept {
-        return getNumberVector<size_t>(m_json, "children");
-    }
-    std::vector<size_t> nodes() const noexcept {
-        return children();
-    }
-
-    bool matrix(float* m) const noexcept {
-        return copyFloats("matrix", 16, m);
-    }
-    bool translation(float* m) const noexcept {
-        return copyFloats("translation", 3, m);
-    }
-    bool rotation(float* m) const noexcept {
-        return copyFloats("rotation", 4, m);
-    }
-    bool scale(float* m) const noexcept {
-        return copyFloats("scale", 3, m);
-    }
-
-    bool weight(float* p, size_t count) const noexcept {
-        return copyFloats("weights", count, p);
-    }
-    float weight(size_t index) const noexcept {
-        return findNumberOrDefault(m_json, "weights", index, 0.0f);
-    }
-    size_t weightCount() const noexcept {
-        return count("weights");
+        return Texture();
     }
 
-    Mesh mesh() const noexcept;
-    bool mesh(size_t& index) const noexcept {
-        return findNumber(m_json, "mesh", index);
+    size_t texCoord() const noexcept {
+        return findNumberOrDefault<size_t>(m_json, "texCoord", 0);
     }
 
-    Camera camera() const noexcept;
-    bool camera(size_t& index) const noexcept {
-        return findNumber(m_json, "camera", index);
+    /// The index of the texture (when using Gltf::texture(size_t))
+    size_t index() const noexcept {
+        size_t value = 0;
+        index(value);
+        return value;
     }
 
-    Skin skin() const noexcept;
-    bool skin(size_t& index) const noexcept {
-        return findNumber(m_json, "skin", index);
+    bool index(size_t& index) const noexcept {
+        if (m_texture != CompiledGltf::NONE) {
+            index = m_texture;
+            return true;
+        }
+        return findNumber(m_json, "index", index);
     }
+private:
+    /// The texture index from the tables of a compiled material.
+    std::uint32_t m_texture = CompiledGltf::NONE;
 };
 
-/// The root nodes of a scene.
-class Scene : public Named {
+class Skin : public Named {
 public:
-    Scene() {};
-    Scene(const Gltf* gltf, const JsonValue* json) : Named(gltf, json) {}
+    Skin() {}
+    Skin(const Gltf* gltf, const JsonValue* json) : Named(gltf, json) {}
 
-    Node operator[](size_t index) const noexcept {
-        return node(index);
+    Accessor inverseBindMatrices() const noexcept {
+        size_t num;
+        if (findNumber<size_t>(m_json, "inverseBindMatrices", num)) {
+            return m_gltf->accessor(num);
+        }
+        return Accessor();
     }
-
-    Node node(size_t index) const noexcept {
-        size_t value;
-        if (findNumber(m_json, "nodes", index, value)) {
-            return m_gltf->node(value);
+    bool inverseBindMatrices(size_t& index) const noexcept {
+        return findNumber<size_t>(m_json, "inverseBindMatrices", index);
+    }
+    Node skeleton() const noexcept {
+        size_t num;
+        if (findNumber<size_t>(m_json, "skeleton", num)) {
+            return m_gltf->node(num);
         }
+        // Spec says: "When undefined, joints transforms resolve to scene root."
+        // I'll leave it up to the caller to find the root node.
         return Node();
     }
-
-    size_t nodeCount() const noexcept {
-        return count("nodes");
+    bool skeleton(size_t& index) const noexcept {
+        return findNumber<size_t>(m_json, "skeleton", index);
     }
-
-    std::vector<size_t> nodes() const noexcept {
-        return getNumberVector<size_t>(m_json, "nodes");
+    bool joints(size_t* p, size_t count) const noexcept {
+        return copyNumbers<size_t>(m_json, "joints", count, p);
+    }
+    size_t joint(size_t index) const noexcept {
+        return findNumberOrDefault<size_t>(m_json, "joints", index, 0);
+    }
+    size_t jointCount() const noexcept {
+        return count("joints");
+    }
+    std::vector<size_t> joints() const noexcept {
+        return getNumberVector<size_t>(m_json, "joints");
     }
 };
 
-class Buffer : public Named {
+class NormalTextureInfo : public TextureInfo {
 public:
-    Buffer() {}
-    Buffer(const Gltf* gltf, const JsonValue* json) : Named(gltf, json) {}
+    NormalTextureInfo() {}
+    NormalTextureInfo(const Gltf* gltf, const JsonValue* json) : TextureInfo(gltf, json) {}
 
-    /// Returns the uri string. May be null because GLB buffers don't have a uri.
-    const char* uri() const noexcept {
-        return str("uri");
-    }
-    size_t byteLength() const noexcept {
-        return findNumberOrDefault<size_t>(m_json, "byteLength", 0);
+    float scale() const noexcept {
+        return findFloat("scale", 1.0f);
     }
-
-    /// Loads data from the buffer.
-    /// You should cache this data in your engine because multiple BufferViews may refer to the same Buffer.
-    /// @param[in] data The vector to load the data into. It will be resized to byteLength().
-    /// @return True if the buffer was loaded successfully; false otherwise.
-    template<typename T>
-    bool load(std::vector<T>& data) const noexcept;
 };
 
-/// A view into a buffer generally representing a subset of the buffer.
-class BufferView : public Named {
+class PbrMetallicRoughness : public Object {
+    friend Material;
 public:
-    BufferView() {}
-    BufferView(const Gltf* gltf, const JsonValue* json) : Named(gltf, json) {}
-
-    enum Target {
-        ARRAY_BUFFER = 34962,
-        ELEMENT_ARRAY_BUFFER = 34963,
-        UNKNOWN = 0
-    };
+    PbrMetallicRoughness() {}
+    PbrMetallicRoughness(const Gltf* gltf, const JsonValue* json) : Object(gltf, json) {}
 
-    Buffer buffer() const noexcept {
-        size_t num;
-        if (findNumber(m_json, "buffer", num)) {
-            return m_gltf->buffer(num);
+    /// Copies 4 floats to the given pointer.
+    bool baseColorFactor(float* color) const noexcept {
+        if (color == nullptr) {
+            return false;
+        }
+        if (const CompiledGltf* tables = this->tables()) {
+            return copyFloats(true, tables->materials.baseColorFactor, m_material, 4, color);
+        }
+        if (!copyFloats("baseColorFactor", 4, color)) {
+            // failed read baseColorFactor so set to 1,1,1,1
+            std::fill(color, color + 4, 1.0f);
+        }
+        return true;
+    }
+    std::array<float, 4> baseColorFactor() const noexcept {
+        std::array<float, 4> v;
+        if (!baseColorFactor(v.data())) {
+            v.fill(1.0f);
         }
-        return Buffer();
-    }
-    bool buffer(size_t& index) const noexcept {
-        return findNumber(m_json, "buffer", index);
+        return v;
     }
-    size_t byteOffset() const noexcept {
-        return findNumberOrDefault(m_json, "byteOffset", 0);
+    TextureInfo baseColorTexture() const noexcept {
+        TextureInfo info = findObject<TextureInfo>(m_gltf, m_json, "baseColorTexture");
+        if (const CompiledGltf* tables = this->tables()) {
+            info.m_texture = tables->materials.baseColorTexture[m_material];
+        }
+        return info;
     }
-    size_t byteLength() const noexcept {
-        return findNumberOrDefault(m_json, "byteLength", 1);
+    float metallicFactor() const noexcept {
+        if (const CompiledGltf* tables = this->tables()) {
+            return tables->materials.metallicFactor[m_material];
+        }
+        return findFloat("metallicFactor", 1.0f);
     }
-    size_t byteStride() const noexcept {
-        return findNumberOrDefault(m_json, "byteStride", 0);
+    float roughnessFactor() const noexcept {
+        if (const CompiledGltf* tables = this->tables()) {
+            return tables->materials.roughnessFactor[m_material];
+        }
+        return findFloat("roughnessFactor", 1.0f);
     }
-
-    Target target() const noexcept {
-        int num;
-        if (findNumber<int>(m_json, "target", num)) {
-            switch (num) {
-            case GLValue::ELEMENT_ARRAY_BUFFER:
-                return Target::ELEMENT_ARRAY_BUFFER;
-            case GLValue::ARRAY_BUFFER:
-                return Target::ARRAY_BUFFER;
-            }
+    TextureInfo metallicRoughnessTexture() const noexcept {
+        TextureInfo info = findObject<TextureInfo>(m_gltf, m_json, "metallicRoughnessTexture");
+        if (const CompiledGltf* tables = this->tables()) {
+            info.m_texture = tables->materials.metallicRoughnessTexture[m_material];
         }
-        return Target::UNKNOWN;
+        return info;
     }
-
-    bool target(int& value) const noexcept {
-        return findNumber<int>(m_json, "target", value);
+private:
+    /// Returns the compiled tables if this object belongs to a compiled material.
+    const CompiledGltf* tables() const noexcept {
+        return m_material != CompiledGltf::NONE ? m_gltf->compiled() : nullptr;
     }
+    /// The index of the material in the compiled tables.
+    std::uint32_t m_material = CompiledGltf::NONE;
 };
 
-class SparseValues : public Object {
+class OcclusionTextureInfo : public TextureInfo {
 public:
-    SparseValues() {}
-    SparseValues(const Gltf* gltf, const JsonValue* json) : Object(gltf, json) {}
-
-    BufferView bufferView() const noexcept {
-        size_t index;
-        if (findNumber(m_json, "bufferView", index)) {
-            return m_gltf->bufferView(index);
-        }
-        return BufferView();
-    }
+    OcclusionTextureInfo() {}
+    OcclusionTextureInfo(const Gltf* gltf, const JsonValue* json) : TextureInfo(gltf, json) {}
 
-    size_t byteOffset() const noexcept {
-        return findNumberOrDefault(m_json, "byteOffset", 0);
+    float strength() const noexcept {
+        return findFloat("strength", 1.0f);
     }
 };
 
-class SparseIndices : public Object {
+class Material : public Named {
 public:
-    SparseIndices() {}
-    SparseIndices(const Gltf* gltf, const JsonValue* json) : Object(gltf, json) {}
+    Material() {}
+    Material(const Gltf* gltf, const JsonValue* json) : Named(gltf, json) {}
 
-    enum class ComponentType {
-        UNSIGNED_BYTE = 5121,
-        UNSIGNED_SHORT = 5123,
-        UNSIGNED_INT = 5125
+    enum class AlphaMode {
+        OPAQUE,
+        MASK,
+        BLEND
     };
 
-    BufferView bufferView() const noexcept {
-        size_t index;
-        if (findNumber(m_json, "bufferView", index)) {
-            return m_gltf->bufferView(index);
+    PbrMetallicRoughness pbrMetallicRoughness() const noexcept {
+        PbrMetallicRoughness pbr = findObject<PbrMetallicRoughness>(m_gltf, m_json, "pbrMetallicRoughness");
+        size_t i;
+        if (pbr && compiled(Collection::MATERIALS, i)) {
+            pbr.m_material = static_cast<std::uint32_t>(i);
         }
-        return BufferView();
+        return pbr;
+    }
+    NormalTextureInfo normalTexture() const noexcept {
+        return compiledTexture(findObject<NormalTextureInfo>(m_gltf, m_json, "normalTexture"),
+                               &CompiledGltf::Materials::normalTexture);
+    }
+    OcclusionTextureInfo occlusionTexture() const noexcept {
+        return compiledTexture(findObject<OcclusionTextureInfo>(m_gltf, m_json, "occlusionTexture"),
+                               &CompiledGltf::Materials::occlusionTexture);
+    }
+    TextureInfo emissiveTexture() const noexcept {
+        return compiledTexture(findObject<TextureInfo>(m_gltf, m_json, "emissiveTexture"),
+                               &CompiledGltf::Materials::emissiveTexture);
+    }
+    /// Copies 3 floats to the given pointer.
+    /// @return True if the material has an emissive factor. Compiled materials always have one.
+    bool emissiveFactor(float* emissive) const noexcept {
+        size_t i;
+        if (const CompiledGltf* tables = compiled(Collection::MATERIALS, i)) {
+            return copyFloats(true, tables->materials.emissiveFactor, i, 3, emissive);
+        }
+        return copyFloats("emissiveFactor", 3, emissive);
     }
 
-    size_t byteOffset() const noexcept {
-        return findNumberOrDefault(m_json, "byteOffset", 0);
+    std::array<float, 3> emissiveFactor() const noexcept {
+        std::array<float, 3> v;
+        if (!emissiveFactor(v.data())) {
+            v.fill(0.0f);
+        }
+        return v;
     }
 
-    ComponentType componentType() const noexcept {
-        int num;
-        if (findNumber<int>(m_json, "componentType", num)) {
-            switch (num) {
-            case GLValue::UNSIGNED_BYTE: return ComponentType::UNSIGNED_BYTE;
-            case GLValue::UNSIGNED_SHORT: return ComponentType::UNSIGNED_SHORT;
-            case GLValue::UNSIGNED_INT: return ComponentType::UNSIGNED_INT;
+    AlphaMode alphaMode() const noexcept {
+        size_t i;
+        if (const CompiledGltf* tables = compiled(Collection::MATERIALS, i)) {
+            return static_cast<AlphaMode>(tables->materials.alphaMode[i]);
+        }
+        const char* s = str("alphaMode");
+        if (s != nullptr) {
+            switch (*s) {
+            case 'M': return AlphaMode::MASK;
+            case 'B': return AlphaMode::BLEND;
             }
         }
-        return ComponentType::UNSIGNED_INT;
+        return AlphaMode::OPAQUE;
+    }
+    float alphaCutoff() const noexcept {
+        size_t i;
+        if (const CompiledGltf* tables = compiled(Collection::MATERIALS, i)) {
+            return tables->materials.alphaCutoff[i];
+        }
+        return findFloat("alphaCutoff", 0.5f);
+    }
+    bool doubleSided() const noexcept {
+        size_t i;
+        if (const CompiledGltf* tables = compiled(Collection::MATERIALS, i)) {
+            return tables->materials.doubleSided[i] != 0;
+        }
+        return findBool("doubleSided");
+    }
+private:
+    /// Sets the texture index of a texture info from the tables if this material is compiled.
+    template<typename T>
+    T compiledTexture(T info, std::vector<std::uint32_t> CompiledGltf::Materials::* textures) const noexcept {
+        size_t i;
+        if (const CompiledGltf* tables = compiled(Collection::MATERIALS, i)) {
+            info.m_texture = (tables->materials.*textures)[i];
+        }
+        return info;
     }
 };
 
-class Sparse : public Object {
+class MorphTarget : public Object {
 public:
-    Sparse() {}
-    Sparse(const Gltf* gltf, const JsonValue* json) : Object(gltf, json) {}
+    MorphTarget() {}
+    MorphTarget(const Gltf* gltf, const JsonValue* json) : Object(gltf, json) {}
 
-    size_t count() const noexcept {
-        return findNumberOrDefault<size_t>(m_json, "count", 1);
+    size_t position() const noexcept {
+        return findNumberOrDefault(m_json, "POSITION", 0);
     }
-
-    SparseIndices indices() const noexcept {
-        return findObject<SparseIndices>(m_gltf, m_json, "indices");
+    size_t normal() const noexcept {
+        return findNumberOrDefault(m_json, "NORMAL", 0);
     }
-
-    SparseValues values() const noexcept {
-        return findObject<SparseValues>(m_gltf, m_json, "values");
+    size_t tangent() const noexcept {
+        return findNumberOrDefault(m_json, "TANGENT", 0);
     }
 };
 
-class Accessor : public Named {
+class Primitive : public Object {
+    friend Mesh;
 public:
-    Accessor() {}
-    Accessor(const Gltf* gltf, const JsonValue* json) : Named(gltf, json) {}
+    Primitive() {}
+    Primitive(const Gltf* gltf, const JsonValue* json) : Object(gltf, json) {}
 
-    enum class Type {
-        SCALAR,
-        VEC2,
-        VEC3,
-        VEC4,
-        MAT2,
-        MAT3,
-        MAT4
+    enum class Mode {
+        POINTS = 0,
+        LINES = 1,
+        LINE_LOOP = 2,
+        LINE_STRIP = 3,
+        TRIANGLES = 4,
+        TRIANGLE_STRIP = 5,
+        TRIANGLE_FAN = 6
     };
 
-    enum class ComponentType {
-        BYTE = 5120,
-        UNSIGNED_BYTE = 5121,
-        SHORT = 5122,
-        UNSIGNED_SHORT = 5123,
-        UNSIGNED_INT = 5125,
-        FLOAT = 5126
-    };
+    Mode mode() const noexcept {
+        int value = 4;
+        if (const CompiledGltf* tables = this->tables()) {
+            value = tables->primitives.mode[m_index];
+        }
+        else {
+            findNumber(m_json, "mode", value);
+        }
+        switch (value) {
+        case 0: return Mode::POINTS;
+        case 1: return Mode::LINES;
+        case 2: return Mode::LINE_LOOP;
+        case 3: return Mode::LINE_STRIP;
+        case 4: return Mode::TRIANGLES;
+        case 5: return Mode::TRIANGLE_STRIP;
+        case 6: return Mode::TRIANGLE_FAN;
+        default: return Mode::TRIANGLES;
+        }
+    }
 
-    Type type() const noexcept {
-        const char* s = str("type");
-        if (s != nullptr) {
-            switch (*s) {
-            case 'S':
-                return Accessor::Type::SCALAR;
-            case 'V':
-                switch (s[3]) {
-                case '2': return Accessor::Type::VEC2;
-                case '3': return Accessor::Type::VEC3;
-                case '4': return Accessor::Type::VEC4;
-                }
-                break;
-            case 'M':
-                switch (s[3]) {
-                case '2': return Accessor::Type::VEC2;
-                case '3': return Accessor::Type::VEC3;
-                case '4': return Accessor::Type::VEC4;
+    Accessor attribute(const char* attribute) const noexcept {
+        if (attribute == nullptr) {
+            return Accessor();
+        }
+        if (const CompiledGltf* tables = this->tables()) {
+            const auto& primitives = tables->primitives;
+            for (size_t i = primitives.attributeOffsets[m_index]; i < primitives.attributeOffsets[m_index + 1]; ++i) {
+                if (primitives.attributeNames[i] == attribute) {
+                    return m_gltf->accessor(primitives.attributes[i]);
                 }
             }
+            return Accessor();
         }
-        return Accessor::Type::SCALAR;
-    }
-    BufferView bufferView() const noexcept {
-        size_t num;
-        if (findNumber<size_t>(m_json, "bufferView", num)) {
-            return m_gltf->bufferView(num);
+        size_t value;
+        if (findNumberInMap(m_json, "attributes", JsonKey(attribute), value)) {
+            return m_gltf->accessor(value);
         }
-        return BufferView();
+        return Accessor();
     }
-    bool bufferView(size_t& index) const noexcept {
-        return findNumber<size_t>(m_json, "bufferView", index);
+    /// Returns the list of attributes as a vector of pairs.
+    /// Pair.first is the attribute name and pair.second is the Accessor index.
+    std::vector<std::pair<const char*, size_t>> attributes() const noexcept {
+        std::vector<std::pair<const char*, size_t>> vec;
+        if (const CompiledGltf* tables = this->tables()) {
+            const auto& primitives = tables->primitives;
+            for (size_t i = primitives.attributeOffsets[m_index]; i < primitives.attributeOffsets[m_index + 1]; ++i) {
+                vec.emplace_back(primitives.attributeNames[i].c_str(), primitives.attributes[i]);
+            }
+        }
+        else if (m_json != nullptr) {
+            auto it = findMember(*m_json, "attributes");
+            if (it != m_json->MemberEnd() && it->value.IsObject()) {
+                vec.reserve(it->value.MemberCount());
+                for (auto member = it->value.MemberBegin(); member != it->value.MemberEnd(); ++member) {
+                    vec.emplace_back(member->name.GetString(), member->value.Get<size_t>());
+                }
+            }
+        }
+        return vec;
     }
-    size_t byteOffset() const noexcept {
-        return findNumberOrDefault<size_t>(m_json, "byteOffset", 0);
+
+    /// Returns the number of attributes in this primitive.
+    size_t attributeCount() const noexcept {
+        if (const CompiledGltf* tables = this->tables()) {
+            return tables->primitives.attributeOffsets[m_index + 1] - tables->primitives.attributeOffsets[m_index];
+        }
+        return count("attributes");
     }
-    ComponentType componentType() const noexcept {
-        int num;
-        if (findNumber<int>(m_json, "componentType", num)) {
-            switch (num) {
-            case GLValue::BYTE: return ComponentType::BYTE;
-            case GLValue::UNSIGNED_BYTE: return ComponentType::UNSIGNED_BYTE;
-            case GLValue::SHORT: return ComponentType::SHORT;
-            case GLValue::UNSIGNED_SHORT: return ComponentType::UNSIGNED_SHORT;
-            case GLValue::UNSIGNED_INT: return ComponentType::UNSIGNED_INT;
-            case GLValue::FLOAT: return ComponentType::FLOAT;
+    /// Returns a list of attribute names from this primitive.
+    /// The char pointers in this list will be invalid when the root gltf object is destroyed 
+    /// or loads a new file. 
+    std::vector<const char*> attributeStrings() const noexcept {
+        if (tables() != nullptr) {
+            std::vector<const char*> names;
+            for (const auto& attribute : attributes()) {
+                names.push_back(attribute.first);
             }
+            return names;
         }
-        return ComponentType::FLOAT;
+        return getKeys(m_json, "attributes");
+    }
+    Accessor position() const noexcept {
+        return attribute("POSITION");
     }
-    bool normalized() const noexcept {
-        return findBool("normalized");
+    Accessor normal() const noexcept {
+        return attribute("NORMAL");
     }
-    size_t count() const noexcept {
-        return findNumberOrDefault<size_t>(m_json, "count", 0);
+    Accessor tangent() const noexcept {
+        return attribute("TANGENT");
     }
-    bool max(float* p, size_t count) const noexcept {
-        return copyFloats("max", count, p);
+    Accessor texcoord(size_t index) const noexcept {
+        // OpenGL ES 3.0 supports a min of 16 vertex attributes but I'm
+        // going to assume there won't be more than 10 of one type. For now.
+        assert(index < 10);
+        char attr[] = "TEXCOORD_0";
+        attr[9] += static_cast<char>(index);
+        return attribute(attr);
     }
-    float max(size_t index) const noexcept {
-        return findNumberOrDefault(m_json, "max", index, 0.0f);
+    Accessor color(size_t index = 0) const noexcept {
+        assert(index < 10);
+        char attr[] = "COLOR_0";
+        attr[6] += static_cast<char>(index);
+        return attribute(attr);
     }
-    std::vector<float> max() const noexcept {
-        return getNumberVector<float>(m_json, "max");
+    Accessor joints(size_t index = 0) const noexcept {
+        assert(index < 10);
+        char attr[] = "JOINTS_0";
+        attr[7] += static_cast<char>(index);
+        return attribute(attr);
     }
-    size_t maxCount() const noexcept {
-        return Object::count("max");
+    Accessor weights(size_t index = 0) const noexcept {
+        assert(index < 10);
+        char attr[] = "WEIGHTS_0";
+        attr[8] += static_cast<char>(index);
+        return attribute(attr);
     }
-    bool min(float* p, size_t count) const noexcept {
-        return copyFloats("min", count, p);
+    Accessor indices() const noexcept {
+        size_t index;
+        if (indices(index)) {
+            return m_gltf->accessor(index);
+        }
+        return Accessor();
     }
-    float min(size_t index) const noexcept {
-        return findNumberOrDefault(m_json, "min", index, 0.0f);
+    bool indices(size_t& index) const noexcept {
+        if (const CompiledGltf* tables = this->tables()) {
+            return compiledIndex(tables->primitives.indices[m_index], index);
+        }
+        return findNumber(m_json, "indices", index);
     }
-    std::vector<float> min() const noexcept {
-        return getNumberVector<float>(m_json, "min");
+    Material material() const noexcept {
+        size_t num;
+        if (material(num)) {
+            return m_gltf->material(num);
+        }
+        return Material();
     }
-    size_t minCount() const noexcept {
-        return Object::count("min");
+    bool material(size_t& index) const noexcept {
+        if (const CompiledGltf* tables = this->tables()) {
+            return compiledIndex(tables->primitives.material[m_index], index);
+        }
+        return findNumber<size_t>(m_json, "material", index);
     }
-    Sparse sparse() const noexcept {
-        return findObject<Sparse>(m_gltf, m_json, "sparse");
+    MorphTarget target(size_t index) const noexcept {
+        return findObject<MorphTarget>(m_gltf, m_json, "targets", index);
+    }
+    size_t targetCount() const noexcept {
+        return count("targets");
+    }
+private:
+    /// Returns the compiled tables if this primitive belongs to a compiled mesh.
+    const CompiledGltf* tables() const noexcept {
+        return m_index != CompiledGltf::NONE ? m_gltf->compiled() : nullptr;
     }
+    /// The index of the primitive in the compiled tables.
+    std::uint32_t m_index = CompiledGltf::NONE;
 };
 
-class Asset : public Object {
-    friend Gltf;
+class Mesh : public Named {
 public:
-    Asset() {};
-    const char* copyright() const noexcept {
-        return str("copyright");
+    Mesh() {}
+    Mesh(const Gltf* gltf, const JsonValue* json) : Named(gltf, json) {}
+
+    Primitive primitive(size_t index) const noexcept {
+        Primitive primitive = findObject<Primitive>(m_gltf, m_json, "primitives", index);
+        size_t i;
+        if (const CompiledGltf* tables = compiled(Collection::MESHES, i)) {
+            if (primitive) {
+                primitive.m_index = tables->meshes.primitiveOffsets[i] + static_cast<std::uint32_t>(index);
+            }
+        }
+        return primitive;
     }
-    const char* generator() const noexcept {
-        return str("generator");
+
+    Primitive operator[](size_t index) const noexcept {
+        return primitive(index);
     }
-    const char* version() const noexcept {
-        return str("version");
+
+    std::vector<Primitive> primitives() const noexcept;
+
+    size_t primitiveCount() const noexcept {
+        size_t i;
+        if (const CompiledGltf* tables = compiled(Collection::MESHES, i)) {
+            return tables->meshes.primitiveOffsets[i + 1] - tables->meshes.primitiveOffsets[i];
+        }
+        return count("primitives");
     }
-    const char* minVersion() const noexcept {
-        return str("minVersion");
+
+    float weight(size_t index) const noexcept {
+        return findNumberOrDefault(m_json, "weights", index, 0.0f);
+    }
+
+    bool weights(float* p, size_t count) const noexcept {
+        return copyFloats("weights", count, p);
+    }
+
+    size_t weightCount() const noexcept {
+        return count("weights");
     }
-private:
-    Asset(const Gltf* gltf, const JsonValue* json) : Object(gltf, json) {}
 };
 
-class Image : public Named {
+class AnimationSampler : public Object {
 public:
-    Image() {}
-    Image(const Gltf* gltf, const JsonValue* json) : Named(gltf, json) {}
+    AnimationSampler() {}
+    AnimationSampler(const Gltf* gltf, const JsonValue* json) : Object(gltf, json) {}
 
-    const char* uri() const noexcept {
-        return str("uri");
+    Accessor input() const noexcept {
+        size_t index;
+        if (input(index)) {
+            return m_gltf->accessor(index);
+        }
+        return Accessor();
     }
-    const char* mimeType() const noexcept {
-        return str("mimeType");
+    bool input(size_t& index) const noexcept {
+        return findNumber(m_json, "input", index);
     }
-    BufferView bufferView() const noexcept {
-        size_t num;
-        if (findNumber(m_json, "bufferView", num)) {
-            return m_gltf->bufferView(num);
+    Accessor output() const noexcept {
+        size_t index;
+        if (output(index)) {
+            return m_gltf->accessor(index);
         }
-        return BufferView();
+        return Accessor();
     }
-    bool bufferView(size_t& index) const noexcept {
-        return findNumber(m_json, "bufferView", index);
+    bool output(size_t& index) const noexcept {
+        return findNumber(m_json, "output", index);
     }
-    bool isBase64() const {
-        const char* s = uri();
-        return startsWith(s, LAZY_GLTF2_DATA_IMAGE_JPG) || startsWith(s, LAZY_GLTF2_DATA_IMAGE_PNG);
+    Interpolation interpolation() const noexcept {
+        const char* s = str("interpolation");
+        if (s != nullptr && *s != '\0') {
+            switch (s[1]) { // 2nd char
+            case 'T': return Interpolation::STEP;
+            case 'A': return Interpolation::CATMULLROMSPLINE;
+            case 'U': return Interpolation::CUBICSPLINE;
+            }
+        }
+        return Interpolation::LINEAR;
+    }
+    const char* interpolationStr() const noexcept {
+        return str("interpolation");
     }
-    template<typename T>
-    bool loadBase64(std::vector<T>& data) const;
 };
 
-/// Texture sampler
-class Sampler : public Named {
+class Channel : public Object {
 public:
-    Sampler() {}
-    Sampler(const Gltf* gltf, const JsonValue* json) : Named(gltf, json) {}
-
-    enum class Wrap {
-        REPEAT = 10497,
-        CLAMP_TO_EDGE = 33071,
-        MIRRORED_REPEAT = 33648
-    };
-
-    enum class MinFilter {
-        NEAREST = 9728,
-        LINEAR = 9729,
-        NEAREST_MIPMAP_NEAREST = 9984,
-        LINEAR_MIPMAP_NEAREST = 9985,
-        NEAREST_MIPMAP_LINEAR = 9986,
-        LINEAR_MIPMAP_LINEAR = 9987
-    };
+    Channel() {}
+    Channel(const Gltf* gltf, const JsonValue* json, const JsonValue* animation) : Object(gltf, json), animation(animation) {}
 
-    enum class MagFilter {
-        NEAREST = 9728,
-        LINEAR = 9729
-    };
+    class Target : public Object {
+    public:
+        Target() {}
+        Target(const Gltf* gltf, const JsonValue* json) : Object(gltf, json) {}
 
-    MagFilter magFilter() const noexcept {
-        int num;
-        if (findNumber(m_json, "magFilter", num)) {
-            if (num == GLValue::NEAREST) {
-                return MagFilter::NEAREST;
+        Node node() const noexcept {
+            size_t index;
+            if (node(index)) {
+                return m_gltf->node(index);
             }
+            return Node();
         }
-        return MagFilter::LINEAR;
-    }
-    MinFilter minFilter() const noexcept {
-        int num;
-        if (findNumber(m_json, "minFilter", num)) {
-            switch (num) {
-            case GLValue::NEAREST: return MinFilter::NEAREST;
-            case GLValue::LINEAR: return MinFilter::LINEAR;
-            case GLValue::NEAREST_MIPMAP_NEAREST: return MinFilter::NEAREST_MIPMAP_NEAREST;
-            case GLValue::LINEAR_MIPMAP_NEAREST: return MinFilter::LINEAR_MIPMAP_NEAREST;
-            case GLValue::NEAREST_MIPMAP_LINEAR: return MinFilter::NEAREST_MIPMAP_LINEAR;
-            case GLValue::LINEAR_MIPMAP_LINEAR: return MinFilter::LINEAR_MIPMAP_LINEAR;
-            }
+        bool node(size_t& index) const noexcept {
+            return findNumber(m_json, "node", index);
         }
-        return MinFilter::LINEAR_MIPMAP_LINEAR;
-    }
-    Wrap wrapS() const noexcept {
-        int num;
-        if (findNumber(m_json, "wrapS", num)) {
-            switch (num) {
-            case GLValue::CLAMP_TO_EDGE: return Wrap::CLAMP_TO_EDGE;
-            case GLValue::MIRRORED_REPEAT: return Wrap::MIRRORED_REPEAT;
-            case GLValue::REPEAT: return Wrap::REPEAT;
+        TargetPath path() const noexcept {
+            const char* s = str("path");
+            if (s != nullptr) {
+                switch (*s) {
+                case 'r': return TargetPath::ROTATION;
+                case 's': return TargetPath::SCALE;
+                case 'w': return TargetPath::WEIGHTS;
+                }
             }
+            return TargetPath::TRANSLATION;
         }
-        return Wrap::REPEAT;
-    }
-    Wrap wrapT() const noexcept {
-        int num;
-        if (findNumber(m_json, "wrapT", num)) {
-            switch (num) {
-            case GLValue::CLAMP_TO_EDGE: return Wrap::CLAMP_TO_EDGE;
-            case GLValue::MIRRORED_REPEAT: return Wrap::MIRRORED_REPEAT;
-            case GLValue::REPEAT: return Wrap::REPEAT;
-            }
+        const char* pathStr() const noexcept {
+            return str("path");
         }
-        return Wrap::REPEAT;
+    };
+
+    AnimationSampler sampler() const noexcept {
+        size_t index;
+        if (sampler(index)) {
+            assert(animation);
+            return findObject<AnimationSampler>(m_gltf, animation, "samplers", index);
+        }
+        return AnimationSampler();
+    }
+    bool sampler(size_t& index) const noexcept {
+        return findNumber(m_json, "sampler", index);
     }
+    Channel::Target target() const noexcept {
+        return findObject<Channel::Target>(m_gltf, m_json, "target");
+    }
+private:
+    /// Pointer to the parent animation json object
+    const JsonValue* animation = nullptr;
 };
 
-class Texture : public Named {
-public:
-    Texture() {}
-    Texture(const Gltf* gltf, const JsonValue* json) : Named(gltf, json) {}
-
-    /// Returns the Image used by this texture. This method name is more obvious.
-    Image image() const noexcept {
-        size_t num;
-        if (findNumber(m_json, "source", num)) {
-            return m_gltf->image(num);
+// TODO move this?
+static Channel findChannel(const Gltf* gltf, const JsonValue* json, size_t index) {
+    if (json != nullptr) {
+        auto it = findMember(*json, "channels");
+        if (it != json->MemberEnd() && it->value.IsArray() && index < it->value.Size()) {
+            const auto& v = it->value[index];
+            if (v.IsObject()) {
+                return Channel(gltf, &v, json);
+            }
         }
-        return Image();
     }
+    return Channel();
+}
 
-    /// Returns the Image used by this texture. Same as image().
-    Image source() const noexcept {
-        return image();
-    }
+class Animation : public Named {
+public:
+    Animation() {}
+    Animation(const Gltf* gltf, const JsonValue* json) : Named(gltf, json) {}
 
-    /// Gets the index of the image used by this texture.
-    /// @param[out] index The variable to copy the index to.
-    /// @return True if the source index of found.
-    bool source(size_t& index) const noexcept {
-        return findNumber(m_json, "source", index);
+    Channel channel(size_t index) const noexcept {
+        return findChannel(m_gltf, m_json, index);
     }
-    Sampler sampler() const noexcept {
-        size_t num;
-        if (findNumber(m_json, "sampler", num)) {
-            return m_gltf->sampler(num);
-        }
-        return Sampler();
+    size_t channelCount() const noexcept {
+        return count("channels");
     }
-
-    bool sampler(size_t& index) const noexcept {
-        return findNumber(m_json, "sampler", index);
+    AnimationSampler sampler(size_t index) const noexcept {
+        return findObject<AnimationSampler>(m_gltf, m_json, "samplers", index);
+    }
+    size_t samplerCount() const noexcept {
+        return count("samplers");
     }
 };
 
-class TextureInfo : public Object {
-public:
-    TextureInfo() {}
-    TextureInfo(const Gltf* gltf, const JsonValue* json) : Object(gltf, json) {}
+// functions
 
-    /// Returns the texture instead of having to use index().
-    Texture texture() const noexcept {
-        if (m_gltf != nullptr) {
-            return m_gltf->texture(index());
-        }
-        return Texture();
+template<typename T = size_t>
+T numberOfComponents(Accessor::Type type) noexcept {
+    switch (type) {
+    case Accessor::Type::SCALAR: return 1;
+    case Accessor::Type::VEC2: return 2;
+    case Accessor::Type::VEC3: return 3;
+    case Accessor::Type::VEC4: return 4;
+    case Accessor::Type::MAT2: return 4;
+    case Accessor::Type::MAT3: return 9;
+    case Accessor::Type::MAT4: return 16;
+    default:
+        return 0;
     }
+}
 
-    size_t texCoord() const noexcept {
-        return findNumberOrDefault<size_t>(m_json, "texCoord", 0);
+/// Returns the size in bytes of one component.
+inline size_t componentSize(Accessor::ComponentType type) noexcept {
+    switch (type) {
+    case Accessor::ComponentType::BYTE:
+    case Accessor::ComponentType::UNSIGNED_BYTE: return 1;
+    case Accessor::ComponentType::SHORT:
+    case Accessor::ComponentType::UNSIGNED_SHORT: return 2;
+    case Accessor::ComponentType::UNSIGNED_INT:
+    case Accessor::ComponentType::FLOAT: return 4;
+    default:
+        return 0;
     }
+}
 
-    /// The index of the texture (when using Gltf::texture(size_t))
-    size_t index() const noexcept {
-        return findNumberOrDefault<size_t>(m_json, "index", 0);
+/// Returns the number of columns of an accessor type. Vectors and scalars have one column.
+inline size_t numberOfColumns(Accessor::Type type) noexcept {
+    switch (type) {
+    case Accessor::Type::MAT2: return 2;
+    case Accessor::Type::MAT3: return 3;
+    case Accessor::Type::MAT4: return 4;
+    default:
+        return 1;
     }
+}
 
-    bool index(size_t& index) const noexcept {
-        return findNumber(m_json, "index", index);
+/// Converts a normalized integer to a float using the rules from the glTF 2.0 spec.
+/// The division is done by multiplying with the reciprocal so that the result is exactly the same as the
+/// SIMD conversion in convertNormalized(). It is within 1 ulp of the division and -1, 0 and 1 are exact.
+inline float normalizedToFloat(std::int8_t c) noexcept {
+    return std::max(c * (1.0f / 127.0f), -1.0f);
+}
+inline float normalizedToFloat(std::uint8_t c) noexcept {
+    return c * (1.0f / 255.0f);
+}
+inline float normalizedToFloat(std::int16_t c) noexcept {
+    return std::max(c * (1.0f / 32767.0f), -1.0f);
+}
+inline float normalizedToFloat(std::uint16_t c) noexcept {
+    return c * (1.0f / 65535.0f);
+}
+inline float normalizedToFloat(std::uint32_t c) noexcept {
+    return static_cast<float>(c / 4294967295.0);
+}
+inline float normalizedToFloat(float c) noexcept {
+    return c;
+}
+
+/// Converts count normalized components of type S to floats.
+/// The input doesn't need to be aligned. This is the scalar version that the SIMD kernels use for the tail.
+template<typename S>
+static void convertNormalizedScalar(const unsigned char* in, size_t count, float* out) noexcept {
+    for (size_t i = 0; i < count; ++i) {
+        S value;
+        memcpy(&value, in + i * sizeof(S), sizeof(S));
+        out[i] = normalizedToFloat(value);
     }
-};
+}
 
-class Skin : public Named {
-public:
-    Skin() {}
-    Skin(const Gltf* gltf, const JsonValue* json) : Named(gltf, json) {}
+template<typename S>
+static void convertNormalizedKernel(const unsigned char* in, size_t count, float* out) noexcept {
+    convertNormalizedScalar<S>(in, count, out);
+}
 
-    Accessor inverseBindMatrices() const noexcept {
-        size_t num;
-        if (findNumber<size_t>(m_json, "inverseBindMatrices", num)) {
-            return m_gltf->accessor(num);
-        }
-        return Accessor();
-    }
-    bool inverseBindMatrices(size_t& index) const noexcept {
-        return findNumber<size_t>(m_json, "inverseBindMatrices", index);
+template<>
+inline void convertNormalizedKernel<float>(const unsigned char* in, size_t count, float* out) noexcept {
+    memcpy(out, in, count * sizeof(float));
+}
+
+template<>
+inline void convertNormalizedKernel<std::uint8_t>(const unsigned char* in, size_t count, float* out) noexcept {
+    size_t i = 0;
+#if defined(LAZY_GLTF2_AVX2)
+    const __m256 scale = _mm256_set1_ps(1.0f / 255.0f);
+    for (; i + 8 <= count; i += 8) {
+        const __m256i v = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + i)));
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), scale));
+    }
+#elif defined(LAZY_GLTF2_SSE2)
+    const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= count; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        const __m128i lo = _mm_unpacklo_epi8(v, zero);
+        const __m128i hi = _mm_unpackhi_epi8(v, zero);
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), scale));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), scale));
+        _mm_storeu_ps(out + i + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), scale));
+        _mm_storeu_ps(out + i + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), scale));
     }
-    Node skeleton() const noexcept {
-        size_t num;
-        if (findNumber<size_t>(m_json, "skeleton", num)) {
-            return m_gltf->node(num);
+#endif
+    convertNormalizedScalar<std::uint8_t>(in + i, count - i, out + i);
+}
+
+template<>
+inline void convertNormalizedKernel<std::int8_t>(const unsigned char* in, size_t count, float* out) noexcept {
+    size_t i = 0;
+#if defined(LAZY_GLTF2_AVX2)
+    const __m256 scale = _mm256_set1_ps(1.0f / 127.0f);
+    const __m256 minusOne = _mm256_set1_ps(-1.0f);
+    for (; i + 8 <= count; i += 8) {
+        const __m256i v = _mm256_cvtepi8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + i)));
+        _mm256_storeu_ps(out + i, _mm256_max_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(v), scale), minusOne));
+    }
+#elif defined(LAZY_GLTF2_SSE2)
+    const __m128 scale = _mm_set1_ps(1.0f / 127.0f);
+    const __m128 minusOne = _mm_set1_ps(-1.0f);
+    for (; i + 16 <= count; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        // sign extend by placing each byte in the high half and shifting it back down
+        const __m128i lo = _mm_srai_epi16(_mm_unpacklo_epi8(v, v), 8);
+        const __m128i hi = _mm_srai_epi16(_mm_unpackhi_epi8(v, v), 8);
+        const __m128i parts[4] = {
+            _mm_srai_epi32(_mm_unpacklo_epi16(lo, lo), 16),
+            _mm_srai_epi32(_mm_unpackhi_epi16(lo, lo), 16),
+            _mm_srai_epi32(_mm_unpacklo_epi16(hi, hi), 16),
+            _mm_srai_epi32(_mm_unpackhi_epi16(hi, hi), 16)
+        };
+        for (size_t j = 0; j < 4; ++j) {
+            _mm_storeu_ps(out + i + j * 4, _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(parts[j]), scale), minusOne));
         }
-        // Spec says: "When undefined, joints transforms resolve to scene root."
-        // I'll leave it up to the caller to find the root node.
-        return Node();
     }
-    bool skeleton(size_t& index) const noexcept {
-        return findNumber<size_t>(m_json, "skeleton", index);
+#endif
+    convertNormalizedScalar<std::int8_t>(in + i, count - i, out + i);
+}
+
+template<>
+inline void convertNormalizedKernel<std::uint16_t>(const unsigned char* in, size_t count, float* out) noexcept {
+    size_t i = 0;
+#if defined(LAZY_GLTF2_AVX2)
+    const __m256 scale = _mm256_set1_ps(1.0f / 65535.0f);
+    for (; i + 8 <= count; i += 8) {
+        const __m256i v = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * 2)));
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), scale));
+    }
+#elif defined(LAZY_GLTF2_SSE2)
+    const __m128 scale = _mm_set1_ps(1.0f / 65535.0f);
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 8 <= count; i += 8) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * 2));
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(v, zero)), scale));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(v, zero)), scale));
     }
-    bool joints(size_t* p, size_t count) const noexcept {
-        return copyNumbers<size_t>(m_json, "joints", count, p);
+#endif
+    convertNormalizedScalar<std::uint16_t>(in + i * 2, count - i, out + i);
+}
+
+template<>
+inline void convertNormalizedKernel<std::int16_t>(const unsigned char* in, size_t count, float* out) noexcept {
+    size_t i = 0;
+#if defined(LAZY_GLTF2_AVX2)
+    const __m256 scale = _mm256_set1_ps(1.0f / 32767.0f);
+    const __m256 minusOne = _mm256_set1_ps(-1.0f);
+    for (; i + 8 <= count; i += 8) {
+        const __m256i v = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * 2)));
+        _mm256_storeu_ps(out + i, _mm256_max_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(v), scale), minusOne));
+    }
+#elif defined(LAZY_GLTF2_SSE2)
+    const __m128 scale = _mm_set1_ps(1.0f / 32767.0f);
+    const __m128 minusOne = _mm_set1_ps(-1.0f);
+    for (; i + 8 <= count; i += 8) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * 2));
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(out + i, _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(lo), scale), minusOne));
+        _mm_storeu_ps(out + i + 4, _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(hi), scale), minusOne));
     }
-    size_t joint(size_t index) const noexcept {
-        return findNumberOrDefault<size_t>(m_json, "joints", index, 0);
+#endif
+    convertNormalizedScalar<std::int16_t>(in + i * 2, count - i, out + i);
+}
+
+/// Converts normalized integer components to floats, using SSE2 or AVX2 when they are enabled at compile time.
+/// Signed components use the max(c / 127, -1) rule from the glTF 2.0 spec. FLOAT components are copied.
+/// @param[in]  type  The component type of the input.
+/// @param[in]  in    Pointer to the tightly packed components. It doesn't need to be aligned.
+/// @param[in]  count The number of components to convert.
+/// @param[out] out   Array of at least count floats.
+inline void convertNormalized(Accessor::ComponentType type, const void* in, size_t count, float* out) noexcept {
+    const auto* bytes = static_cast<const unsigned char*>(in);
+    switch (type) {
+    case Accessor::ComponentType::BYTE: convertNormalizedKernel<std::int8_t>(bytes, count, out); break;
+    case Accessor::ComponentType::UNSIGNED_BYTE: convertNormalizedKernel<std::uint8_t>(bytes, count, out); break;
+    case Accessor::ComponentType::SHORT: convertNormalizedKernel<std::int16_t>(bytes, count, out); break;
+    case Accessor::ComponentType::UNSIGNED_SHORT: convertNormalizedKernel<std::uint16_t>(bytes, count, out); break;
+    case Accessor::ComponentType::UNSIGNED_INT: convertNormalizedKernel<std::uint32_t>(bytes, count, out); break;
+    case Accessor::ComponentType::FLOAT: convertNormalizedKernel<float>(bytes, count, out); break;
     }
-    size_t jointCount() const noexcept {
-        return count("joints");
+}
+
+/// Writes the column major matrix of a node transform to m.
+/// The rotation columns are computed and scaled with SSE2 when it is enabled at compile time.
+/// @param[in]  t The translation.
+/// @param[in]  r The rotation as a unit quaternion (x, y, z, w).
+/// @param[in]  s The scale.
+/// @param[out] m Array of 16 floats.
+inline void composeMatrix(const float* t, const float* r, const float* s, float* m) noexcept {
+#if defined(LAZY_GLTF2_SSE2)
+    // each rotation column is a unit vector plus two signed products of the quaternion components
+    // with w zeroed by the signs, like (1 - 2yy - 2zz, 2yx + 2zw, 2zx - 2yw, 0) for the first column
+    const __m128 q = _mm_loadu_ps(r);
+    const __m128 q2 = _mm_add_ps(q, q);
+    auto column = [](__m128 unit, __m128 a, __m128 b, __m128 signsAb, __m128 c, __m128 d, __m128 signsCd) {
+        return _mm_add_ps(unit, _mm_add_ps(_mm_mul_ps(_mm_mul_ps(a, b), signsAb), _mm_mul_ps(_mm_mul_ps(c, d), signsCd)));
+    };
+    const __m128 c0 = column(_mm_setr_ps(1.0f, 0.0f, 0.0f, 0.0f),
+                             _mm_shuffle_ps(q2, q2, _MM_SHUFFLE(3, 2, 1, 1)), _mm_shuffle_ps(q, q, _MM_SHUFFLE(3, 0, 0, 1)),
+                             _mm_setr_ps(-1.0f, 1.0f, 1.0f, 0.0f),
+                             _mm_shuffle_ps(q2, q2, _MM_SHUFFLE(3, 1, 2, 2)), _mm_shuffle_ps(q, q, _MM_SHUFFLE(3, 3, 3, 2)),
+                             _mm_setr_ps(-1.0f, 1.0f, -1.0f, 0.0f));
+    const __m128 c1 = column(_mm_setr_ps(0.0f, 1.0f, 0.0f, 0.0f),
+                             _mm_shuffle_ps(q2, q2, _MM_SHUFFLE(3, 1, 0, 0)), _mm_shuffle_ps(q, q, _MM_SHUFFLE(3, 2, 0, 1)),
+                             _mm_setr_ps(1.0f, -1.0f, 1.0f, 0.0f),
+                             _mm_shuffle_ps(q2, q2, _MM_SHUFFLE(3, 3, 2, 3)), _mm_shuffle_ps(q, q, _MM_SHUFFLE(3, 0, 2, 2)),
+                             _mm_setr_ps(-1.0f, -1.0f, 1.0f, 0.0f));
+    const __m128 c2 = column(_mm_setr_ps(0.0f, 0.0f, 1.0f, 0.0f),
+                             _mm_shuffle_ps(q2, q2, _MM_SHUFFLE(3, 0, 1, 0)), _mm_shuffle_ps(q, q, _MM_SHUFFLE(3, 0, 2, 2)),
+                             _mm_setr_ps(1.0f, 1.0f, -1.0f, 0.0f),
+                             _mm_shuffle_ps(q2, q2, _MM_SHUFFLE(3, 1, 3, 3)), _mm_shuffle_ps(q, q, _MM_SHUFFLE(3, 1, 0, 1)),
+                             _mm_setr_ps(1.0f, -1.0f, -1.0f, 0.0f));
+    _mm_storeu_ps(m, _mm_mul_ps(c0, _mm_set1_ps(s[0])));
+    _mm_storeu_ps(m + 4, _mm_mul_ps(c1, _mm_set1_ps(s[1])));
+    _mm_storeu_ps(m + 8, _mm_mul_ps(c2, _mm_set1_ps(s[2])));
+    _mm_storeu_ps(m + 12, _mm_setr_ps(t[0], t[1], t[2], 1.0f));
+#else
+    const float x = r[0], y = r[1], z = r[2], w = r[3];
+    const float xx = x * x, yy = y * y, zz = z * z;
+    const float xy = x * y, xz = x * z, yz = y * z;
+    const float wx = w * x, wy = w * y, wz = w * z;
+    m[0] = (1.0f - 2.0f * (yy + zz)) * s[0];
+    m[1] = 2.0f * (xy + wz) * s[0];
+    m[2] = 2.0f * (xz - wy) * s[0];
+    m[3] = 0.0f;
+    m[4] = 2.0f * (xy - wz) * s[1];
+    m[5] = (1.0f - 2.0f * (xx + zz)) * s[1];
+    m[6] = 2.0f * (yz + wx) * s[1];
+    m[7] = 0.0f;
+    m[8] = 2.0f * (xz + wy) * s[2];
+    m[9] = 2.0f * (yz - wx) * s[2];
+    m[10] = (1.0f - 2.0f * (xx + yy)) * s[2];
+    m[11] = 0.0f;
+    m[12] = t[0];
+    m[13] = t[1];
+    m[14] = t[2];
+    m[15] = 1.0f;
+#endif
+}
+
+/// Multiplies two column major 4x4 matrices, out = a * b, using SSE2 when it is enabled at compile time.
+/// Out may be the same array as b but not a.
+inline void multiplyMatrices(const float* a, const float* b, float* out) noexcept {
+#if defined(LAZY_GLTF2_SSE2)
+    const __m128 a0 = _mm_loadu_ps(a);
+    const __m128 a1 = _mm_loadu_ps(a + 4);
+    const __m128 a2 = _mm_loadu_ps(a + 8);
+    const __m128 a3 = _mm_loadu_ps(a + 12);
+    for (size_t j = 0; j < 16; j += 4) {
+        __m128 c = _mm_mul_ps(a0, _mm_set1_ps(b[j]));
+        c = _mm_add_ps(c, _mm_mul_ps(a1, _mm_set1_ps(b[j + 1])));
+        c = _mm_add_ps(c, _mm_mul_ps(a2, _mm_set1_ps(b[j + 2])));
+        c = _mm_add_ps(c, _mm_mul_ps(a3, _mm_set1_ps(b[j + 3])));
+        _mm_storeu_ps(out + j, c);
     }
-    std::vector<size_t> joints() const noexcept {
-        return getNumberVector<size_t>(m_json, "joints");
+#else
+    for (size_t j = 0; j < 16; j += 4) {
+        float c[4];
+        for (size_t i = 0; i < 4; ++i) {
+            c[i] = a[i] * b[j] + a[4 + i] * b[j + 1] + a[8 + i] * b[j + 2] + a[12 + i] * b[j + 3];
+        }
+        std::copy(c, c + 4, out + j);
+    }
+#endif
+}
+
+/// Describes where the components of an accessor are in a buffer.
+struct AccessorLayout {
+    const unsigned char* data = nullptr;
+    size_t count = 0;
+    /// Bytes between the start of two elements.
+    size_t stride = 0;
+    size_t columns = 1;
+    size_t rows = 1;
+    /// Bytes between the start of two matrix columns.
+    size_t columnStride = 0;
+    bool normalize = false;
+
+    /// Returns the number of components in an element.
+    size_t components() const noexcept {
+        return rows * columns;
+    }
+    /// Returns the number of bytes used by an element, not including the padding of the byteStride.
+    size_t elementSize() const noexcept {
+        return columnStride * columns;
     }
 };
 
-class NormalTextureInfo : public TextureInfo {
-public:
-    NormalTextureInfo() {}
-    NormalTextureInfo(const Gltf* gltf, const JsonValue* json) : TextureInfo(gltf, json) {}
+/// Creates the layout of elements of the given type. The layout doesn't point to any data yet.
+inline AccessorLayout accessorLayout(Accessor::Type type, Accessor::ComponentType componentType, bool normalized) noexcept {
+    AccessorLayout layout;
+    layout.columns = numberOfColumns(type);
+    layout.rows = numberOfComponents(type) / layout.columns;
+    layout.normalize = normalized;
+    const size_t size = componentSize(componentType);
+    // matrix columns start on 4-byte boundaries
+    layout.columnStride = layout.columns > 1 ? (layout.rows * size + 3) & ~size_t(3) : layout.rows * size;
+    return layout;
+}
 
-    float scale() const noexcept {
-        return findFloat("scale", 1.0f);
+/// Points a layout at count elements that start at offset in data.
+/// The stride is the byteStride of the data or the element size if the data is tightly packed.
+/// @return True if all of the elements are within the data.
+inline bool bindLayout(AccessorLayout& layout, const DataView& data, size_t offset, size_t count) noexcept {
+    const size_t elementSize = layout.elementSize();
+    const size_t stride = data.byteStride() != 0 ? data.byteStride() : elementSize;
+    if (!data || offset > data.byteLength()
+        || (count > 0 && (count - 1) * stride + elementSize > data.byteLength() - offset)) {
+        return false;
     }
-};
+    layout.data = data.data() + offset;
+    layout.stride = stride;
+    layout.count = count;
+    return true;
+}
 
-class PbrMetallicRoughness : public Object {
-public:
-    PbrMetallicRoughness() {}
-    PbrMetallicRoughness(const Gltf* gltf, const JsonValue* json) : Object(gltf, json) {}
+template<typename S, typename T>
+static bool convertNormalizedComponents(const AccessorLayout&, T*, std::false_type) noexcept {
+    return false;
+}
 
-    /// Copies 4 floats to the given pointer.
-    bool baseColorFactor(float* color) const noexcept {
-        if (color == nullptr) {
-            return false;
-        }
-        if (!copyFloats("baseColorFactor", 4, color)) {
-            // failed read baseColorFactor so set to 1,1,1,1
-            std::fill(color, color + 4, 1.0f);
-        }
+/// Converts normalized components to floats with the SIMD kernels.
+template<typename S>
+static bool convertNormalizedComponents(const AccessorLayout& layout, float* out, std::true_type) noexcept {
+    const size_t rowBytes = layout.rows * sizeof(S);
+    if (layout.columnStride == rowBytes && layout.stride == rowBytes * layout.columns) {
+        // tightly packed so convert everything at once
+        convertNormalizedKernel<S>(layout.data, layout.count * layout.rows * layout.columns, out);
         return true;
     }
-    std::array<float, 4> baseColorFactor() const noexcept {
-        std::array<float, 4> v;
-        if (!baseColorFactor(v.data())) {
-            v.fill(1.0f);
+    for (size_t i = 0; i < layout.count; ++i) {
+        const unsigned char* element = layout.data + i * layout.stride;
+        for (size_t c = 0; c < layout.columns; ++c) {
+            convertNormalizedKernel<S>(element + c * layout.columnStride, layout.rows, out);
+            out += layout.rows;
         }
-        return v;
-    }
-    TextureInfo baseColorTexture() const noexcept {
-        return findObject<TextureInfo>(m_gltf, m_json, "baseColorTexture");
-    }
-    float metallicFactor() const noexcept {
-        return findFloat("metallicFactor", 1.0f);
-    }
-    float roughnessFactor() const noexcept {
-        return findFloat("roughnessFactor", 1.0f);
     }
-    TextureInfo metallicRoughnessTexture() const noexcept {
-        return findObject<TextureInfo>(m_gltf, m_json, "metallicRoughnessTexture");
+    return true;
+}
+
+/// Converts the components of S at the given layout to T.
+template<typename S, typename T>
+static void convertComponents(const AccessorLayout& layout, T* out) noexcept {
+    const bool normalize = layout.normalize && std::is_floating_point<T>::value;
+    if (normalize && convertNormalizedComponents<S>(layout, out, std::is_same<T, float>())) {
+        return;
+    }
+    const size_t rowBytes = layout.rows * sizeof(S);
+    if (!normalize && std::is_same<S, T>::value && layout.columnStride == rowBytes) {
+        const size_t elementBytes = rowBytes * layout.columns;
+        if (layout.stride == elementBytes) {
+            memcpy(out, layout.data, elementBytes * layout.count);
+        }
+        else {
+            for (size_t i = 0; i < layout.count; ++i) {
+                memcpy(out, layout.data + i * layout.stride, elementBytes);
+                out += layout.rows * layout.columns;
+            }
+        }
+        return;
+    }
+    for (size_t i = 0; i < layout.count; ++i) {
+        const unsigned char* element = layout.data + i * layout.stride;
+        for (size_t c = 0; c < layout.columns; ++c) {
+            const unsigned char* column = element + c * layout.columnStride;
+            for (size_t r = 0; r < layout.rows; ++r) {
+                S value;
+                memcpy(&value, column + r * sizeof(S), sizeof(S));
+                *out++ = normalize ? static_cast<T>(normalizedToFloat(value)) : static_cast<T>(value);
+            }
+        }
     }
-};
+}
 
-class OcclusionTextureInfo : public TextureInfo {
+/// Reads one element of N components of type S and converts them to T.
+/// Rows is the number of components in a column and ColumnStride is the number of bytes between columns.
+template<typename S, typename T, size_t N, bool Normalize, size_t Rows, size_t ColumnStride>
+static std::array<T, N> readElement(const unsigned char* p) noexcept {
+    std::array<T, N> element;
+    for (size_t i = 0; i < N; ++i) {
+        S value;
+        memcpy(&value, p + (i / Rows) * ColumnStride + (i % Rows) * sizeof(S), sizeof(S));
+        element[i] = Normalize ? static_cast<T>(normalizedToFloat(value)) : static_cast<T>(value);
+    }
+    return element;
+}
+
+/// A read only view of the elements of an Accessor that reads directly from the buffer data without
+/// copying the whole accessor. Each element is returned as N components converted to T.
+/// The component type is resolved once when the view is created so each element is read by a function
+/// that was specialized at compile time for that component type.
+/// The view becomes invalid when the Gltf object loads a new file or the buffer is evicted from the cache.
+template<typename T, size_t N>
+class AccessorView {
 public:
-    OcclusionTextureInfo() {}
-    OcclusionTextureInfo(const Gltf* gltf, const JsonValue* json) : TextureInfo(gltf, json) {}
+    using Element = std::array<T, N>;
 
-    float strength() const noexcept {
-        return findFloat("strength", 1.0f);
-    }
-};
+    /// Elements are read into a new array on every dereference so this is only an input iterator,
+    /// but it can still be moved by an offset and compared like a random access iterator.
+    class iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Element;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Element*;
+        using reference = Element;
 
-class Material : public Named {
-public:
-    Material() {}
-    Material(const Gltf* gltf, const JsonValue* json) : Named(gltf, json) {}
+        iterator() = default;
+        iterator(const AccessorView* view, size_t index) noexcept : m_view(view), m_index(index) {}
 
-    enum class AlphaMode {
-        OPAQUE,
-        MASK,
-        BLEND
+        Element operator*() const noexcept {
+            return (*m_view)[m_index];
+        }
+        Element operator[](difference_type n) const noexcept {
+            return (*m_view)[m_index + n];
+        }
+        iterator& operator++() noexcept {
+            ++m_index;
+            return *this;
+        }
+        iterator operator++(int) noexcept {
+            iterator it = *this;
+            ++m_index;
+            return it;
+        }
+        iterator& operator--() noexcept {
+            --m_index;
+            return *this;
+        }
+        iterator operator--(int) noexcept {
+            iterator it = *this;
+            --m_index;
+            return it;
+        }
+        iterator& operator+=(difference_type n) noexcept {
+            m_index += n;
+            return *this;
+        }
+        iterator& operator-=(difference_type n) noexcept {
+            m_index -= n;
+            return *this;
+        }
+        iterator operator+(difference_type n) const noexcept {
+            return iterator(m_view, m_index + n);
+        }
+        iterator operator-(difference_type n) const noexcept {
+            return iterator(m_view, m_index - n);
+        }
+        difference_type operator-(const iterator& rhs) const noexcept {
+            return static_cast<difference_type>(m_index) - static_cast<difference_type>(rhs.m_index);
+        }
+        bool operator==(const iterator& rhs) const noexcept {
+            return m_index == rhs.m_index && m_view == rhs.m_view;
+        }
+        bool operator!=(const iterator& rhs) const noexcept {
+            return !(*this == rhs);
+        }
+        bool operator<(const iterator& rhs) const noexcept {
+            return m_index < rhs.m_index;
+        }
+    private:
+        const AccessorView* m_view = nullptr;
+        size_t m_index = 0;
     };
 
-    PbrMetallicRoughness pbrMetallicRoughness() const noexcept {
-        return findObject<PbrMetallicRoughness>(m_gltf, m_json, "pbrMetallicRoughness");
+    AccessorView() = default;
+
+    /// Creates a view of an accessor.
+    /// The view is empty if the accessor doesn't have N components or its buffer could not be loaded.
+    /// Sparse accessors can't be read in place so the view is also empty for them; use Accessor::read().
+    explicit AccessorView(const Accessor& accessor) noexcept {
+        const Accessor::Type type = accessor.type();
+        if (!accessor || numberOfComponents(type) != N || accessor.sparse()) {
+            return;
+        }
+        const auto component = accessor.componentType();
+        const bool normalize = accessor.normalized() && std::is_floating_point<T>::value;
+        const bool matrix = numberOfColumns(type) > 1;
+        switch (component) {
+        case Accessor::ComponentType::BYTE: m_read = select<std::int8_t>(normalize, matrix); break;
+        case Accessor::ComponentType::UNSIGNED_BYTE: m_read = select<std::uint8_t>(normalize, matrix); break;
+        case Accessor::ComponentType::SHORT: m_read = select<std::int16_t>(normalize, matrix); break;
+        case Accessor::ComponentType::UNSIGNED_SHORT: m_read = select<std::uint16_t>(normalize, matrix); break;
+        case Accessor::ComponentType::UNSIGNED_INT: m_read = select<std::uint32_t>(normalize, matrix); break;
+        case Accessor::ComponentType::FLOAT: m_read = select<float>(normalize, matrix); break;
+        }
+        const size_t count = accessor.count();
+        const BufferView bufferView = accessor.bufferView();
+        if (!bufferView) {
+            // the spec says that an accessor without a bufferView is initialized with zeros
+            m_read = &zeroElement;
+            m_count = count;
+            return;
+        }
+        AccessorLayout layout = accessorLayout(type, component, normalize);
+        if (!bindLayout(layout, bufferView.data(), accessor.byteOffset(), count)) {
+            m_read = nullptr;
+            return;
+        }
+        m_data = layout.data;
+        m_stride = layout.stride;
+        m_count = count;
+    }
+
+    /// Returns the element at the given index. The index is not bounds checked.
+    Element operator[](size_t index) const noexcept {
+        return m_read(m_data + index * m_stride);
+    }
+    size_t size() const noexcept {
+        return m_count;
     }
-    NormalTextureInfo normalTexture() const noexcept {
-        return findObject<NormalTextureInfo>(m_gltf, m_json, "normalTexture");
+    bool empty() const noexcept {
+        return m_count == 0;
     }
-    OcclusionTextureInfo occlusionTexture() const noexcept {
-        return findObject<OcclusionTextureInfo>(m_gltf, m_json, "occlusionTexture");
+    /// Returns the number of bytes between elements.
+    size_t stride() const noexcept {
+        return m_stride;
     }
-    TextureInfo emissiveTexture() const noexcept {
-        return findObject<TextureInfo>(m_gltf, m_json, "emissiveTexture");
+    /// Returns true if the view can be read from.
+    operator bool() const noexcept {
+        return m_read != nullptr;
     }
-    bool emissiveFactor(float* emissive) const noexcept {
-        return copyFloats("emissiveFactor", 3, emissive);
+    iterator begin() const noexcept {
+        return iterator(this, 0);
     }
+    iterator end() const noexcept {
+        return iterator(this, m_count);
+    }
+private:
+    using ReadFunction = Element (*)(const unsigned char*);
 
-    std::array<float, 3> emissiveFactor() const noexcept {
-        std::array<float, 3> v;
-        if (!emissiveFactor(v.data())) {
-            v.fill(0.0f);
-        }
-        return v;
+    static Element zeroElement(const unsigned char*) noexcept {
+        Element element;
+        element.fill(T(0));
+        return element;
     }
 
-    AlphaMode alphaMode() const noexcept {
-        const char* s = str("alphaMode");
-        if (s != nullptr) {
-            switch (*s) {
-            case 'M': return AlphaMode::MASK;
-            case 'B': return AlphaMode::BLEND;
-            }
+    template<typename S>
+    static ReadFunction select(bool normalize, bool matrix) noexcept {
+        // square matrices have Rows components per column
+        static constexpr size_t rows = N == 4 ? 2 : N == 9 ? 3 : N == 16 ? 4 : N;
+        static constexpr size_t paddedStride = (rows * sizeof(S) + 3) & ~size_t(3);
+        if (matrix && paddedStride != rows * sizeof(S)) {
+            return normalize ? &readElement<S, T, N, true, rows, paddedStride> : &readElement<S, T, N, false, rows, paddedStride>;
         }
-        return AlphaMode::OPAQUE;
-    }
-    float alphaCutoff() const noexcept {
-        return findFloat("alphaCutoff", 0.5f);
-    }
-    bool doubleSided() const noexcept {
-        return findBool("doubleSided");
+        return normalize ? &readElement<S, T, N, true, N, N * sizeof(S)> : &readElement<S, T, N, false, N, N * sizeof(S)>;
     }
-};
 
-class MorphTarget : public Object {
-public:
-    MorphTarget() {}
-    MorphTarget(const Gltf* gltf, const JsonValue* json) : Object(gltf, json) {}
+    const unsigned char* m_data = nullptr;
+    size_t m_count = 0;
+    size_t m_stride = 0;
+    ReadFunction m_read = nullptr;
+};
 
-    size_t position() const noexcept {
-        return findNumberOrDefault(m_json, "POSITION", 0);
+/// Converts the components at the given layout to T.
+template<typename T>
+static void convertComponents(Accessor::ComponentType componentType, const AccessorLayout& layout, T* out) noexcept {
+    switch (componentType) {
+    case Accessor::ComponentType::BYTE: convertComponents<std::int8_t>(layout, out); break;
+    case Accessor::ComponentType::UNSIGNED_BYTE: convertComponents<std::uint8_t>(layout, out); break;
+    case Accessor::ComponentType::SHORT: convertComponents<std::int16_t>(layout, out); break;
+    case Accessor::ComponentType::UNSIGNED_SHORT: convertComponents<std::uint16_t>(layout, out); break;
+    case Accessor::ComponentType::UNSIGNED_INT: convertComponents<std::uint32_t>(layout, out); break;
+    case Accessor::ComponentType::FLOAT: convertComponents<float>(layout, out); break;
     }
-    size_t normal() const noexcept {
-        return findNumberOrDefault(m_json, "NORMAL", 0);
+}
+
+/// Copies N sparse values of each element to the element indices of type I.
+/// N is zero if the number of components isn't known at compile time.
+/// @return False if an index is out of range.
+template<typename I, size_t N, typename T>
+static bool scatterSparse(const unsigned char* indices, const T* values, size_t sparseCount, size_t components,
+                          size_t elementCount, T* out) noexcept {
+    const size_t n = N != 0 ? N : components;
+    for (size_t i = 0; i < sparseCount; ++i) {
+        I index;
+        memcpy(&index, indices + i * sizeof(I), sizeof(I));
+        if (index >= elementCount) {
+            return false;
+        }
+        std::copy(values + i * n, values + i * n + n, out + static_cast<size_t>(index) * n);
     }
-    size_t tangent() const noexcept {
-        return findNumberOrDefault(m_json, "TANGENT", 0);
+    return true;
+}
+
+template<typename I, typename T>
+static bool scatterSparse(const unsigned char* indices, const T* values, size_t sparseCount, size_t components,
+                          size_t elementCount, T* out) noexcept {
+    switch (components) {
+    case 1: return scatterSparse<I, 1>(indices, values, sparseCount, components, elementCount, out);
+    case 2: return scatterSparse<I, 2>(indices, values, sparseCount, components, elementCount, out);
+    case 3: return scatterSparse<I, 3>(indices, values, sparseCount, components, elementCount, out);
+    case 4: return scatterSparse<I, 4>(indices, values, sparseCount, components, elementCount, out);
+    default: return scatterSparse<I, 0>(indices, values, sparseCount, components, elementCount, out);
     }
-};
+}
 
-class Primitive : public Object {
+/// The local and world matrices of the nodes of a scene.
+/// build() flattens the node hierarchy so that every node comes after its parent. The levels near the roots are
+/// stored breadth first until a level has MIN_SUBTREES nodes, then the subtree of each node on that level is stored
+/// depth first in its own range. evaluate() computes the levels near the roots and then the subtrees in parallel.
+/// The node transforms are copied by build() so evaluate() doesn't read the JSON. All matrices are column major.
+/// Changing the transform of a node marks it dirty and update() only recomputes the dirty nodes and their descendants.
+class SceneTransforms {
 public:
-    Primitive() {}
-    Primitive(const Gltf* gltf, const JsonValue* json) : Object(gltf, json) {}
-
-    enum class Mode {
-        POINTS = 0,
-        LINES = 1,
-        LINE_LOOP = 2,
-        LINE_STRIP = 3,
-        TRIANGLES = 4,
-        TRIANGLE_STRIP = 5,
-        TRIANGLE_FAN = 6
+    enum : std::uint32_t {
+        NONE = 0xFFFFFFFF,
+        MIN_SUBTREES = 64,
+        /// Fewer nodes than this are evaluated on the calling thread because starting threads costs more.
+        MIN_PARALLEL_NODES = 4096
     };
 
-    Mode mode() const noexcept {
-        int value = 4;
-        findNumber(m_json, "mode", value);
-        switch (value) {
-        case 0: return Mode::POINTS;
-        case 1: return Mode::LINES;
-        case 2: return Mode::LINE_LOOP;
-        case 3: return Mode::LINE_STRIP;
-        case 4: return Mode::TRIANGLES;
-        case 5: return Mode::TRIANGLE_STRIP;
-        case 6: return Mode::TRIANGLE_FAN;
-        default: return Mode::TRIANGLES;
+    SceneTransforms() = default;
+    SceneTransforms(const Gltf& gltf, const Scene& scene) {
+        build(gltf, scene);
+    }
+
+    /// Flattens the node hierarchy of a scene and copies the node transforms.
+    /// A node that can be reached more than once, through a cycle or a second parent, is only added the first time.
+    /// @return False if the scene is empty.
+    bool build(const Gltf& gltf, const Scene& scene) {
+        const NodeHierarchy& hierarchy = gltf.hierarchy();
+        const size_t nodeCount = hierarchy.nodeCount();
+        m_nodes.clear();
+        m_parents.clear();
+        m_subtrees.clear();
+        m_hasMatrix.clear();
+        m_translation.clear();
+        m_rotation.clear();
+        m_scale.clear();
+        m_local.clear();
+        m_positions.assign(nodeCount, NONE);
+        // pairs of node index and parent position
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> level, next;
+        for (size_t root : scene.nodes()) {
+            if (root < nodeCount && m_positions[root] == NONE) {
+                m_positions[root] = 0; // queued; the position is set when the node is added
+                level.emplace_back(static_cast<std::uint32_t>(root), NONE);
+            }
         }
-    }
-
-    Accessor attribute(const char* attribute) const noexcept {
-        size_t value;
-        if (findNumberInMap(m_json, "attributes", attribute, value)) {
-            return m_gltf->accessor(value);
+        while (!level.empty() && level.size() < MIN_SUBTREES) {
+            next.clear();
+            for (const auto& entry : level) {
+                const std::uint32_t position = add(gltf.node(entry.first), entry.first, entry.second);
+                const std::uint32_t* children = hierarchy.children(entry.first);
+                for (size_t i = 0; i < hierarchy.childCount(entry.first); ++i) {
+                    if (m_positions[children[i]] == NONE) {
+                        m_positions[children[i]] = 0;
+                        next.emplace_back(children[i], position);
+                    }
+                }
+            }
+            level.swap(next);
         }
-        return Accessor();
-    }
-    /// Returns the list of attributes as a vector of pairs.
-    /// Pair.first is the attribute name and pair.second is the Accessor index.
-    std::vector<std::pair<const char*, size_t>> attributes() const noexcept {
-        std::vector<std::pair<const char*, size_t>> vec;
-        if (m_json != nullptr) {
-            auto it = m_json->FindMember("attributes");
-            if (it != m_json->MemberEnd() && it->value.IsObject()) {
-                vec.reserve(it->value.MemberCount());
-                for (auto member = it->value.MemberBegin(); member != it->value.MemberEnd(); ++member) {
-                    vec.emplace_back(member->name.GetString(), member->value.Get<size_t>());
+        m_subtrees.push_back(static_cast<std::uint32_t>(m_nodes.size()));
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> stack;
+        for (const auto& entry : level) {
+            stack.push_back(entry);
+            while (!stack.empty()) {
+                const auto top = stack.back();
+                stack.pop_back();
+                const std::uint32_t position = add(gltf.node(top.first), top.first, top.second);
+                const std::uint32_t* children = hierarchy.children(top.first);
+                // push in reverse so the first child is visited first
+                for (size_t i = hierarchy.childCount(top.first); i-- > 0; ) {
+                    if (m_positions[children[i]] == NONE) {
+                        m_positions[children[i]] = 0;
+                        stack.emplace_back(children[i], position);
+                    }
                 }
             }
+            m_subtrees.push_back(static_cast<std::uint32_t>(m_nodes.size()));
+        }
+        m_world.assign(m_local.size(), 0.0f);
+        // the descendants of a node in a subtree are the positions up to its end
+        m_ends.assign(m_nodes.size(), 0);
+        for (size_t i = m_nodes.size(); i-- > 0; ) {
+            m_ends[i] = std::max(m_ends[i], static_cast<std::uint32_t>(i + 1));
+            if (m_parents[i] != NONE && m_parents[i] >= m_subtrees[0]) {
+                m_ends[m_parents[i]] = std::max(m_ends[m_parents[i]], m_ends[i]);
+            }
+        }
+        m_dirty.assign(m_nodes.size(), 0);
+        m_subtreeDirty.assign(subtreeCount(), 0);
+        // update() can't allocate
+        m_work.reserve(subtreeCount());
+        m_topDirty = false;
+        m_evaluated = false;
+        return !m_nodes.empty();
+    }
+
+    /// Computes the local and world matrices of every node.
+    /// @param[in] threadCount The number of threads used for the subtrees. Zero uses std::thread::hardware_concurrency().
+    ///                        Scenes with fewer than MIN_PARALLEL_NODES nodes only use the calling thread.
+    void evaluate(size_t threadCount = 1) noexcept {
+        if (threadCount == 0) {
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+        if (m_nodes.size() < MIN_PARALLEL_NODES) {
+            threadCount = 1;
+        }
+        if (m_subtrees.empty()) {
+            return;
+        }
+        evaluate(0, m_subtrees[0]);
+        parallelFor(m_subtrees.size() - 1, threadCount, [this](size_t i) {
+            evaluate(m_subtrees[i], m_subtrees[i + 1]);
+        });
+        std::fill(m_dirty.begin(), m_dirty.end(), 0);
+        std::fill(m_subtreeDirty.begin(), m_subtreeDirty.end(), 0);
+        m_topDirty = false;
+        m_evaluated = true;
+    }
+
+    /// Recomputes the matrices of the dirty nodes and the world matrices of their descendants.
+    /// Subtrees without dirty nodes are skipped. Calls evaluate() if it wasn't called since build().
+    /// @param[in] threadCount The number of threads used for the subtrees. Zero uses std::thread::hardware_concurrency().
+    ///                        Fewer than MIN_PARALLEL_NODES nodes in dirty subtrees only use the calling thread.
+    void update(size_t threadCount = 1) noexcept {
+        if (!m_evaluated) {
+            evaluate(threadCount);
+            return;
+        }
+        if (threadCount == 0) {
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+        const size_t top = m_subtrees.empty() ? 0 : m_subtrees[0];
+        if (m_topDirty) {
+            // the levels near the roots aren't contiguous subtrees so the dirty flags are passed down
+            for (size_t i = 0; i < top; ++i) {
+                const std::uint32_t parent = m_parents[i];
+                if (m_dirty[i] || (parent != NONE && m_dirty[parent])) {
+                    m_dirty[i] = 1;
+                    evaluate(i, i + 1);
+                }
+            }
+            for (size_t i = 0; i < m_subtreeDirty.size(); ++i) {
+                const std::uint32_t parent = m_parents[m_subtrees[i]];
+                if (parent != NONE && m_dirty[parent]) {
+                    // the whole subtree moved
+                    m_dirty[m_subtrees[i]] = 1;
+                    m_subtreeDirty[i] = 1;
+                }
+            }
+        }
+        m_work.clear();
+        size_t workNodes = 0;
+        for (size_t i = 0; i < m_subtreeDirty.size(); ++i) {
+            if (m_subtreeDirty[i]) {
+                m_work.push_back(static_cast<std::uint32_t>(i));
+                workNodes += m_subtrees[i + 1] - m_subtrees[i];
+            }
+        }
+        if (workNodes < MIN_PARALLEL_NODES) {
+            threadCount = 1;
+        }
+        parallelFor(m_work.size(), threadCount, [this](size_t i) {
+            const size_t subtree = m_work[i];
+            for (size_t p = m_subtrees[subtree]; p < m_subtrees[subtree + 1]; ) {
+                if (m_dirty[p]) {
+                    evaluate(p, m_ends[p]);
+                    std::fill(m_dirty.begin() + p, m_dirty.begin() + m_ends[p], 0);
+                    p = m_ends[p];
+                }
+                else {
+                    ++p;
+                }
+            }
+            m_subtreeDirty[subtree] = 0;
+        });
+        if (m_topDirty) {
+            std::fill(m_dirty.begin(), m_dirty.begin() + top, 0);
+            m_topDirty = false;
         }
-        return vec;
     }
 
-    /// Returns the number of attributes in this primitive.
-    size_t attributeCount() const noexcept {
-        return count("attributes");
+    /// Sets the translation of the node at a position and marks it dirty.
+    /// A node that had a matrix uses its translation, rotation and scale from now on.
+    void setTranslation(size_t position, const float* t) noexcept {
+        std::copy(t, t + 3, &m_translation[position * 3]);
+        setDirty(position);
     }
-    /// Returns a list of attribute names from this primitive.
-    /// The char pointers in this list will be invalid when the root gltf object is destroyed 
-    /// or loads a new file. 
-    std::vector<const char*> attributeStrings() const noexcept {
-        return getKeys(m_json, "attributes");
+    /// Sets the rotation quaternion (x, y, z, w) of the node at a position and marks it dirty.
+    void setRotation(size_t position, const float* r) noexcept {
+        std::copy(r, r + 4, &m_rotation[position * 4]);
+        setDirty(position);
     }
-    Accessor position() const noexcept {
-        return attribute("POSITION");
+    /// Sets the scale of the node at a position and marks it dirty.
+    void setScale(size_t position, const float* s) noexcept {
+        std::copy(s, s + 3, &m_scale[position * 3]);
+        setDirty(position);
     }
-    Accessor normal() const noexcept {
-        return attribute("NORMAL");
+    /// Sets the local matrix of the node at a position and marks it dirty.
+    /// The translation, rotation and scale of the node are ignored until one of them is set.
+    void setMatrix(size_t position, const float* m) noexcept {
+        std::copy(m, m + 16, &m_local[position * 16]);
+        setDirty(position);
+        m_hasMatrix[position] = 1;
     }
-    Accessor tangent() const noexcept {
-        return attribute("TANGENT");
+    const float* translation(size_t position) const noexcept {
+        return &m_translation[position * 3];
     }
-    Accessor texcoord(size_t index) const noexcept {
-        // OpenGL ES 3.0 supports a min of 16 vertex attributes but I'm
-        // going to assume there won't be more than 10 of one type. For now.
-        assert(index < 10);
-        char attr[] = "TEXCOORD_0";
-        attr[9] += static_cast<char>(index);
-        return attribute(attr);
+    const float* rotation(size_t position) const noexcept {
+        return &m_rotation[position * 4];
     }
-    Accessor color(size_t index = 0) const noexcept {
-        assert(index < 10);
-        char attr[] = "COLOR_0";
-        attr[6] += static_cast<char>(index);
-        return attribute(attr);
+    const float* scale(size_t position) const noexcept {
+        return &m_scale[position * 3];
     }
-    Accessor joints(size_t index = 0) const noexcept {
-        assert(index < 10);
-        char attr[] = "JOINTS_0";
-        attr[7] += static_cast<char>(index);
-        return attribute(attr);
+    /// Returns true if the node at a position was changed since the last evaluate() or update().
+    bool dirty(size_t position) const noexcept {
+        return m_dirty[position] != 0;
     }
-    Accessor weights(size_t index = 0) const noexcept {
-        assert(index < 10);
-        char attr[] = "WEIGHTS_0";
-        attr[8] += static_cast<char>(index);
-        return attribute(attr);
+
+    /// Returns the number of nodes in the scene.
+    size_t size() const noexcept {
+        return m_nodes.size();
     }
-    Accessor indices() const noexcept {
-        size_t index;
-        if (findNumber(m_json, "indices", index)) {
-            return m_gltf->accessor(index);
-        }
-        return Accessor();
+    bool empty() const noexcept {
+        return m_nodes.empty();
     }
-    bool indices(size_t& index) const noexcept {
-        return findNumber(m_json, "indices", index);
+    /// Returns the index of the node at a position in the flattened hierarchy.
+    std::uint32_t node(size_t position) const noexcept {
+        return m_nodes[position];
     }
-    Material material() const noexcept {
-        size_t num;
-        if (findNumber<size_t>(m_json, "material", num)) {
-            return m_gltf->material(num);
-        }
-        return Material();
+    /// Returns the position of a node in the flattened hierarchy or NONE if the node isn't in the scene.
+    std::uint32_t position(size_t node) const noexcept {
+        return node < m_positions.size() ? m_positions[node] : NONE;
     }
-    bool material(size_t& index) const noexcept {
-        return findNumber<size_t>(m_json, "material", index);
+    /// Returns the position of the parent of the node at a position or NONE for root nodes.
+    std::uint32_t parent(size_t position) const noexcept {
+        return m_parents[position];
     }
-    MorphTarget target(size_t index) const noexcept {
-        return findObject<MorphTarget>(m_gltf, m_json, "targets", index);
+    /// Returns the number of subtrees that are evaluated in parallel.
+    size_t subtreeCount() const noexcept {
+        return m_subtrees.empty() ? 0 : m_subtrees.size() - 1;
     }
-    size_t targetCount() const noexcept {
-        return count("targets");
+    /// Returns the 16 floats of the local matrix of the node at a position.
+    const float* localMatrix(size_t position) const noexcept {
+        return &m_local[position * 16];
+    }
+    /// Returns the 16 floats of the world matrix of the node at a position. Call evaluate() or update() first.
+    const float* worldMatrix(size_t position) const noexcept {
+        return &m_world[position * 16];
+    }
+private:
+    void setDirty(size_t position) noexcept {
+        m_dirty[position] = 1;
+        m_hasMatrix[position] = 0;
+        if (position < m_subtrees[0]) {
+            m_topDirty = true;
+        }
+        else {
+            // the subtree that starts at or before the position
+            const auto it = std::upper_bound(m_subtrees.begin() + 1, m_subtrees.end(), position);
+            m_subtreeDirty[it - m_subtrees.begin() - 1] = 1;
+        }
     }
-};
-
-class Mesh : public Named {
-public:
-    Mesh() {}
-    Mesh(const Gltf* gltf, const JsonValue* json) : Named(gltf, json) {}
 
-    Primitive primitive(size_t index) const noexcept {
-        return findObject<Primitive>(m_gltf, m_json, "primitives", index);
+    /// Adds a node and copies its transform.
+    /// @return The position of the node.
+    std::uint32_t add(const Node& node, std::uint32_t index, std::uint32_t parent) {
+        static const float identity[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+        const std::uint32_t position = static_cast<std::uint32_t>(m_nodes.size());
+        m_positions[index] = position;
+        m_nodes.push_back(index);
+        m_parents.push_back(parent);
+        m_local.insert(m_local.end(), identity, identity + 16);
+        const bool hasMatrix = node.matrix(&m_local[position * 16]);
+        m_hasMatrix.push_back(hasMatrix ? 1 : 0);
+        float t[3] = { 0, 0, 0 };
+        float r[4] = { 0, 0, 0, 1 };
+        float s[3] = { 1, 1, 1 };
+        if (!hasMatrix) {
+            node.translation(t);
+            node.rotation(r);
+            node.scale(s);
+        }
+        m_translation.insert(m_translation.end(), t, t + 3);
+        m_rotation.insert(m_rotation.end(), r, r + 4);
+        m_scale.insert(m_scale.end(), s, s + 3);
+        return position;
     }
 
-    Primitive operator[](size_t index) const noexcept {
-        return primitive(index);
+    void evaluate(size_t begin, size_t end) noexcept {
+        for (size_t i = begin; i < end; ++i) {
+            float* local = &m_local[i * 16];
+            if (!m_hasMatrix[i]) {
+                composeMatrix(m_translation.data() + i * 3, m_rotation.data() + i * 4, m_scale.data() + i * 3, local);
+            }
+            float* world = &m_world[i * 16];
+            if (m_parents[i] == NONE) {
+                std::copy(local, local + 16, world);
+            }
+            else {
+                multiplyMatrices(&m_world[m_parents[i] * 16], local, world);
+            }
+        }
     }
 
-    std::vector<Primitive> primitives() const noexcept;
+    std::vector<std::uint32_t> m_nodes;
+    std::vector<std::uint32_t> m_parents;
+    std::vector<std::uint32_t> m_positions;
+    /// The end of the levels near the roots followed by the end of each subtree.
+    std::vector<std::uint32_t> m_subtrees;
+    std::vector<unsigned char> m_hasMatrix;
+    std::vector<float> m_translation;
+    std::vector<float> m_rotation;
+    std::vector<float> m_scale;
+    std::vector<float> m_local;
+    std::vector<float> m_world;
+    /// One past the last descendant of each node in a subtree.
+    std::vector<std::uint32_t> m_ends;
+    std::vector<unsigned char> m_dirty;
+    std::vector<unsigned char> m_subtreeDirty;
+    /// The dirty subtrees of an update.
+    std::vector<std::uint32_t> m_work;
+    bool m_topDirty = false;
+    bool m_evaluated = false;
+};
 
-    size_t primitiveCount() const noexcept {
-        return count("primitives");
+/// Computes the weights of quaternions a and b for slerp(a, b, t) from their dot product.
+/// The weight of b is negated when the dot product is negative so that the shortest path is used.
+inline void slerpWeights(float dot, float t, float& wa, float& wb) noexcept {
+    const float sign = dot < 0.0f ? -1.0f : 1.0f;
+    dot *= sign;
+    wa = 1.0f - t;
+    wb = t * sign;
+    if (dot < 0.9995f) {
+        const float theta = std::acos(dot);
+        const float sinTheta = std::sin(theta);
+        wa = std::sin(wa * theta) / sinTheta;
+        wb = std::sin(t * theta) / sinTheta * sign;
     }
+}
 
-    float weight(size_t index) const noexcept {
-        return findNumberOrDefault(m_json, "weights", index, 0.0f);
+/// Spherical linear interpolation of two unit quaternions (x, y, z, w) along the shortest path.
+/// Nearly equal quaternions are linearly interpolated. The result is normalized.
+/// Out may be the same array as a or b.
+inline void slerp(const float* a, const float* b, float t, float* out) noexcept {
+    float wa, wb;
+    slerpWeights(a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3], t, wa, wb);
+    float q[4];
+    float length = 0.0f;
+    for (size_t i = 0; i < 4; ++i) {
+        q[i] = wa * a[i] + wb * b[i];
+        length += q[i] * q[i];
+    }
+    const float scale = length > 0.0f ? 1.0f / std::sqrt(length) : 0.0f;
+    for (size_t i = 0; i < 4; ++i) {
+        out[i] = q[i] * scale;
     }
+}
 
-    bool weights(float* p, size_t count) const noexcept {
-        return copyFloats("weights", count, p);
+/// Packs a unit quaternion (x, y, z, w) into 48 bits with the smallest three encoding.
+/// The largest component is left out and made positive by negating the quaternion, which is the same rotation.
+/// The other three are in [-1/sqrt(2), 1/sqrt(2)] and are stored with 15 bits each. The 2 bit index of the
+/// largest component is stored in the top bits of out[0] and out[1].
+inline void packQuaternion(const float* q, std::uint16_t* out) noexcept {
+    size_t largest = 0;
+    for (size_t i = 1; i < 4; ++i) {
+        if (std::fabs(q[i]) > std::fabs(q[largest])) {
+            largest = i;
+        }
     }
-
-    size_t weightCount() const noexcept {
-        return count("weights");
+    const float sign = q[largest] < 0.0f ? -1.0f : 1.0f;
+    static const float range = 0.70710678f;
+    for (size_t i = 0, j = 0; i < 4; ++i) {
+        if (i != largest) {
+            const float c = std::min(std::max(q[i] * sign, -range), range);
+            out[j++] = static_cast<std::uint16_t>(std::lround((c + range) / (2.0f * range) * 32767.0f));
+        }
     }
-};
+    out[0] = static_cast<std::uint16_t>(out[0] | ((largest & 1) << 15));
+    out[1] = static_cast<std::uint16_t>(out[1] | ((largest >> 1) << 15));
+}
 
-class AnimationSampler : public Object {
-public:
-    AnimationSampler() {}
-    AnimationSampler(const Gltf* gltf, const JsonValue* json) : Object(gltf, json) {}
+/// Unpacks a quaternion that was packed with packQuaternion(). The result is normalized.
+inline void unpackQuaternion(const std::uint16_t* in, float* q) noexcept {
+    static const float range = 0.70710678f;
+    const size_t largest = ((in[0] >> 15) & 1) | (((in[1] >> 15) & 1) << 1);
+    float sum = 0.0f;
+    for (size_t i = 0, j = 0; i < 4; ++i) {
+        if (i != largest) {
+            q[i] = (in[j++] & 0x7FFF) / 32767.0f * (2.0f * range) - range;
+            sum += q[i] * q[i];
+        }
+    }
+    q[largest] = std::sqrt(std::max(1.0f - sum, 0.0f));
+    const float scale = 1.0f / std::sqrt(sum + q[largest] * q[largest]);
+    for (size_t i = 0; i < 4; ++i) {
+        q[i] *= scale;
+    }
+}
 
-    Accessor input() const noexcept {
-        size_t index;
-        if (input(index)) {
-            return m_gltf->accessor(index);
+/// Finds the keyframe k where times[k] <= time < times[k + 1], starting from the key that was found last time.
+/// Playing forward only looks at the next keys so it is O(1) per frame; other jumps use a binary search.
+/// @param[in]     times  The count ascending keyframe times, in seconds or in frames.
+/// @param[in,out] cursor The key that was found last time. It is updated to the key that is returned.
+/// @return A key in [0, count - 2] or 0 if there are fewer than two keys.
+template<typename T>
+size_t findKeyframe(const T* times, size_t count, float time, std::uint32_t& cursor) noexcept {
+    if (count < 2) {
+        cursor = 0;
+        return 0;
+    }
+    const size_t last = count - 2;
+    size_t k = cursor <= last ? cursor : 0;
+    if (times[k] <= time) {
+        // forward by at most two keys
+        for (size_t n = 0; n < 2 && k < last && times[k + 1] <= time; ++n) {
+            ++k;
+        }
+        if (k < last && times[k + 1] <= time) {
+            k = static_cast<size_t>(std::upper_bound(times + k + 1, times + count, time) - times) - 1;
         }
-        return Accessor();
     }
-    bool input(size_t& index) const noexcept {
-        return findNumber(m_json, "input", index);
+    else {
+        k = static_cast<size_t>(std::upper_bound(times, times + k, time) - times);
+        k = k > 0 ? k - 1 : 0;
     }
-    Accessor output() const noexcept {
-        size_t index;
-        if (output(index)) {
-            return m_gltf->accessor(index);
+    k = std::min(k, last);
+    cursor = static_cast<std::uint32_t>(k);
+    return k;
+}
+
+/// Finds keyframes in any order without a binary search over all of the times, for seeking and scrubbing.
+/// Uniformly spaced times are detected and the key is computed directly from the time. Otherwise the time range is
+/// split into one bucket per key and each bucket stores the first key that it overlaps, so a lookup only searches
+/// the keys of one bucket.
+/// The index doesn't keep a pointer to the times so they are passed to find().
+class KeyframeIndex {
+public:
+    KeyframeIndex() = default;
+    KeyframeIndex(const float* times, size_t count, float epsilon = 1e-4f) {
+        build(times, count, epsilon);
+    }
+
+    /// Builds the index of count ascending times.
+    /// @param[in] epsilon The times are uniform if each one is within epsilon of its uniformly spaced time.
+    void build(const float* times, size_t count, float epsilon = 1e-4f) {
+        m_count = count;
+        m_buckets.clear();
+        m_start = count > 0 ? times[0] : 0.0f;
+        m_scale = 0.0f;
+        m_uniform = false;
+        if (count < 2 || !(times[count - 1] > times[0])) {
+            return;
         }
-        return Accessor();
+        const float range = times[count - 1] - times[0];
+        const float step = range / (count - 1);
+        m_uniform = true;
+        for (size_t i = 1; i < count && m_uniform; ++i) {
+            m_uniform = std::fabs(times[i] - (m_start + i * step)) <= epsilon;
+        }
+        if (m_uniform) {
+            m_scale = 1.0f / step;
+            return;
+        }
+        // bucket b starts at m_start + b / m_scale
+        const size_t bucketCount = count - 1;
+        m_scale = bucketCount / range;
+        m_buckets.resize(bucketCount + 1);
+        size_t k = 0;
+        for (size_t b = 0; b < bucketCount; ++b) {
+            const float start = m_start + b / m_scale;
+            while (k + 2 < count && times[k + 1] <= start) {
+                ++k;
+            }
+            m_buckets[b] = static_cast<std::uint32_t>(k);
+        }
+        m_buckets[bucketCount] = static_cast<std::uint32_t>(count - 2);
     }
-    bool output(size_t& index) const noexcept {
-        return findNumber(m_json, "output", index);
+
+    /// Returns true if the times are uniformly spaced.
+    bool uniform() const noexcept {
+        return m_uniform;
     }
-    Interpolation interpolation() const noexcept {
-        const char* s = str("interpolation");
-        if (s != nullptr && *s != '\0') {
-            switch (s[1]) { // 2nd char
-            case 'T': return Interpolation::STEP;
-            case 'A': return Interpolation::CATMULLROMSPLINE;
-            case 'U': return Interpolation::CUBICSPLINE;
+    size_t size() const noexcept {
+        return m_count;
+    }
+
+    /// Finds the keyframe k where times[k] <= time < times[k + 1].
+    /// @param[in] times The times that the index was built from.
+    /// @return A key in [0, count - 2] or 0 if there are fewer than two keys or time isn't finite.
+    size_t find(const float* times, float time) const noexcept {
+        if (m_count < 2 || !std::isfinite(time) || time <= times[0]) {
+            return 0;
+        }
+        const size_t last = m_count - 2;
+        if (time >= times[last + 1]) {
+            return last;
+        }
+        const float position = (time - m_start) * m_scale;
+        size_t k;
+        if (m_uniform) {
+            k = std::min(static_cast<size_t>(position), last);
+            // correct the rounding of the computed key
+            while (k > 0 && times[k] > time) {
+                --k;
+            }
+            while (k < last && times[k + 1] <= time) {
+                ++k;
+            }
+            return k;
+        }
+        const size_t bucket = std::min(static_cast<size_t>(position), m_buckets.size() - 2);
+        const float* first = times + m_buckets[bucket];
+        const float* end = times + m_buckets[bucket + 1] + 2;
+        // the bucket of a time near a bucket boundary may be off by one because of rounding
+        if (*first > time) {
+            first = times;
+        }
+        if (end[-1] <= time) {
+            end = times + m_count;
+        }
+        k = static_cast<size_t>(std::upper_bound(first, end, time) - times);
+        return std::min(k > 0 ? k - 1 : 0, last);
+    }
+
+    /// Finds the keyframe k where times[k] <= time < times[k + 1], starting from the key that was found last time.
+    /// Playing forward only looks at the next keys; other jumps use the index.
+    /// @param[in,out] cursor The key that was found last time. It is updated to the key that is returned.
+    size_t find(const float* times, float time, std::uint32_t& cursor) const noexcept {
+        size_t k;
+        const size_t last = m_count < 2 ? 0 : m_count - 2;
+        if (cursor <= last && m_count >= 2 && times[cursor] <= time) {
+            k = cursor;
+            if (k < last && times[k + 1] <= time) {
+                ++k;
+                if (k < last && times[k + 1] <= time) {
+                    k = find(times, time);
+                }
             }
         }
-        return Interpolation::LINEAR;
-    }
-    const char* interpolationStr() const noexcept {
-        return str("interpolation");
+        else {
+            k = find(times, time);
+        }
+        cursor = static_cast<std::uint32_t>(k);
+        return k;
     }
+private:
+    size_t m_count = 0;
+    float m_start = 0.0f;
+    /// Keys per second when uniform or buckets per second.
+    float m_scale = 0.0f;
+    bool m_uniform = false;
+    /// The key at the start of each bucket and the last key.
+    std::vector<std::uint32_t> m_buckets;
 };
 
-class Channel : public Object {
+/// The local translation, rotation and scale of the nodes of many instances of a model as structure of arrays.
+/// Each component of each node has an array with one float per instance so that the instances can be
+/// processed together with SIMD. The rotations are quaternions (x, y, z, w).
+class PoseBatch {
 public:
-    Channel() {}
-    Channel(const Gltf* gltf, const JsonValue* json, const JsonValue* animation) : Object(gltf, json), animation(animation) {}
-
-    class Target : public Object {
-    public:
-        Target() {}
-        Target(const Gltf* gltf, const JsonValue* json) : Object(gltf, json) {}
+    PoseBatch() = default;
+    PoseBatch(size_t nodeCount, size_t instanceCount) {
+        resize(nodeCount, instanceCount);
+    }
+
+    /// Resizes the arrays and sets every node of every instance to the identity transform.
+    void resize(size_t nodeCount, size_t instanceCount) {
+        m_nodeCount = nodeCount;
+        m_instanceCount = instanceCount;
+        m_translation.assign(nodeCount * 3 * instanceCount, 0.0f);
+        m_rotation.assign(nodeCount * 4 * instanceCount, 0.0f);
+        m_scale.assign(nodeCount * 3 * instanceCount, 1.0f);
+        for (size_t node = 0; node < nodeCount; ++node) {
+            std::fill_n(rotation(node, 3), instanceCount, 1.0f);
+        }
+    }
 
-        Node node() const noexcept {
-            size_t index;
-            if (node(index)) {
-                return m_gltf->node(index);
+    /// Copies the translation, rotation and scale of the nodes of a Gltf to every instance.
+    /// Nodes that have a matrix and nodes past nodeCount() are left alone.
+    void setRestPose(const Gltf& gltf) noexcept {
+        const size_t count = std::min(m_nodeCount, gltf.nodeCount());
+        for (size_t node = 0; node < count; ++node) {
+            const Node n = gltf.node(node);
+            float t[3] = { 0, 0, 0 };
+            float r[4] = { 0, 0, 0, 1 };
+            float s[3] = { 1, 1, 1 };
+            float m[16];
+            if (n.matrix(m)) {
+                continue;
             }
-            return Node();
-        }
-        bool node(size_t& index) const noexcept {
-            return findNumber(m_json, "node", index);
-        }
-        TargetPath path() const noexcept {
-            const char* s = str("path");
-            if (s != nullptr) {
-                switch (*s) {
-                case 'r': return TargetPath::ROTATION;
-                case 's': return TargetPath::SCALE;
-                case 'w': return TargetPath::WEIGHTS;
+            n.translation(t);
+            n.rotation(r);
+            n.scale(s);
+            for (size_t c = 0; c < 4; ++c) {
+                if (c < 3) {
+                    std::fill_n(translation(node, c), m_instanceCount, t[c]);
+                    std::fill_n(scale(node, c), m_instanceCount, s[c]);
                 }
+                std::fill_n(rotation(node, c), m_instanceCount, r[c]);
             }
-            return TargetPath::TRANSLATION;
-        }
-        const char* pathStr() const noexcept {
-            return str("path");
         }
-    };
+    }
 
-    AnimationSampler sampler() const noexcept {
-        size_t index;
-        if (sampler(index)) {
-            assert(animation);
-            return findObject<AnimationSampler>(m_gltf, animation, "samplers", index);
-        }
-        return AnimationSampler();
+    size_t nodeCount() const noexcept {
+        return m_nodeCount;
     }
-    bool sampler(size_t& index) const noexcept {
-        return findNumber(m_json, "sampler", index);
+    size_t instanceCount() const noexcept {
+        return m_instanceCount;
     }
-    Channel::Target target() const noexcept {
-        return findObject<Channel::Target>(m_gltf, m_json, "target");
+    /// Returns the instanceCount() values of one component of the translation of a node.
+    float* translation(size_t node, size_t component) noexcept {
+        return &m_translation[(node * 3 + component) * m_instanceCount];
+    }
+    const float* translation(size_t node, size_t component) const noexcept {
+        return &m_translation[(node * 3 + component) * m_instanceCount];
+    }
+    /// Returns the instanceCount() values of one component of the rotation of a node.
+    float* rotation(size_t node, size_t component) noexcept {
+        return &m_rotation[(node * 4 + component) * m_instanceCount];
+    }
+    const float* rotation(size_t node, size_t component) const noexcept {
+        return &m_rotation[(node * 4 + component) * m_instanceCount];
+    }
+    /// Returns the instanceCount() values of one component of the scale of a node.
+    float* scale(size_t node, size_t component) noexcept {
+        return &m_scale[(node * 3 + component) * m_instanceCount];
+    }
+    const float* scale(size_t node, size_t component) const noexcept {
+        return &m_scale[(node * 3 + component) * m_instanceCount];
     }
 private:
-    /// Pointer to the parent animation json object
-    const JsonValue* animation = nullptr;
+    size_t m_nodeCount = 0;
+    size_t m_instanceCount = 0;
+    std::vector<float> m_translation;
+    std::vector<float> m_rotation;
+    std::vector<float> m_scale;
 };
 
-// TODO move this?
-static Channel findChannel(const Gltf* gltf, const JsonValue* json, size_t index) {
-    if (json != nullptr) {
-        auto it = json->FindMember("channels");
-        if (it != json->MemberEnd() && it->value.IsArray() && index < it->value.Size()) {
-            const auto& v = it->value[index];
-            if (v.IsObject()) {
-                return Channel(gltf, &v, json);
-            }
-        }
-    }
-    return Channel();
-}
-
-class Animation : public Named {
+/// Evaluates the channels of an Animation.
+/// load() reads the sampler data once into contiguous float arrays, so sampling doesn't touch the JSON or the
+/// accessors. Each channel is sampled with a cursor that remembers the last keyframe; keep one cursor per channel
+/// for each playing instance of the animation. Jumps are found with a KeyframeIndex of each sampler.
+class AnimationEvaluator {
 public:
-    Animation() {}
-    Animation(const Gltf* gltf, const JsonValue* json) : Named(gltf, json) {}
+    enum : std::uint32_t {
+        NONE = 0xFFFFFFFF
+    };
 
-    Channel channel(size_t index) const noexcept {
-        return findChannel(m_gltf, m_json, index);
+    struct Sampler {
+        Interpolation interpolation = Interpolation::LINEAR;
+        /// The first time in times().
+        std::uint32_t keyOffset = 0;
+        std::uint32_t keyCount = 0;
+        /// The first value in values(). CUBICSPLINE samplers have an in-tangent, value and out-tangent per key.
+        std::uint32_t valueOffset = 0;
+        /// The number of floats in a value.
+        std::uint32_t components = 0;
+    };
+
+    struct Channel {
+        /// The index of the channel in the Animation.
+        std::uint32_t index = NONE;
+        std::uint32_t sampler = NONE;
+        /// The target node or NONE.
+        std::uint32_t node = NONE;
+        TargetPath path = TargetPath::TRANSLATION;
+    };
+
+    AnimationEvaluator() = default;
+    explicit AnimationEvaluator(const Animation& animation) {
+        load(animation);
     }
+
+    /// Reads the keyframes of every sampler of an animation.
+    /// Channels whose sampler can't be read are left out, so use Channel::index to find the glTF channel.
+    /// @return False if the animation is empty or a sampler couldn't be read.
+    bool load(const Animation& animation);
+
     size_t channelCount() const noexcept {
-        return count("channels");
+        return m_channels.size();
     }
-    AnimationSampler sampler(size_t index) const noexcept {
-        return findObject<AnimationSampler>(m_gltf, m_json, "samplers", index);
+    const Channel& channel(size_t index) const noexcept {
+        return m_channels[index];
     }
     size_t samplerCount() const noexcept {
-        return count("samplers");
+        return m_samplers.size();
+    }
+    const Sampler& sampler(size_t index) const noexcept {
+        return m_samplers[index];
+    }
+    /// Returns the index that finds the keyframes of a sampler when seeking.
+    const KeyframeIndex& keyframeIndex(size_t sampler) const noexcept {
+        return m_indices[sampler];
+    }
+    /// Returns the number of floats that are written when sampling a channel.
+    size_t components(size_t channel) const noexcept {
+        return m_samplers[m_channels[channel].sampler].components;
+    }
+    /// Returns the largest keyframe time of all samplers.
+    float duration() const noexcept {
+        return m_duration;
+    }
+    const std::vector<float>& times() const noexcept {
+        return m_times;
+    }
+    const std::vector<float>& values() const noexcept {
+        return m_values;
+    }
+
+    /// Samples a channel. Times before the first key or after the last key are clamped.
+    /// Rotations use slerp when the interpolation is LINEAR and are normalized after CUBICSPLINE interpolation.
+    /// @param[in]     channel The channel index.
+    /// @param[in]     time    The time in seconds.
+    /// @param[in,out] cursor  The keyframe cursor of the channel. Start with zero.
+    /// @param[out]    out     Array of components(channel) floats.
+    void sample(size_t channel, float time, std::uint32_t& cursor, float* out) const noexcept {
+        const Channel& c = m_channels[channel];
+        sampleSampler(c.sampler, c.path == TargetPath::ROTATION, time, cursor, out);
+    }
+
+    /// Samples every channel with one cursor per channel.
+    /// @param[in,out] cursors channelCount() cursors. Start with zeros.
+    /// @param[out]    out     The values of the channels one after the other.
+    void sample(float time, std::uint32_t* cursors, float* out) const noexcept {
+        for (size_t i = 0; i < m_channels.size(); ++i) {
+            sample(i, time, cursors[i], out);
+            out += components(i);
+        }
+    }
+
+    /// Samples the translation, rotation and scale channels for many instances that play this animation at
+    /// different times. LINEAR channels are interpolated four instances at a time with SSE2 when it is enabled.
+    /// Weights channels and channels whose node is past pose.nodeCount() are skipped.
+    /// @param[in]     times   pose.instanceCount() times, one per instance.
+    /// @param[in,out] cursors channelCount() * pose.instanceCount() cursors, the cursors of all the instances for
+    ///                        each channel one after the other. Start with zeros.
+    /// @param[out]    pose    The nodes that are targeted by the channels are written.
+    void sampleBatch(const float* times, std::uint32_t* cursors, PoseBatch& pose) const noexcept {
+        const size_t count = pose.instanceCount();
+        for (size_t c = 0; c < m_channels.size(); ++c) {
+            const Channel& channel = m_channels[c];
+            const Sampler& s = m_samplers[channel.sampler];
+            const bool rotation = channel.path == TargetPath::ROTATION;
+            const size_t n = rotation ? 4 : 3;
+            if (channel.node >= pose.nodeCount() || channel.path == TargetPath::WEIGHTS || s.components != n) {
+                continue;
+            }
+            float* out[4];
+            for (size_t i = 0; i < n; ++i) {
+                out[i] = rotation ? pose.rotation(channel.node, i)
+                    : channel.path == TargetPath::SCALE ? pose.scale(channel.node, i)
+                    : pose.translation(channel.node, i);
+            }
+            std::uint32_t* channelCursors = cursors + c * count;
+            size_t i = 0;
+            if (s.interpolation == Interpolation::LINEAR && s.keyCount >= 2) {
+                for (; i + 4 <= count; i += 4) {
+                    sampleLinear4(channel.sampler, rotation, times + i, channelCursors + i, out, i);
+                }
+            }
+            for (; i < count; ++i) {
+                float v[4];
+                sampleSampler(channel.sampler, rotation, times[i], channelCursors[i], v);
+                for (size_t j = 0; j < n; ++j) {
+                    out[j][i] = v[j];
+                }
+            }
+        }
+    }
+
+    /// Samples a sampler.
+    /// @param[in] rotation True if the values are quaternions.
+    void sampleSampler(size_t sampler, bool rotation, float time, std::uint32_t& cursor, float* out) const noexcept {
+        const Sampler& s = m_samplers[sampler];
+        const float* times = m_times.data() + s.keyOffset;
+        const size_t n = s.components;
+        const bool cubic = s.interpolation == Interpolation::CUBICSPLINE;
+        // the value of a key skips the in-tangent of cubic splines
+        const size_t keyStride = cubic ? n * 3 : n;
+        const float* values = m_values.data() + s.valueOffset + (cubic ? n : 0);
+        const size_t k = m_indices[sampler].find(times, time, cursor);
+        if (s.keyCount < 2 || time <= times[0]) {
+            std::copy(values, values + n, out);
+            return;
+        }
+        if (time >= times[s.keyCount - 1]) {
+            const float* v = values + (s.keyCount - 1) * keyStride;
+            std::copy(v, v + n, out);
+            return;
+        }
+        const float* v0 = values + k * keyStride;
+        const float* v1 = v0 + keyStride;
+        const float dt = times[k + 1] - times[k];
+        const float t = dt > 0.0f ? (time - times[k]) / dt : 0.0f;
+        switch (s.interpolation) {
+        case Interpolation::STEP:
+            std::copy(v0, v0 + n, out);
+            break;
+        case Interpolation::CUBICSPLINE: {
+            const float t2 = t * t;
+            const float t3 = t2 * t;
+            const float h00 = 2.0f * t3 - 3.0f * t2 + 1.0f;
+            const float h10 = (t3 - 2.0f * t2 + t) * dt;
+            const float h01 = -2.0f * t3 + 3.0f * t2;
+            const float h11 = (t3 - t2) * dt;
+            // the out-tangent of key k and the in-tangent of key k + 1
+            const float* b0 = v0 + n;
+            const float* a1 = v1 - n;
+            float length = 0.0f;
+            for (size_t i = 0; i < n; ++i) {
+                out[i] = h00 * v0[i] + h10 * b0[i] + h01 * v1[i] + h11 * a1[i];
+                length += out[i] * out[i];
+            }
+            if (rotation && length > 0.0f) {
+                const float scale = 1.0f / std::sqrt(length);
+                for (size_t i = 0; i < n; ++i) {
+                    out[i] *= scale;
+                }
+            }
+            break;
+        }
+        default:
+            if (rotation && n == 4) {
+                slerp(v0, v1, t, out);
+            }
+            else {
+                for (size_t i = 0; i < n; ++i) {
+                    out[i] = v0[i] + (v1[i] - v0[i]) * t;
+                }
+            }
+            break;
+        }
+    }
+private:
+    /// Linearly interpolates a sampler for four instances and writes component j of instance i to out[j][first + i].
+    void sampleLinear4(size_t sampler, bool rotation, const float* times, std::uint32_t* cursors, float* const* out,
+                       size_t first) const noexcept {
+        const Sampler& s = m_samplers[sampler];
+        const KeyframeIndex& index = m_indices[sampler];
+        const size_t n = rotation ? 4 : 3;
+        const float* keys = m_times.data() + s.keyOffset;
+        const float* values = m_values.data() + s.valueOffset;
+        // the values of the two keys of each instance transposed so that each component is a row
+        alignas(16) float a[4][4];
+        alignas(16) float b[4][4];
+        alignas(16) float w[4];
+        for (size_t i = 0; i < 4; ++i) {
+            const size_t k = index.find(keys, times[i], cursors[i]);
+            const float dt = keys[k + 1] - keys[k];
+            // clamping also handles the times before the first key and after the last key
+            w[i] = dt > 0.0f ? std::min(std::max((times[i] - keys[k]) / dt, 0.0f), 1.0f) : 0.0f;
+            for (size_t j = 0; j < n; ++j) {
+                a[j][i] = values[k * n + j];
+                b[j][i] = values[(k + 1) * n + j];
+            }
+        }
+        if (rotation) {
+            // the trigonometry of the slerp weights is scalar; blending and normalizing is done with SIMD
+            alignas(16) float wa[4];
+            alignas(16) float wb[4];
+            for (size_t i = 0; i < 4; ++i) {
+                const float dot = a[0][i] * b[0][i] + a[1][i] * b[1][i] + a[2][i] * b[2][i] + a[3][i] * b[3][i];
+                slerpWeights(dot, w[i], wa[i], wb[i]);
+            }
+#if defined(LAZY_GLTF2_SSE2)
+            const __m128 va = _mm_load_ps(wa);
+            const __m128 vb = _mm_load_ps(wb);
+            __m128 q[4];
+            __m128 length = _mm_setzero_ps();
+            for (size_t j = 0; j < 4; ++j) {
+                q[j] = _mm_add_ps(_mm_mul_ps(va, _mm_load_ps(a[j])), _mm_mul_ps(vb, _mm_load_ps(b[j])));
+                length = _mm_add_ps(length, _mm_mul_ps(q[j], q[j]));
+            }
+            const __m128 scale = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(length));
+            for (size_t j = 0; j < 4; ++j) {
+                _mm_storeu_ps(out[j] + first, _mm_mul_ps(q[j], scale));
+            }
+#else
+            for (size_t i = 0; i < 4; ++i) {
+                float q[4];
+                float length = 0.0f;
+                for (size_t j = 0; j < 4; ++j) {
+                    q[j] = wa[i] * a[j][i] + wb[i] * b[j][i];
+                    length += q[j] * q[j];
+                }
+                const float scale = 1.0f / std::sqrt(length);
+                for (size_t j = 0; j < 4; ++j) {
+                    out[j][first + i] = q[j] * scale;
+                }
+            }
+#endif
+            return;
+        }
+#if defined(LAZY_GLTF2_SSE2)
+        const __m128 t = _mm_load_ps(w);
+        for (size_t j = 0; j < n; ++j) {
+            const __m128 v0 = _mm_load_ps(a[j]);
+            _mm_storeu_ps(out[j] + first, _mm_add_ps(v0, _mm_mul_ps(_mm_sub_ps(_mm_load_ps(b[j]), v0), t)));
+        }
+#else
+        for (size_t j = 0; j < n; ++j) {
+            for (size_t i = 0; i < 4; ++i) {
+                out[j][first + i] = a[j][i] + (b[j][i] - a[j][i]) * w[i];
+            }
+        }
+#endif
     }
+
+    std::vector<Channel> m_channels;
+    std::vector<Sampler> m_samplers;
+    std::vector<KeyframeIndex> m_indices;
+    std::vector<float> m_times;
+    std::vector<float> m_values;
+    float m_duration = 0.0f;
 };
 
-// functions
+/// An animation that was resampled to a fixed frame rate, with the keys that can be interpolated from their
+/// neighbours removed and the values quantized to 16 bits.
+/// Rotations are packed in 48 bits with packQuaternion(). Translations, scales and weights are quantized to the
+/// range of the values of each component of a track. The sampled values are interpolated linearly, or with slerp
+/// for rotations, whatever the interpolation of the source sampler was.
+class CompressedAnimation {
+public:
+    enum : std::uint32_t {
+        NONE = 0xFFFFFFFF,
+        /// The most frames between two rotation keys. Each candidate rotation key checks every frame back to
+        /// the previous key so this keeps the key reduction linear in the number of frames.
+        MAX_ROTATION_KEY_GAP = 64
+    };
 
-template<typename T = size_t>
-T numberOfComponents(Accessor::Type type) noexcept {
-    switch (type) {
-    case Accessor::Type::SCALAR: return 1;
-    case Accessor::Type::VEC2: return 2;
-    case Accessor::Type::VEC3: return 3;
-    case Accessor::Type::VEC4: return 4;
-    case Accessor::Type::MAT2: return 4;
-    case Accessor::Type::MAT3: return 9;
-    case Accessor::Type::MAT4: return 16;
-    default:
-        return 0;
+    struct Track {
+        /// The index of the channel in the Animation.
+        std::uint32_t channel = NONE;
+        /// The target node or NONE.
+        std::uint32_t node = NONE;
+        TargetPath path = TargetPath::TRANSLATION;
+        /// The number of floats in a value.
+        std::uint32_t components = 0;
+        /// The first frame number in frames().
+        std::uint32_t keyOffset = 0;
+        std::uint32_t keyCount = 0;
+        /// The first quantized value in values(). Rotations use 3 values per key and the others use components.
+        std::uint32_t valueOffset = 0;
+        /// The minimum and the extent of each component in ranges(). Not used by rotations.
+        std::uint32_t rangeOffset = 0;
+    };
+
+    CompressedAnimation() = default;
+
+    /// Resamples every channel of an animation, removes keys and quantizes the values.
+    /// @param[in] animation The animation to compress.
+    /// @param[in] frameRate The number of samples per second.
+    /// @param[in] tolerance A key is removed when interpolating its neighbours doesn't change any component of
+    ///                      the resampled values by more than this. Rotations are compared as quaternions
+    ///                      and keep at least one key every MAX_ROTATION_KEY_GAP frames.
+    /// @return False if the frame rate isn't positive.
+    bool build(const AnimationEvaluator& animation, float frameRate, float tolerance);
+
+    size_t trackCount() const noexcept {
+        return m_tracks.size();
+    }
+    const Track& track(size_t index) const noexcept {
+        return m_tracks[index];
+    }
+    float frameRate() const noexcept {
+        return m_frameRate;
+    }
+    float duration() const noexcept {
+        return m_duration;
+    }
+    const std::vector<std::uint32_t>& frames() const noexcept {
+        return m_frames;
+    }
+    const std::vector<std::uint16_t>& values() const noexcept {
+        return m_values;
+    }
+    const std::vector<float>& ranges() const noexcept {
+        return m_ranges;
+    }
+    /// Returns the number of bytes used by the keys, values and ranges.
+    size_t byteSize() const noexcept {
+        return m_tracks.size() * sizeof(Track) + m_frames.size() * sizeof(std::uint32_t)
+            + m_values.size() * sizeof(std::uint16_t) + m_ranges.size() * sizeof(float);
+    }
+
+    /// Samples a track. Times outside the animation are clamped.
+    /// @param[in,out] cursor The keyframe cursor of the track. Start with zero.
+    /// @param[out]    out    Array of track(index).components floats.
+    void sample(size_t index, float time, std::uint32_t& cursor, float* out) const noexcept {
+        const Track& track = m_tracks[index];
+        const std::uint32_t* frames = m_frames.data() + track.keyOffset;
+        const float frame = time * m_frameRate;
+        const size_t k = findKeyframe(frames, track.keyCount, frame, cursor);
+        float t = 0.0f;
+        size_t next = k;
+        if (track.keyCount > 1) {
+            next = k + 1;
+            t = std::min(std::max((frame - frames[k]) / (frames[next] - frames[k]), 0.0f), 1.0f);
+        }
+        if (track.path == TargetPath::ROTATION) {
+            float a[4], b[4];
+            unpackQuaternion(&m_values[track.valueOffset + k * 3], a);
+            unpackQuaternion(&m_values[track.valueOffset + next * 3], b);
+            slerp(a, b, t, out);
+            return;
+        }
+        const size_t n = track.components;
+        const std::uint16_t* v0 = &m_values[track.valueOffset + k * n];
+        const std::uint16_t* v1 = &m_values[track.valueOffset + next * n];
+        const float* ranges = &m_ranges[track.rangeOffset];
+        for (size_t i = 0; i < n; ++i) {
+            const float scale = ranges[i * 2 + 1] / 65535.0f;
+            const float a = ranges[i * 2] + v0[i] * scale;
+            const float b = ranges[i * 2] + v1[i] * scale;
+            out[i] = a + (b - a) * t;
+        }
     }
-}
+private:
+    std::vector<Track> m_tracks;
+    std::vector<std::uint32_t> m_frames;
+    std::vector<std::uint16_t> m_values;
+    std::vector<float> m_ranges;
+    float m_frameRate = 0.0f;
+    float m_duration = 0.0f;
+};
 
 // impl
 
@@ -1844,31 +5347,119 @@ inline bool Gltf::load(const char* path) noexcept {
         return false;
     }
     clear();
+    m_loadId = nextLoadId();
     size_t len = strlen(path);
     if (lowercase(path[len - 1]) == 'b') { // .glb
-        return loadGlbMetaData(path);
+        return m_memoryMapping ? loadMappedGlb(path) : loadGlbMetaData(path);
     }
-    unique_file_ptr file(fopen(path, "rb"));
-    FILE* fp = file.get();
-    if (!fp) {
+    const auto file = fileSystem().open(path);
+    if (!file) {
         return false;
+    }
+    if (m_inSituParsing) {
+        const size_t size = file->size();
+        m_json.resize(size + 1);
+        if (file->read(0, m_json.data(), size) != size) {
+            return false;
+        }
+        parseInSitu(size);
+        m_baseDir.assign(dirName(path));
+        return true;
     }
 	std::array<char, 16384> readBuffer;
-    rapidjson::FileReadStream is(fp, readBuffer.data(), readBuffer.size());
+    InputFileStream is(*file, readBuffer.data(), readBuffer.size());
 
-    m_doc.reset(new JsonDocument());
-    m_doc->ParseStream(is);
+    parseStream(is);
     m_baseDir.assign(dirName(path));
     return true;
 }
 
+inline bool Gltf::load(const void* data, size_t size, UriResolver resolver) noexcept {
+    if (data == nullptr || size == 0) {
+        return false;
+    }
+    clear();
+    m_uriResolver = std::move(resolver);
+    m_loadedFromMemory = true;
+    m_loadId = nextLoadId();
+    if (size >= sizeof(MAGIC)) {
+        std::uint32_t magic;
+        memcpy(&magic, data, sizeof(magic));
+        if (magic == MAGIC) {
+            std::unique_ptr<GlbData> glb(new GlbData());
+            glb->bytes = DataView(static_cast<const unsigned char*>(data), size);
+            return parseGlb(std::move(glb), m_inSituParsing);
+        }
+    }
+    if (m_inSituParsing) {
+        const char* text = static_cast<const char*>(data);
+        m_json.reserve(size + 1);
+        m_json.assign(text, text + size);
+        m_json.push_back('\0');
+        parseInSitu(size);
+    }
+    else {
+        rapidjson::MemoryStream stream(static_cast<const char*>(data), size);
+        parseStream(stream);
+    }
+    return true;
+}
+
+inline void Gltf::createDocument() {
+    m_docArena = m_arena;
+    if (m_docArena) {
+        m_docArena->reset();
+        m_doc.reset(new JsonDocument(&m_docArena->allocator()));
+    }
+    else {
+        m_doc.reset(new JsonDocument());
+    }
+}
+
+inline void Gltf::parseInSitu(size_t size) {
+    m_json[size] = '\0';
+    createDocument();
+    m_doc->ParseInsitu(m_json.data());
+    resolveCollections();
+}
+
+inline void Gltf::resolveCollections() noexcept {
+    static const JsonKey keys[] = {
+        "scenes",
+        "nodes",
+        "meshes",
+        "cameras",
+        "accessors",
+        "buffers",
+        "bufferViews",
+        "animations",
+        "images",
+        "textures",
+        "samplers",
+        "materials",
+        "skins",
+    };
+    static_assert(sizeof(keys) / sizeof(keys[0]) == static_cast<size_t>(Collection::COUNT), "missing collection key");
+    m_collections.fill(CollectionTable());
+    const JsonDocument* doc = m_doc ? m_doc.get() : m_stubs.get();
+    if (doc != nullptr && doc->IsObject()) {
+        for (size_t i = 0; i < m_collections.size(); ++i) {
+            const auto it = findMember(*doc, keys[i]);
+            if (it != doc->MemberEnd() && it->value.IsArray() && !it->value.Empty()) {
+                m_collections[i].values = &it->value[0];
+                m_collections[i].size = it->value.Size();
+            }
+        }
+    }
+}
+
 inline Scene Gltf::scene() const noexcept {
     return defaultScene();
 }
 
 inline Scene Gltf::defaultScene() const noexcept {
     if (m_doc) {
-        const auto& it = m_doc->FindMember("scene");
+        const auto& it = findMember(*m_doc, "scene");
         if (it != m_doc->MemberEnd()) {
             if (it->value.IsNumber()) {
                 return scene(it->value.GetUint());
@@ -1879,136 +5470,368 @@ inline Scene Gltf::defaultScene() const noexcept {
 }
 
 inline Scene Gltf::scene(size_t index) const noexcept {
-    return findGltfObject<Scene>(this, "scenes", index);
+    return findGltfObject<Scene>(this, Collection::SCENES, index);
 }
 
 inline std::vector<Scene> Gltf::scenes() const noexcept {
-    return getObjectVector<Scene>(this, "scenes");
+    return getObjectVector<Scene>(this, Collection::SCENES);
 }
 
 inline Node Gltf::node(size_t index) const noexcept {
-    return findGltfObject<Node>(this, "nodes", index);
+    return findGltfObject<Node>(this, Collection::NODES, index);
 }
 
 inline std::vector<Node> Gltf::nodes() const noexcept {
-    return getObjectVector<Node>(this, "nodes");
+    return getObjectVector<Node>(this, Collection::NODES);
 }
 
 inline Mesh Gltf::mesh(size_t index) const noexcept {
-    return findGltfObject<Mesh>(this, "meshes", index);
+    return findGltfObject<Mesh>(this, Collection::MESHES, index);
 }
 
 inline std::vector<Mesh> Gltf::meshes() const noexcept {
-    return getObjectVector<Mesh>(this, "meshes");
+    return getObjectVector<Mesh>(this, Collection::MESHES);
 }
 
 inline Camera Gltf::camera(size_t index) const noexcept {
-    return findGltfObject<Camera>(this, "cameras", index);
+    return findGltfObject<Camera>(this, Collection::CAMERAS, index);
 }
 
 inline std::vector<Camera> Gltf::cameras() const noexcept {
-    return getObjectVector<Camera>(this, "cameras");
+    return getObjectVector<Camera>(this, Collection::CAMERAS);
 }
 
 inline Accessor Gltf::accessor(size_t index) const noexcept {
-    return findGltfObject<Accessor>(this, "accessors", index);
+    return findGltfObject<Accessor>(this, Collection::ACCESSORS, index);
 }
 
 inline std::vector<Accessor> Gltf::accessors() const noexcept {
-    return getObjectVector<Accessor>(this, "accessors");
+    return getObjectVector<Accessor>(this, Collection::ACCESSORS);
 }
 
 inline Buffer Gltf::buffer(size_t index) const noexcept {
-    return findGltfObject<Buffer>(this, "buffers", index);
+    return findGltfObject<Buffer>(this, Collection::BUFFERS, index);
 }
 
 inline std::vector<Buffer> Gltf::buffers() const noexcept {
-    return getObjectVector<Buffer>(this, "buffers");
+    return getObjectVector<Buffer>(this, Collection::BUFFERS);
 }
 
 inline BufferView Gltf::bufferView(size_t index) const noexcept {
-    return findGltfObject<BufferView>(this, "bufferViews", index);
+    return findGltfObject<BufferView>(this, Collection::BUFFER_VIEWS, index);
 }
 
 inline std::vector<BufferView> Gltf::bufferViews() const noexcept {
-    return getObjectVector<BufferView>(this, "bufferViews");
+    return getObjectVector<BufferView>(this, Collection::BUFFER_VIEWS);
 }
 
 inline Animation Gltf::animation(size_t index) const noexcept {
-    return findGltfObject<Animation>(this, "animations", index);
+    return findGltfObject<Animation>(this, Collection::ANIMATIONS, index);
 }
 
 inline std::vector<Animation> Gltf::animations() const noexcept {
-    return getObjectVector<Animation>(this, "animations");
+    return getObjectVector<Animation>(this, Collection::ANIMATIONS);
+}
+
+inline Image Gltf::image(size_t index) const noexcept {
+    return findGltfObject<Image>(this, Collection::IMAGES, index);
+}
+
+inline std::vector<Image> Gltf::images() const noexcept {
+    return getObjectVector<Image>(this, Collection::IMAGES);
+}
+
+inline Texture Gltf::texture(size_t index) const noexcept {
+    return findGltfObject<Texture>(this, Collection::TEXTURES, index);
+}
+
+inline std::vector<Texture> Gltf::textures() const noexcept {
+    return getObjectVector<Texture>(this, Collection::TEXTURES);
+}
+
+inline Sampler Gltf::sampler(size_t index) const noexcept {
+    return findGltfObject<Sampler>(this, Collection::SAMPLERS, index);
+}
+
+inline std::vector<Sampler> Gltf::samplers() const noexcept {
+    return getObjectVector<Sampler>(this, Collection::SAMPLERS);
+}
+
+inline Material Gltf::material(size_t index) const noexcept {
+    return findGltfObject<Material>(this, Collection::MATERIALS, index);
+}
+
+inline std::vector<Material> Gltf::materials() const noexcept {
+    return getObjectVector<Material>(this, Collection::MATERIALS);
+}
+
+inline Skin Gltf::skin(size_t index) const noexcept {
+    return findGltfObject<Skin>(this, Collection::SKINS, index);
+}
+
+inline std::vector<Skin> Gltf::skins() const noexcept {
+    return getObjectVector<Skin>(this, Collection::SKINS);
+}
+
+inline Asset Gltf::asset() const noexcept {
+    if (m_doc) {
+        auto it = findMember(*m_doc, "asset");
+        if (it != m_doc->MemberEnd()) {
+            const auto& v = it->value;
+            if (v.IsObject()) {
+                return Asset(this, &v);
+            }
+        }
+    }
+    return Asset();
+}
+
+inline const Gltf::NameIndex::Table& Gltf::nameTable(Collection collection) const {
+    const size_t c = static_cast<size_t>(collection);
+    NameIndex& names = *m_names;
+    std::call_once(names.built[c], [&]() {
+        auto& table = names.tables[c];
+        const size_t size = count(collection);
+        table.first.reserve(size);
+        table.next.assign(size, NameIndex::NONE);
+        // walk backwards so that each name ends up pointing at its first object
+        for (size_t i = size; i-- > 0;) {
+            const JsonValue& json = *object(collection, i);
+            const auto it = findMember(json, "name");
+            if (it != json.MemberEnd() && it->value.IsString()) {
+                const auto inserted = table.first.emplace(it->value.GetString(), static_cast<std::uint32_t>(i));
+                if (!inserted.second) {
+                    table.next[i] = inserted.first->second;
+                    inserted.first->second = static_cast<std::uint32_t>(i);
+                }
+            }
+        }
+    });
+    return names.tables[c];
+}
+
+inline bool Gltf::findIndex(Collection collection, const char* name, size_t& index) const {
+    if (name == nullptr || !m_names || count(collection) == 0) {
+        return false;
+    }
+    const auto& table = nameTable(collection);
+    const auto it = table.first.find(name);
+    if (it != table.first.end()) {
+        index = it->second;
+        return true;
+    }
+    return false;
+}
+
+inline std::vector<size_t> Gltf::findIndices(Collection collection, const char* name) const {
+    std::vector<size_t> indices;
+    size_t index;
+    if (findIndex(collection, name, index)) {
+        const auto& next = nameTable(collection).next;
+        for (std::uint32_t i = static_cast<std::uint32_t>(index); i != NameIndex::NONE; i = next[i]) {
+            indices.push_back(i);
+        }
+    }
+    return indices;
+}
+
+inline Node Gltf::findNodeByPath(const char* path) const {
+    if (path == nullptr || !m_names || nodeCount() == 0) {
+        return Node();
+    }
+    const NodeHierarchy& nodes = hierarchy();
+    std::vector<size_t> matches;
+    std::vector<size_t> children;
+    std::string name;
+    for (const char* begin = path; ; ) {
+        const char* end = strchr(begin, '/');
+        name.assign(begin, end != nullptr ? end : begin + strlen(begin));
+        if (begin == path) {
+            // the root of the path
+            for (size_t i : findIndices(Collection::NODES, name.c_str())) {
+                if (nodes.parentCount(i) == 0) {
+                    matches.push_back(i);
+                }
+            }
+        }
+        else {
+            children.clear();
+            for (size_t parent : matches) {
+                const std::uint32_t* begin = nodes.children(parent);
+                for (const std::uint32_t* child = begin; child != begin + nodes.childCount(parent); ++child) {
+                    const char* childName = node(*child).name();
+                    if (childName != nullptr && name == childName) {
+                        children.push_back(*child);
+                    }
+                }
+            }
+            matches.swap(children);
+        }
+        if (matches.empty()) {
+            return Node();
+        }
+        if (end == nullptr) {
+            return node(matches.front());
+        }
+        begin = end + 1;
+    }
 }
 
-inline Image Gltf::image(size_t index) const noexcept {
-    return findGltfObject<Image>(this, "images", index);
+inline const NodeHierarchy& Gltf::hierarchy() const {
+    static const NodeHierarchy empty;
+    if (!m_names) {
+        return empty;
+    }
+    NameIndex& names = *m_names;
+    if (names.hierarchyAdopted) {
+        return names.hierarchy;
+    }
+    std::call_once(names.hierarchyBuilt, [&]() {
+        NodeHierarchy& h = names.hierarchy;
+        const size_t nodeCount = this->nodeCount();
+        // appends the in range node indices of an array to out
+        auto appendIndices = [nodeCount](const JsonValue* json, const JsonKey& key, std::vector<std::uint32_t>& out) {
+            auto it = findMember(*json, key);
+            if (it != json->MemberEnd() && it->value.IsArray()) {
+                for (const auto& v : it->value.GetArray()) {
+                    if (v.IsUint() && v.GetUint() < nodeCount) {
+                        out.push_back(v.GetUint());
+                    }
+                }
+            }
+        };
+        h.m_parents.assign(nodeCount, NodeHierarchy::NONE);
+        h.m_parentCounts.assign(nodeCount, 0);
+        h.m_childOffsets.reserve(nodeCount + 1);
+        h.m_childOffsets.push_back(0);
+        for (size_t i = 0; i < nodeCount; ++i) {
+            const size_t first = h.m_children.size();
+            appendIndices(object(Collection::NODES, i), "children", h.m_children);
+            for (size_t c = first; c < h.m_children.size(); ++c) {
+                if (h.m_parentCounts[h.m_children[c]]++ == 0) {
+                    h.m_parents[h.m_children[c]] = static_cast<std::uint32_t>(i);
+                }
+            }
+            h.m_childOffsets.push_back(static_cast<std::uint32_t>(h.m_children.size()));
+        }
+        const size_t sceneCount = this->sceneCount();
+        h.m_rootOffsets.reserve(sceneCount + 1);
+        h.m_rootOffsets.push_back(0);
+        for (size_t i = 0; i < sceneCount; ++i) {
+            appendIndices(object(Collection::SCENES, i), "nodes", h.m_roots);
+            h.m_rootOffsets.push_back(static_cast<std::uint32_t>(h.m_roots.size()));
+        }
+    });
+    return names.hierarchy;
 }
 
-inline std::vector<Image> Gltf::images() const noexcept {
-    return getObjectVector<Image>(this, "images");
+inline const AnimationIndex& Gltf::animationIndex() const {
+    static const AnimationIndex empty;
+    if (!m_names) {
+        return empty;
+    }
+    NameIndex& names = *m_names;
+    std::call_once(names.animationsBuilt, [&]() {
+        AnimationIndex& index = names.animations;
+        const size_t nodeCount = this->nodeCount();
+        const size_t animationCount = this->animationCount();
+        // the animations of each node in ascending order, possibly repeated
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> nodeAnimations;
+        index.m_entryOffsets.reserve(animationCount + 1);
+        index.m_entryOffsets.push_back(0);
+        for (size_t a = 0; a < animationCount; ++a) {
+            const size_t first = index.m_entries.size();
+            const JsonValue* animation = object(Collection::ANIMATIONS, a);
+            auto channels = findMember(*animation, "channels");
+            if (channels != animation->MemberEnd() && channels->value.IsArray()) {
+                const size_t channelCount = channels->value.Size();
+                for (size_t c = 0; c < channelCount; ++c) {
+                    if (!channels->value[c].IsObject()) {
+                        continue;
+                    }
+                    const Channel::Target target = Channel(this, &channels->value[c], animation).target();
+                    size_t node;
+                    if (target.node(node) && node < nodeCount) {
+                        index.m_entries.push_back(AnimationIndex::Entry{ static_cast<std::uint32_t>(node),
+                            target.path(), static_cast<std::uint32_t>(c) });
+                        nodeAnimations.emplace_back(static_cast<std::uint32_t>(node), static_cast<std::uint32_t>(a));
+                    }
+                }
+            }
+            std::sort(index.m_entries.begin() + first, index.m_entries.end(),
+                [](const AnimationIndex::Entry& lhs, const AnimationIndex::Entry& rhs) {
+                    return lhs.node != rhs.node ? lhs.node < rhs.node
+                        : lhs.path != rhs.path ? lhs.path < rhs.path : lhs.channel < rhs.channel;
+                });
+            index.m_entryOffsets.push_back(static_cast<std::uint32_t>(index.m_entries.size()));
+        }
+        std::sort(nodeAnimations.begin(), nodeAnimations.end());
+        nodeAnimations.erase(std::unique(nodeAnimations.begin(), nodeAnimations.end()), nodeAnimations.end());
+        index.m_animationOffsets.assign(nodeCount + 1, 0);
+        for (const auto& entry : nodeAnimations) {
+            ++index.m_animationOffsets[entry.first + 1];
+        }
+        for (size_t i = 0; i < nodeCount; ++i) {
+            index.m_animationOffsets[i + 1] += index.m_animationOffsets[i];
+        }
+        index.m_animations.reserve(nodeAnimations.size());
+        for (const auto& entry : nodeAnimations) {
+            index.m_animations.push_back(entry.second);
+        }
+    });
+    return names.animations;
 }
 
-inline Texture Gltf::texture(size_t index) const noexcept {
-    return findGltfObject<Texture>(this, "textures", index);
+inline Node Gltf::findNode(const char* name) const {
+    return findByName<Node>(Collection::NODES, name);
 }
 
-inline std::vector<Texture> Gltf::textures() const noexcept {
-    return getObjectVector<Texture>(this, "textures");
+inline Mesh Gltf::findMesh(const char* name) const {
+    return findByName<Mesh>(Collection::MESHES, name);
 }
 
-inline Sampler Gltf::sampler(size_t index) const noexcept {
-    return findGltfObject<Sampler>(this, "samplers", index);
+inline Skin Gltf::findSkin(const char* name) const {
+    return findByName<Skin>(Collection::SKINS, name);
 }
 
-inline std::vector<Sampler> Gltf::samplers() const noexcept {
-    return getObjectVector<Sampler>(this, "samplers");
+inline Material Gltf::findMaterial(const char* name) const {
+    return findByName<Material>(Collection::MATERIALS, name);
 }
 
-inline Material Gltf::material(size_t index) const noexcept {
-    return findGltfObject<Material>(this, "materials", index);
+inline Scene Gltf::findScene(const char* name) const {
+    return findByName<Scene>(Collection::SCENES, name);
 }
 
-inline std::vector<Material> Gltf::materials() const noexcept {
-    return getObjectVector<Material>(this, "materials");
+inline Camera Gltf::findCamera(const char* name) const {
+    return findByName<Camera>(Collection::CAMERAS, name);
 }
 
-inline Skin Gltf::skin(size_t index) const noexcept {
-    return findGltfObject<Skin>(this, "skins", index);
+inline Accessor Gltf::findAccessor(const char* name) const {
+    return findByName<Accessor>(Collection::ACCESSORS, name);
 }
 
-inline std::vector<Skin> Gltf::skins() const noexcept {
-    return getObjectVector<Skin>(this, "skins");
+inline Buffer Gltf::findBuffer(const char* name) const {
+    return findByName<Buffer>(Collection::BUFFERS, name);
 }
 
-inline Asset Gltf::asset() const noexcept {
-    if (m_doc) {
-        auto it = m_doc->FindMember("asset");
-        if (it != m_doc->MemberEnd()) {
-            const auto& v = it->value;
-            if (v.IsObject()) {
-                return Asset(this, &v);
-            }
-        }
-    }
-    return Asset();
+inline BufferView Gltf::findBufferView(const char* name) const {
+    return findByName<BufferView>(Collection::BUFFER_VIEWS, name);
 }
 
-inline Node Gltf::findNode(const char* name) {
-    return findByName<Node>("nodes", name);
+inline Animation Gltf::findAnimation(const char* name) const {
+    return findByName<Animation>(Collection::ANIMATIONS, name);
 }
 
-inline Mesh Gltf::findMesh(const char* name) {
-    return findByName<Mesh>("meshes", name);
+inline Image Gltf::findImage(const char* name) const {
+    return findByName<Image>(Collection::IMAGES, name);
 }
 
-inline Skin Gltf::findSkin(const char* name) {
-    return findByName<Skin>("skins", name);
+inline Texture Gltf::findTexture(const char* name) const {
+    return findByName<Texture>(Collection::TEXTURES, name);
 }
 
-inline Material Gltf::findMaterial(const char* name) {
-    return findByName<Material>("materials", name);
+inline Sampler Gltf::findSampler(const char* name) const {
+    return findByName<Sampler>(Collection::SAMPLERS, name);
 }
 
 inline std::vector<const char*> Gltf::extensionsRequired() const noexcept {
@@ -2020,9 +5843,8 @@ inline std::vector<const char*> Gltf::extensionsUsed() const noexcept {
 }
 
 inline bool Gltf::loadGlbMetaData(const char* path) {
-    unique_file_ptr file(fopen(path, "rb"));
-    FILE* fp = file.get();
-    if (!fp) {
+    const auto file = fileSystem().open(path);
+    if (!file) {
         return false;
     }
     static constexpr size_t magic = 0;
@@ -2031,32 +5853,37 @@ inline bool Gltf::loadGlbMetaData(const char* path) {
     static constexpr size_t chunkLength = 3;
     static constexpr size_t chunkType = 4;
     std::array<std::uint32_t, 5> header;
-    if (fread(header.data(), sizeof(std::uint32_t), header.size(), fp) == header.size()) {
+    if (file->read(0, header.data(), sizeof(header)) == sizeof(header)) {
         if (header[magic] == MAGIC && header[chunkType] == JSON_CHUNK_TYPE) {
             const size_t bufferLength = header[chunkLength];
-            std::unique_ptr<char[]> buffer(new char[bufferLength]);
-            size_t bytesRead = fread(buffer.get(), 1, bufferLength, fp);
-            if (bytesRead != bufferLength) {
-                return false;
+            if (m_inSituParsing) {
+                m_json.resize(bufferLength + 1);
+                if (file->read(sizeof(header), m_json.data(), bufferLength) != bufferLength) {
+                    return false;
+                }
+                parseInSitu(bufferLength);
+            }
+            else {
+                std::unique_ptr<char[]> buffer(new char[bufferLength]);
+                size_t bytesRead = file->read(sizeof(header), buffer.get(), bufferLength);
+                if (bytesRead != bufferLength) {
+                    return false;
+                }
+                rapidjson::MemoryStream stream(buffer.get(), bufferLength);
+                parseStream(stream);
             }
-            rapidjson::MemoryStream stream(buffer.get(), bufferLength);
-            m_doc.reset(new JsonDocument());
-            m_doc->ParseStream(stream);
 
             // attempt to read the binary buffer chunk
-            if (std::fseek(fp, sizeof(header) + header[chunkLength], SEEK_SET)) {
-                return true;
-            }
-            std::uint32_t binaryChunkLength;
-            std::uint32_t binaryChunkType;
-            if (fread(&binaryChunkLength, sizeof(binaryChunkLength), 1, fp) == 1) {
-                if (fread(&binaryChunkType, sizeof(binaryChunkType), 1, fp) == 1 && binaryChunkType == BINARY_CHUNK_TYPE) {
+            const size_t binOffset = sizeof(header) + header[chunkLength];
+            std::array<std::uint32_t, 2> chunkHeader;
+            if (file->read(binOffset, chunkHeader.data(), sizeof(chunkHeader)) == sizeof(chunkHeader)) {
+                if (chunkHeader[1] == BINARY_CHUNK_TYPE) {
                     if (!m_glb) {
                         m_glb.reset(new GlbData());
                     }
                     m_glb->path.assign(path);
-                    m_glb->offset = static_cast<size_t>(ftell(fp));
-                    m_glb->chunkLength = binaryChunkLength;
+                    m_glb->offset = static_cast<std::uint32_t>(binOffset + sizeof(chunkHeader));
+                    m_glb->chunkLength = chunkHeader[0];
                 }
             }
             return true;
@@ -2065,27 +5892,427 @@ inline bool Gltf::loadGlbMetaData(const char* path) {
     return false;
 }
 
+inline bool Gltf::loadMappedGlb(const char* path) {
+    std::unique_ptr<GlbData> glb(new GlbData());
+    glb->file = fileSystem().open(path);
+    if (!glb->file) {
+        return false;
+    }
+    glb->bytes = glb->file->map();
+    if (!glb->bytes) {
+        // the file system doesn't support mapping
+        return loadGlbMetaData(path);
+    }
+    glb->path.assign(path);
+    // the mapping is read only so the JSON chunk is never parsed in-situ
+    const bool loaded = parseGlb(std::move(glb), false);
+    if (loaded) {
+        m_baseDir.assign(dirName(path));
+    }
+    return loaded;
+}
+
+inline bool Gltf::parseGlb(std::unique_ptr<GlbData> glb, bool inSitu) {
+    const DataView file = glb->bytes;
+    static constexpr size_t headerSize = 5 * sizeof(std::uint32_t);
+    static constexpr size_t chunkHeaderSize = 2 * sizeof(std::uint32_t);
+    if (file.byteLength() < headerSize) {
+        return false;
+    }
+    std::array<std::uint32_t, 5> header;
+    memcpy(header.data(), file.data(), headerSize);
+    const size_t jsonLength = header[3];
+    if (header[0] != MAGIC || header[4] != JSON_CHUNK_TYPE || jsonLength > file.byteLength() - headerSize) {
+        return false;
+    }
+    const char* json = reinterpret_cast<const char*>(file.data()) + headerSize;
+    if (inSitu) {
+        m_json.reserve(jsonLength + 1);
+        m_json.assign(json, json + jsonLength);
+        m_json.push_back('\0');
+        parseInSitu(jsonLength);
+    }
+    else {
+        // parse the JSON chunk straight from memory
+        rapidjson::MemoryStream stream(json, jsonLength);
+        parseStream(stream);
+    }
+
+    // the BIN chunk is optional
+    const size_t binOffset = headerSize + jsonLength;
+    if (file.byteLength() - binOffset >= chunkHeaderSize) {
+        std::array<std::uint32_t, 2> chunkHeader;
+        memcpy(chunkHeader.data(), file.data() + binOffset, chunkHeaderSize);
+        const size_t dataOffset = binOffset + chunkHeaderSize;
+        if (chunkHeader[1] == BINARY_CHUNK_TYPE && chunkHeader[0] <= file.byteLength() - dataOffset) {
+            if (glb->path.empty()) {
+                glb->path = "#" + std::to_string(m_loadId);
+            }
+            glb->offset = static_cast<std::uint32_t>(dataOffset);
+            glb->chunkLength = chunkHeader[0];
+            m_glb = std::move(glb);
+        }
+    }
+    return true;
+}
+
+inline DataView Gltf::bufferData(size_t index) const noexcept {
+    const Buffer buf = buffer(index);
+    const size_t length = buf.byteLength();
+    const DataView view = pinBuffer(index).view();
+    // the GLB chunk may be padded so don't expose more than byteLength
+    return view ? DataView(view.data(), std::min(length, view.byteLength())) : DataView();
+}
+
+inline BufferCache::Handle Gltf::pinBuffer(size_t index) const noexcept {
+    const Buffer buf = buffer(index);
+    if (!buf || !m_bufferCache) {
+        return BufferCache::Handle();
+    }
+    if (buf.uri() == nullptr) {
+        const DataView glb = glbData();
+        if (glb) {
+            return BufferCache::Handle(nullptr, glb);
+        }
+    }
+    const std::string key = bufferKey(index);
+    auto handle = m_bufferCache->find(key);
+    if (!handle) {
+        std::vector<unsigned char> data;
+        if (buf.load(data)) {
+            handle = m_bufferCache->insert(key, std::move(data));
+        }
+    }
+    return handle;
+}
+
+inline bool Gltf::releaseBuffer(size_t index) const noexcept {
+    return m_bufferCache && index < bufferCount() && m_bufferCache->release(bufferKey(index));
+}
+
+inline void Gltf::releaseEmbeddedBuffers() noexcept {
+    collectEmbeddedKeys(m_embeddedKeys);
+    if (m_bufferCache) {
+        for (const auto& key : m_embeddedKeys) {
+            m_bufferCache->release(key);
+        }
+    }
+    m_embeddedKeys.clear();
+}
+
+inline void Gltf::collectEmbeddedKeys(std::vector<std::string>& keys) const {
+    const size_t count = bufferCount();
+    for (size_t i = 0; i < count; ++i) {
+        const char* uri = buffer(i).uri();
+        if (uri != nullptr && (m_loadedFromMemory || startsWith(uri, LAZY_GLTF2_DATA_APP_BASE64))) {
+            keys.push_back(bufferKey(i));
+        }
+    }
+}
+
+inline std::string Gltf::bufferKey(size_t index) const {
+    const char* uri = buffer(index).uri();
+    if (uri == nullptr) {
+        return m_glb ? std::to_string(fileSystem().id()) + ":" + m_glb->path + "#BIN" : std::string();
+    }
+    // URIs of files loaded from memory aren't paths so they can't be shared with other Gltf objects
+    if (m_loadedFromMemory || startsWith(uri, LAZY_GLTF2_DATA_APP_BASE64)) {
+        return "#" + std::to_string(m_loadId) + "/" + std::to_string(index);
+    }
+    // the same path may refer to different files in other file systems
+    return std::to_string(fileSystem().id()) + ":" + m_baseDir + uri;
+}
+
 template<typename T>
 bool Gltf::loadGlbData(std::vector<T>& data) const noexcept {
     static_assert(sizeof(T) == 1, "vector type size must be 1");
     if (m_glb) {
         const auto& chunkLength = m_glb->chunkLength;
-        unique_file_ptr file(fopen(m_glb->path.c_str(), "rb"));
-        FILE* fp = file.get();
-        if (!fp) {
-            return false;
+        if (m_glb->bytes) {
+            const auto* begin = reinterpret_cast<const T*>(m_glb->bytes.data() + m_glb->offset);
+            data.assign(begin, begin + chunkLength);
+            return true;
         }
-        if (std::fseek(fp, m_glb->offset, SEEK_SET)) {
+        const auto file = fileSystem().open(m_glb->path.c_str());
+        if (!file) {
             return false;
         }
         data.resize(chunkLength);
-        if (fread(data.data(), 1, chunkLength, fp) == chunkLength) {
+        if (file->read(m_glb->offset, data.data(), chunkLength) == chunkLength) {
+            return true;
+        }
+    }
+    return false;
+}
+
+inline std::shared_ptr<const CompiledGltf> Gltf::compile() {
+    if (!m_doc) {
+        return nullptr;
+    }
+    // read everything from the document
+    m_compiled.reset();
+    std::shared_ptr<CompiledGltf> tables = std::make_shared<CompiledGltf>();
+    size_t index = 0;
+    // the getter that finds index must run before index is read
+    auto toIndex = [&index](bool found) {
+        return found ? static_cast<std::uint32_t>(index) : static_cast<std::uint32_t>(CompiledGltf::NONE);
+    };
+
+    auto& nodes = tables->nodes;
+    const size_t nodeCount = this->nodeCount();
+    nodes.flags.resize(nodeCount);
+    nodes.translation.resize(nodeCount * 3, 0.0f);
+    nodes.rotation.resize(nodeCount * 4, 0.0f);
+    nodes.scale.resize(nodeCount * 3, 1.0f);
+    nodes.matrix.resize(nodeCount * 16, 0.0f);
+    nodes.mesh.resize(nodeCount);
+    nodes.camera.resize(nodeCount);
+    nodes.skin.resize(nodeCount);
+    nodes.childOffsets.reserve(nodeCount + 1);
+    nodes.childOffsets.push_back(0);
+    for (size_t i = 0; i < nodeCount; ++i) {
+        const Node n = node(i);
+        std::uint8_t flags = 0;
+        float* rotation = &nodes.rotation[i * 4];
+        float* matrix = &nodes.matrix[i * 16];
+        if (n.translation(&nodes.translation[i * 3])) {
+            flags |= CompiledGltf::Nodes::HAS_TRANSLATION;
+        }
+        if (n.rotation(rotation)) {
+            flags |= CompiledGltf::Nodes::HAS_ROTATION;
+        }
+        else {
+            rotation[3] = 1.0f;
+        }
+        if (n.scale(&nodes.scale[i * 3])) {
+            flags |= CompiledGltf::Nodes::HAS_SCALE;
+        }
+        if (n.matrix(matrix)) {
+            flags |= CompiledGltf::Nodes::HAS_MATRIX;
+        }
+        else {
+            matrix[0] = matrix[5] = matrix[10] = matrix[15] = 1.0f;
+        }
+        nodes.flags[i] = flags;
+        nodes.mesh[i] = toIndex(n.mesh(index));
+        nodes.camera[i] = toIndex(n.camera(index));
+        nodes.skin[i] = toIndex(n.skin(index));
+        for (size_t child : n.children()) {
+            nodes.children.push_back(static_cast<std::uint32_t>(child));
+        }
+        nodes.childOffsets.push_back(static_cast<std::uint32_t>(nodes.children.size()));
+    }
+
+    auto& accessors = tables->accessors;
+    const size_t accessorCount = this->accessorCount();
+    accessors.bufferView.reserve(accessorCount);
+    accessors.byteOffset.reserve(accessorCount);
+    accessors.count.reserve(accessorCount);
+    accessors.componentType.reserve(accessorCount);
+    accessors.type.reserve(accessorCount);
+    accessors.normalized.reserve(accessorCount);
+    for (size_t i = 0; i < accessorCount; ++i) {
+        const Accessor a = accessor(i);
+        accessors.bufferView.push_back(toIndex(a.bufferView(index)));
+        accessors.byteOffset.push_back(static_cast<std::uint32_t>(a.byteOffset()));
+        accessors.count.push_back(static_cast<std::uint32_t>(a.count()));
+        accessors.componentType.push_back(static_cast<std::uint16_t>(a.componentType()));
+        accessors.type.push_back(static_cast<std::uint8_t>(a.type()));
+        accessors.normalized.push_back(a.normalized());
+    }
+
+    auto& bufferViews = tables->bufferViews;
+    const size_t bufferViewCount = this->bufferViewCount();
+    bufferViews.buffer.reserve(bufferViewCount);
+    bufferViews.byteOffset.reserve(bufferViewCount);
+    bufferViews.byteLength.reserve(bufferViewCount);
+    bufferViews.byteStride.reserve(bufferViewCount);
+    bufferViews.target.reserve(bufferViewCount);
+    for (size_t i = 0; i < bufferViewCount; ++i) {
+        const BufferView b = bufferView(i);
+        bufferViews.buffer.push_back(toIndex(b.buffer(index)));
+        bufferViews.byteOffset.push_back(static_cast<std::uint32_t>(b.byteOffset()));
+        bufferViews.byteLength.push_back(static_cast<std::uint32_t>(b.byteLength()));
+        bufferViews.byteStride.push_back(static_cast<std::uint32_t>(b.byteStride()));
+        bufferViews.target.push_back(static_cast<std::uint16_t>(b.target()));
+    }
+
+    auto& meshes = tables->meshes;
+    auto& primitives = tables->primitives;
+    const size_t meshCount = this->meshCount();
+    meshes.primitiveOffsets.reserve(meshCount + 1);
+    meshes.primitiveOffsets.push_back(0);
+    primitives.attributeOffsets.push_back(0);
+    for (size_t i = 0; i < meshCount; ++i) {
+        const Mesh m = mesh(i);
+        const size_t primitiveCount = m.primitiveCount();
+        for (size_t p = 0; p < primitiveCount; ++p) {
+            const Primitive primitive = m.primitive(p);
+            primitives.mesh.push_back(static_cast<std::uint32_t>(i));
+            primitives.mode.push_back(static_cast<std::uint8_t>(primitive.mode()));
+            primitives.indices.push_back(toIndex(primitive.indices(index)));
+            primitives.material.push_back(toIndex(primitive.material(index)));
+            for (const auto& attribute : primitive.attributes()) {
+                primitives.attributeNames.emplace_back(attribute.first);
+                primitives.attributes.push_back(static_cast<std::uint32_t>(attribute.second));
+            }
+            primitives.attributeOffsets.push_back(static_cast<std::uint32_t>(primitives.attributes.size()));
+        }
+        meshes.primitiveOffsets.push_back(static_cast<std::uint32_t>(primitives.size()));
+    }
+
+    auto& materials = tables->materials;
+    const size_t materialCount = this->materialCount();
+    materials.baseColorFactor.resize(materialCount * 4);
+    materials.emissiveFactor.resize(materialCount * 3);
+    for (size_t i = 0; i < materialCount; ++i) {
+        const Material m = material(i);
+        const PbrMetallicRoughness pbr = m.pbrMetallicRoughness();
+        const auto baseColor = pbr ? pbr.baseColorFactor() : std::array<float, 4>{ { 1.0f, 1.0f, 1.0f, 1.0f } };
+        const auto emissive = m.emissiveFactor();
+        std::copy(baseColor.begin(), baseColor.end(), &materials.baseColorFactor[i * 4]);
+        std::copy(emissive.begin(), emissive.end(), &materials.emissiveFactor[i * 3]);
+        materials.metallicFactor.push_back(pbr ? pbr.metallicFactor() : 1.0f);
+        materials.roughnessFactor.push_back(pbr ? pbr.roughnessFactor() : 1.0f);
+        materials.alphaMode.push_back(static_cast<std::uint8_t>(m.alphaMode()));
+        materials.alphaCutoff.push_back(m.alphaCutoff());
+        materials.doubleSided.push_back(m.doubleSided());
+        materials.baseColorTexture.push_back(toIndex(pbr.baseColorTexture().index(index)));
+        materials.metallicRoughnessTexture.push_back(toIndex(pbr.metallicRoughnessTexture().index(index)));
+        materials.normalTexture.push_back(toIndex(m.normalTexture().index(index)));
+        materials.occlusionTexture.push_back(toIndex(m.occlusionTexture().index(index)));
+        materials.emissiveTexture.push_back(toIndex(m.emissiveTexture().index(index)));
+    }
+
+    auto& samplers = tables->samplers;
+    const size_t samplerCount = this->samplerCount();
+    for (size_t i = 0; i < samplerCount; ++i) {
+        const Sampler s = sampler(i);
+        samplers.magFilter.push_back(static_cast<std::uint16_t>(s.magFilter()));
+        samplers.minFilter.push_back(static_cast<std::uint16_t>(s.minFilter()));
+        samplers.wrapS.push_back(static_cast<std::uint16_t>(s.wrapS()));
+        samplers.wrapT.push_back(static_cast<std::uint16_t>(s.wrapT()));
+    }
+
+    auto& textures = tables->textures;
+    const size_t textureCount = this->textureCount();
+    for (size_t i = 0; i < textureCount; ++i) {
+        const Texture t = texture(i);
+        textures.sampler.push_back(toIndex(t.sampler(index)));
+        textures.source.push_back(toIndex(t.source(index)));
+    }
+
+    m_compiled = tables;
+    return tables;
+}
+
+inline std::unique_ptr<JsonDocument> Gltf::createStubs() const {
+    std::unique_ptr<JsonDocument> stubs(new JsonDocument());
+    auto& allocator = stubs->GetAllocator();
+    stubs->SetObject();
+    auto fillArray = [&allocator](JsonValue& values, size_t size) {
+        values.SetArray();
+        values.Reserve(static_cast<rapidjson::SizeType>(size), allocator);
+        for (size_t i = 0; i < size; ++i) {
+            JsonValue stub(rapidjson::kObjectType);
+            values.PushBack(stub, allocator);
+        }
+    };
+    auto addMember = [&allocator](JsonValue& object, const char* key, JsonValue& value) {
+        object.AddMember(rapidjson::StringRef(key), value, allocator);
+    };
+    // the texture infos only need to exist because the texture index comes from the tables
+    auto addTexture = [&](JsonValue& object, const char* key, std::uint32_t texture) {
+        if (texture != CompiledGltf::NONE) {
+            JsonValue info(rapidjson::kObjectType);
+            addMember(object, key, info);
+        }
+    };
+    const CompiledGltf& tables = *m_compiled;
+
+    JsonValue meshes;
+    fillArray(meshes, tables.meshes.size());
+    for (size_t i = 0; i < tables.meshes.size(); ++i) {
+        const auto& offsets = tables.meshes.primitiveOffsets;
+        JsonValue primitives;
+        fillArray(primitives, offsets[i + 1] - offsets[i]);
+        addMember(meshes[static_cast<rapidjson::SizeType>(i)], "primitives", primitives);
+    }
+    JsonValue materials;
+    fillArray(materials, tables.materials.size());
+    for (size_t i = 0; i < tables.materials.size(); ++i) {
+        JsonValue& stub = materials[static_cast<rapidjson::SizeType>(i)];
+        if (material(i).pbrMetallicRoughness()) {
+            JsonValue pbr(rapidjson::kObjectType);
+            addTexture(pbr, "baseColorTexture", tables.materials.baseColorTexture[i]);
+            addTexture(pbr, "metallicRoughnessTexture", tables.materials.metallicRoughnessTexture[i]);
+            addMember(stub, "pbrMetallicRoughness", pbr);
+        }
+        addTexture(stub, "normalTexture", tables.materials.normalTexture[i]);
+        addTexture(stub, "occlusionTexture", tables.materials.occlusionTexture[i]);
+        addTexture(stub, "emissiveTexture", tables.materials.emissiveTexture[i]);
+    }
+    JsonValue nodes, accessors, bufferViews, samplers, textures;
+    fillArray(nodes, tables.nodes.size());
+    fillArray(accessors, tables.accessors.size());
+    fillArray(bufferViews, tables.bufferViews.size());
+    fillArray(samplers, tables.samplers.size());
+    fillArray(textures, tables.textures.size());
+    addMember(*stubs, "nodes", nodes);
+    addMember(*stubs, "meshes", meshes);
+    addMember(*stubs, "accessors", accessors);
+    addMember(*stubs, "bufferViews", bufferViews);
+    addMember(*stubs, "materials", materials);
+    addMember(*stubs, "samplers", samplers);
+    addMember(*stubs, "textures", textures);
+    return stubs;
+}
+
+inline void Gltf::releaseDocument() {
+    if (!m_doc) {
+        return;
+    }
+    // everything that allocates is done before the document is released
+    // remember the cache keys of the embedded buffers because they can't be found without the document
+    std::vector<std::string> embeddedKeys;
+    collectEmbeddedKeys(embeddedKeys);
+    std::unique_ptr<JsonDocument> stubs;
+    std::unique_ptr<NameIndex> names;
+    if (m_compiled) {
+        stubs = createStubs();
+        // the hierarchy can't be rebuilt without the document
+        hierarchy();
+        names.reset(new NameIndex(std::move(m_names->hierarchy)));
+    }
+    else {
+        names.reset(new NameIndex());
+    }
+    m_embeddedKeys = std::move(embeddedKeys);
+    m_doc.reset(nullptr);
+    m_docArena.reset();
+    std::vector<char>().swap(m_json);
+    m_names = std::move(names);
+    m_stubs = std::move(stubs);
+    resolveCollections();
+}
+
+inline bool Node::parent(size_t& index) const {
+    size_t i;
+    if (m_gltf != nullptr && findGltfIndex(m_gltf, Collection::NODES, m_json, i)) {
+        const std::uint32_t parent = m_gltf->hierarchy().parent(i);
+        if (parent != NodeHierarchy::NONE) {
+            index = parent;
             return true;
         }
     }
     return false;
 }
 
+inline Node Node::parent() const {
+    size_t index;
+    return parent(index) ? m_gltf->node(index) : Node();
+}
+
 inline Mesh Node::mesh() const noexcept {
     size_t index;
     if (mesh(index)) {
@@ -2126,14 +6353,35 @@ bool Buffer::load(std::vector<T>& data) const noexcept {
     }
     else if (startsWith(uriStr, LAZY_GLTF2_DATA_APP_BASE64)) {
         // base64
-        return readBase64(uriStr + sizeof(LAZY_GLTF2_DATA_APP_BASE64) - 1, byteLength(), data);
+        return readBase64(uriStr + sizeof(LAZY_GLTF2_DATA_APP_BASE64) - 1, byteLength(), data, m_gltf->decodeThreadCount());
     }
     else {
+        const auto& resolver = m_gltf->uriResolver();
+        if (resolver) {
+            std::vector<unsigned char> bytes;
+            if (!resolver(uriStr, bytes)) {
+                return false;
+            }
+            assignBytes(std::move(bytes), data);
+            return true;
+        }
+        if (m_gltf->loadedFromMemory()) {
+            // there is no base directory to resolve the URI against
+            return false;
+        }
         // TODO make sure this is a local file URI
         // external bin
         std::string path = m_gltf->baseDir() + uriStr;
-        return readBinaryFile(path.c_str(), byteLength(), data);
+        return readBinaryFile(m_gltf->fileSystem(), path.c_str(), byteLength(), data);
+    }
+}
+
+inline DataView Buffer::data() const noexcept {
+    size_t index;
+    if (findGltfIndex(m_gltf, Collection::BUFFERS, m_json, index)) {
+        return m_gltf->bufferData(index);
     }
+    return DataView();
 }
 
 template<typename T>
@@ -2153,9 +6401,412 @@ bool Image::loadBase64(std::vector<T>& data) const {
     return readBase64(text, byteLength, data);
 }
 
+inline bool MappedFile::open(const char* path) noexcept {
+    close();
+    if (path == nullptr) {
+        return false;
+    }
+#ifdef _WIN32
+    m_file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0) {
+        close();
+        return false;
+    }
+    m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (m_mapping == nullptr) {
+        close();
+        return false;
+    }
+    m_data = static_cast<const unsigned char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+    if (m_data == nullptr) {
+        close();
+        return false;
+    }
+    m_size = static_cast<size_t>(size.QuadPart);
+#else
+    const int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+    const size_t size = static_cast<size_t>(st.st_size);
+    void* p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping stays valid after the descriptor is closed
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        return false;
+    }
+    m_data = static_cast<const unsigned char*>(p);
+    m_size = size;
+#endif
+    return true;
+}
+
+inline void MappedFile::close() noexcept {
+#ifdef _WIN32
+    if (m_data != nullptr) {
+        UnmapViewOfFile(m_data);
+    }
+    if (m_mapping != nullptr) {
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+    }
+    if (m_file != INVALID_HANDLE_VALUE) {
+        CloseHandle(m_file);
+        m_file = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (m_data != nullptr) {
+        munmap(const_cast<unsigned char*>(m_data), m_size);
+    }
+#endif
+    m_data = nullptr;
+    m_size = 0;
+}
+
+template<typename T>
+bool Accessor::read(T* out) const noexcept {
+    static_assert(std::is_arithmetic<T>::value, "T must be a number type");
+    if (m_gltf == nullptr || out == nullptr) {
+        return false;
+    }
+    const ComponentType component = componentType();
+    AccessorLayout layout = accessorLayout(type(), component, normalized());
+    const size_t elementCount = count();
+    const BufferView view = bufferView();
+    if (view) {
+        if (!bindLayout(layout, view.data(), byteOffset(), elementCount)) {
+            return false;
+        }
+        convertComponents(component, layout, out);
+    }
+    else {
+        // the spec says that an accessor without a bufferView is initialized with zeros
+        std::fill(out, out + elementCount * layout.components(), T(0));
+    }
+    if (sparse()) {
+        return applySparse(out);
+    }
+    return true;
+}
+
+template<typename T>
+bool Accessor::readSparse(std::vector<std::uint32_t>& indices, std::vector<T>& values) const noexcept {
+    AccessorLayout layout;
+    SparseIndices::ComponentType indexType;
+    const unsigned char* indexData;
+    if (!readSparseValues(values, layout, indexType, indexData)) {
+        return false;
+    }
+    const size_t sparseCount = layout.count;
+    indices.resize(sparseCount);
+    for (size_t i = 0; i < sparseCount; ++i) {
+        switch (indexType) {
+        case SparseIndices::ComponentType::UNSIGNED_BYTE:
+            indices[i] = indexData[i];
+            break;
+        case SparseIndices::ComponentType::UNSIGNED_SHORT: {
+            std::uint16_t index;
+            memcpy(&index, indexData + i * sizeof(index), sizeof(index));
+            indices[i] = index;
+            break;
+        }
+        case SparseIndices::ComponentType::UNSIGNED_INT:
+            memcpy(&indices[i], indexData + i * sizeof(std::uint32_t), sizeof(std::uint32_t));
+            break;
+        }
+    }
+    return true;
+}
+
+template<typename T>
+bool Accessor::readSparseValues(std::vector<T>& values, AccessorLayout& layout,
+                                SparseIndices::ComponentType& indexType, const unsigned char*& indexData) const noexcept {
+    const Sparse sparseObject = sparse();
+    if (!sparseObject) {
+        return false;
+    }
+    const ComponentType component = componentType();
+    const size_t sparseCount = sparseObject.count();
+    // sparse indices and values are tightly packed
+    const SparseIndices indices = sparseObject.indices();
+    indexType = indices.componentType();
+    const size_t indexSize = indexType == SparseIndices::ComponentType::UNSIGNED_BYTE ? 1
+        : indexType == SparseIndices::ComponentType::UNSIGNED_SHORT ? 2 : 4;
+    const DataView indexView = indices.bufferView().data();
+    const size_t indexOffset = indices.byteOffset();
+    if (!indexView || indexOffset > indexView.byteLength() || sparseCount * indexSize > indexView.byteLength() - indexOffset) {
+        return false;
+    }
+    indexData = indexView.data() + indexOffset;
+
+    const SparseValues sparseValues = sparseObject.values();
+    const DataView valueView = sparseValues.bufferView().data();
+    layout = accessorLayout(type(), component, normalized());
+    if (!bindLayout(layout, DataView(valueView.data(), valueView.byteLength()), sparseValues.byteOffset(), sparseCount)) {
+        return false;
+    }
+    values.resize(sparseCount * layout.components());
+    convertComponents(component, layout, values.data());
+    return true;
+}
+
+template<typename T>
+bool Accessor::applySparse(T* out) const noexcept {
+    std::vector<T> values;
+    AccessorLayout layout;
+    SparseIndices::ComponentType indexType;
+    const unsigned char* indexData;
+    if (!readSparseValues(values, layout, indexType, indexData)) {
+        return false;
+    }
+    const size_t components = layout.components();
+    const size_t elementCount = count();
+    switch (indexType) {
+    case SparseIndices::ComponentType::UNSIGNED_BYTE:
+        return scatterSparse<std::uint8_t>(indexData, values.data(), layout.count, components, elementCount, out);
+    case SparseIndices::ComponentType::UNSIGNED_SHORT:
+        return scatterSparse<std::uint16_t>(indexData, values.data(), layout.count, components, elementCount, out);
+    case SparseIndices::ComponentType::UNSIGNED_INT:
+        return scatterSparse<std::uint32_t>(indexData, values.data(), layout.count, components, elementCount, out);
+    }
+    return false;
+}
+
+template<typename T>
+bool Accessor::read(std::vector<T>& out) const noexcept {
+    out.resize(count() * numberOfComponents(type()));
+    return read(out.data());
+}
+
 inline std::vector<Primitive> Mesh::primitives() const noexcept {
+    size_t i;
+    if (compiled(Collection::MESHES, i)) {
+        std::vector<Primitive> primitives;
+        const size_t count = primitiveCount();
+        primitives.reserve(count);
+        for (size_t p = 0; p < count; ++p) {
+            primitives.push_back(primitive(p));
+        }
+        return primitives;
+    }
     return getObjectVector<Primitive>(m_gltf, m_json, "primitives");
 }
+
+inline bool CompressedAnimation::build(const AnimationEvaluator& animation, float frameRate, float tolerance) {
+    m_tracks.clear();
+    m_frames.clear();
+    m_values.clear();
+    m_ranges.clear();
+    m_frameRate = frameRate;
+    m_duration = animation.duration();
+    if (!(frameRate > 0.0f)) {
+        return false;
+    }
+    const size_t frameCount = static_cast<size_t>(std::ceil(m_duration * frameRate)) + 1;
+    std::vector<float> samples;
+    // the lowest and highest slope of each component
+    std::vector<float> slopes;
+    std::vector<std::uint32_t> keys;
+    for (size_t c = 0; c < animation.channelCount(); ++c) {
+        const AnimationEvaluator::Channel& channel = animation.channel(c);
+        const bool rotation = channel.path == TargetPath::ROTATION;
+        const size_t n = animation.components(c);
+        if (n == 0 || (rotation && n != 4)) {
+            continue;
+        }
+        // resample
+        samples.resize(frameCount * n);
+        std::uint32_t cursor = 0;
+        for (size_t f = 0; f < frameCount; ++f) {
+            float* v = &samples[f * n];
+            animation.sample(c, f / frameRate, cursor, v);
+            if (rotation && f > 0) {
+                // keep neighbouring quaternions in the same hemisphere so they can be compared
+                const float* p = v - 4;
+                if (p[0] * v[0] + p[1] * v[1] + p[2] * v[2] + p[3] * v[3] < 0.0f) {
+                    for (size_t i = 0; i < 4; ++i) {
+                        v[i] = -v[i];
+                    }
+                }
+            }
+        }
+        // greedily extend each interpolated segment as far as possible
+        keys.assign(1, 0);
+        if (rotation) {
+            // returns true if slerping frames first and last is within the tolerance for every frame between them
+            auto canSkip = [&](size_t first, size_t last) {
+                const float* a = &samples[first * 4];
+                const float* b = &samples[last * 4];
+                float v[4];
+                for (size_t f = first + 1; f < last; ++f) {
+                    slerp(a, b, static_cast<float>(f - first) / (last - first), v);
+                    const float* expected = &samples[f * 4];
+                    for (size_t i = 0; i < 4; ++i) {
+                        if (std::fabs(v[i] - expected[i]) > tolerance) {
+                            return false;
+                        }
+                    }
+                }
+                return true;
+            };
+            for (size_t f = 2; f < frameCount; ++f) {
+                if (f - keys.back() > MAX_ROTATION_KEY_GAP || !canSkip(keys.back(), f)) {
+                    keys.push_back(static_cast<std::uint32_t>(f - 1));
+                }
+            }
+        }
+        else {
+            // a line from the last key keeps a frame within the tolerance if its slope is in an interval, so the
+            // intersection of the intervals of the frames since the key is enough to check the next frame
+            slopes.resize(n * 2);
+            auto restart = [&]() {
+                for (size_t i = 0; i < n; ++i) {
+                    slopes[i * 2] = -std::numeric_limits<float>::infinity();
+                    slopes[i * 2 + 1] = std::numeric_limits<float>::infinity();
+                }
+            };
+            restart();
+            for (size_t f = 1; f < frameCount; ++f) {
+                const float* a = &samples[keys.back() * n];
+                const float* b = &samples[f * n];
+                float distance = static_cast<float>(f - keys.back());
+                if (f - keys.back() > 1) {
+                    for (size_t i = 0; i < n; ++i) {
+                        const float slope = (b[i] - a[i]) / distance;
+                        if (slope < slopes[i * 2] || slope > slopes[i * 2 + 1]) {
+                            keys.push_back(static_cast<std::uint32_t>(f - 1));
+                            a = &samples[(f - 1) * n];
+                            distance = 1.0f;
+                            restart();
+                            break;
+                        }
+                    }
+                }
+                // f is between the key and every later frame that is checked
+                for (size_t i = 0; i < n; ++i) {
+                    slopes[i * 2] = std::max(slopes[i * 2], (b[i] - tolerance - a[i]) / distance);
+                    slopes[i * 2 + 1] = std::min(slopes[i * 2 + 1], (b[i] + tolerance - a[i]) / distance);
+                }
+            }
+        }
+        if (frameCount > 1) {
+            keys.push_back(static_cast<std::uint32_t>(frameCount - 1));
+        }
+        Track track;
+        track.channel = channel.index;
+        track.node = channel.node;
+        track.path = channel.path;
+        track.components = static_cast<std::uint32_t>(n);
+        track.keyOffset = static_cast<std::uint32_t>(m_frames.size());
+        track.keyCount = static_cast<std::uint32_t>(keys.size());
+        track.valueOffset = static_cast<std::uint32_t>(m_values.size());
+        track.rangeOffset = static_cast<std::uint32_t>(m_ranges.size());
+        m_frames.insert(m_frames.end(), keys.begin(), keys.end());
+        if (rotation) {
+            for (std::uint32_t key : keys) {
+                std::uint16_t packed[3];
+                packQuaternion(&samples[key * 4], packed);
+                m_values.insert(m_values.end(), packed, packed + 3);
+            }
+        }
+        else {
+            for (size_t i = 0; i < n; ++i) {
+                float low = samples[keys[0] * n + i];
+                float high = low;
+                for (std::uint32_t key : keys) {
+                    low = std::min(low, samples[key * n + i]);
+                    high = std::max(high, samples[key * n + i]);
+                }
+                m_ranges.push_back(low);
+                m_ranges.push_back(high - low);
+            }
+            const float* ranges = &m_ranges[track.rangeOffset];
+            for (std::uint32_t key : keys) {
+                for (size_t i = 0; i < n; ++i) {
+                    const float extent = ranges[i * 2 + 1];
+                    const float x = extent > 0.0f ? (samples[key * n + i] - ranges[i * 2]) / extent : 0.0f;
+                    m_values.push_back(static_cast<std::uint16_t>(std::lround(x * 65535.0f)));
+                }
+            }
+        }
+        m_tracks.push_back(track);
+    }
+    return true;
+}
+
+inline bool AnimationEvaluator::load(const Animation& animation) {
+    m_channels.clear();
+    m_samplers.clear();
+    m_indices.clear();
+    m_times.clear();
+    m_values.clear();
+    m_duration = 0.0f;
+    if (!animation) {
+        return false;
+    }
+    bool loaded = true;
+    std::vector<float> input;
+    std::vector<float> output;
+    const size_t samplerCount = animation.samplerCount();
+    m_samplers.resize(samplerCount);
+    for (size_t i = 0; i < samplerCount; ++i) {
+        const AnimationSampler animationSampler = animation.sampler(i);
+        const Accessor in = animationSampler.input();
+        const Accessor out = animationSampler.output();
+        Sampler& sampler = m_samplers[i];
+        sampler.interpolation = animationSampler.interpolation();
+        const size_t keyCount = in.count();
+        const size_t valueCount = sampler.interpolation == Interpolation::CUBICSPLINE ? keyCount * 3 : keyCount;
+        // the output has one element per value or one per morph target per value for weights
+        if (keyCount == 0 || in.type() != Accessor::Type::SCALAR || out.count() == 0 || out.count() % valueCount != 0
+            || !in.read(input) || !out.read(output)) {
+            loaded = false;
+            continue;
+        }
+        sampler.keyOffset = static_cast<std::uint32_t>(m_times.size());
+        sampler.keyCount = static_cast<std::uint32_t>(keyCount);
+        sampler.valueOffset = static_cast<std::uint32_t>(m_values.size());
+        sampler.components = static_cast<std::uint32_t>(output.size() / valueCount);
+        m_times.insert(m_times.end(), input.begin(), input.end());
+        m_values.insert(m_values.end(), output.begin(), output.end());
+        m_duration = std::max(m_duration, input.back());
+    }
+    m_indices.resize(samplerCount);
+    for (size_t i = 0; i < samplerCount; ++i) {
+        m_indices[i].build(m_times.data() + m_samplers[i].keyOffset, m_samplers[i].keyCount);
+    }
+    const size_t channelCount = animation.channelCount();
+    m_channels.reserve(channelCount);
+    for (size_t i = 0; i < channelCount; ++i) {
+        const LAZY_GLTF2_NAMESPACE::Channel animationChannel = animation.channel(i);
+        size_t samplerIndex;
+        if (!animationChannel.sampler(samplerIndex) || samplerIndex >= samplerCount
+            || m_samplers[samplerIndex].keyCount == 0) {
+            loaded = false;
+            continue;
+        }
+        Channel channel;
+        channel.index = static_cast<std::uint32_t>(i);
+        channel.sampler = static_cast<std::uint32_t>(samplerIndex);
+        const LAZY_GLTF2_NAMESPACE::Channel::Target target = animationChannel.target();
+        size_t node;
+        if (target.node(node)) {
+            channel.node = static_cast<std::uint32_t>(node);
+        }
+        channel.path = target.path();
+        m_channels.push_back(channel);
+    }
+    return loaded;
+}
 } // namespace LAZY_GLTF2_NAMESPACE
 
 #endif // LAZY_GLTF2_HPP
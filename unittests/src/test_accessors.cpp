@@ -0,0 +1,95 @@
+#include <lazy_gltf2.hpp>
+#include <gtest/gtest.h>
+#include <array>
+#include <algorithm>
+#include <limits>
+
+#include "common.hpp"
+
+using namespace gltf2;
+
+/// Converts every value of S with convertNormalized() and compares it with normalizedToFloat().
+template<typename S>
+static void testConvertNormalized(Accessor::ComponentType type) {
+    std::vector<S> values;
+    for (int64_t i = std::numeric_limits<S>::min(); i <= std::numeric_limits<S>::max(); ++i) {
+        values.push_back(static_cast<S>(i));
+    }
+    // start one byte in so the input isn't aligned
+    const auto* raw = reinterpret_cast<const unsigned char*>(values.data());
+    std::vector<unsigned char> bytes(1);
+    bytes.insert(bytes.end(), raw, raw + values.size() * sizeof(S));
+    std::vector<float> actual(values.size());
+    convertNormalized(type, bytes.data() + 1, values.size(), actual.data());
+    for (size_t i = 0; i < values.size(); ++i) {
+        ASSERT_EQ(normalizedToFloat(values[i]), actual[i]) << static_cast<int64_t>(values[i]);
+        ASSERT_GE(actual[i], -1.0f);
+        ASSERT_LE(actual[i], 1.0f);
+    }
+}
+
+TEST(accessors, convertNormalized) {
+    testConvertNormalized<std::uint8_t>(Accessor::ComponentType::UNSIGNED_BYTE);
+    testConvertNormalized<std::int8_t>(Accessor::ComponentType::BYTE);
+    testConvertNormalized<std::uint16_t>(Accessor::ComponentType::UNSIGNED_SHORT);
+    testConvertNormalized<std::int16_t>(Accessor::ComponentType::SHORT);
+
+    EXPECT_EQ(1.0f, normalizedToFloat(std::uint8_t(255)));
+    EXPECT_EQ(1.0f, normalizedToFloat(std::int8_t(127)));
+    EXPECT_EQ(-1.0f, normalizedToFloat(std::int8_t(-127)));
+    EXPECT_EQ(-1.0f, normalizedToFloat(std::int8_t(-128)));
+    EXPECT_EQ(-1.0f, normalizedToFloat(std::int16_t(-32768)));
+    EXPECT_EQ(1.0f, normalizedToFloat(std::uint16_t(65535)));
+
+    // odd lengths use the scalar tail
+    const std::array<std::uint8_t, 3> small{ 0, 51, 255 };
+    std::array<float, 3> out;
+    convertNormalized(Accessor::ComponentType::UNSIGNED_BYTE, small.data(), small.size(), out.data());
+    EXPECT_EQ(0.0f, out[0]);
+    EXPECT_FLOAT_EQ(0.2f, out[1]);
+    EXPECT_EQ(1.0f, out[2]);
+}
+
+static const char* SPARSE_PATH = LAZY_GLTF2_BASE_SAMPLE_DIR "/2.0/SimpleSparseAccessor/glTF/SimpleSparseAccessor.gltf";
+
+TEST(accessors, sparse) {
+    Gltf gltf(SPARSE_PATH);
+    ASSERT_TRUE(gltf);
+    auto accessor = gltf.mesh(0).primitive(0).position();
+    ASSERT_TRUE(accessor.sparse());
+    EXPECT_FALSE((AccessorView<float, 3>(accessor)));
+
+    std::vector<std::uint32_t> indices;
+    std::vector<float> values;
+    ASSERT_TRUE(accessor.readSparse(indices, values));
+    const size_t sparseCount = accessor.sparse().count();
+    ASSERT_EQ(sparseCount, indices.size());
+    ASSERT_EQ(sparseCount * 3, values.size());
+
+    std::vector<float> positions;
+    ASSERT_TRUE(accessor.read(positions));
+    ASSERT_EQ(accessor.count() * 3, positions.size());
+
+    // the sparse values replace the base values
+    for (size_t i = 0; i < sparseCount; ++i) {
+        for (size_t c = 0; c < 3; ++c) {
+            EXPECT_EQ(values[i * 3 + c], positions[indices[i] * 3 + c]);
+        }
+    }
+    // every other element comes from the base buffer view
+    const auto base = accessor.bufferView().data();
+    ASSERT_TRUE(base);
+    for (size_t i = 0; i < accessor.count(); ++i) {
+        if (std::find(indices.begin(), indices.end(), i) != indices.end()) {
+            continue;
+        }
+        std::array<float, 3> expected;
+        memcpy(expected.data(), base.data() + accessor.byteOffset() + i * 12, sizeof(expected));
+        EXPECT_EQ(expected[0], positions[i * 3]);
+        EXPECT_EQ(expected[1], positions[i * 3 + 1]);
+        EXPECT_EQ(expected[2], positions[i * 3 + 2]);
+    }
+
+    // accessors that aren't sparse don't have sparse values
+    EXPECT_FALSE(gltf.accessor(0).readSparse(indices, values));
+}
@@ -0,0 +1,471 @@
+#include <lazy_gltf2.hpp>
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <string>
+
+#include "common.hpp"
+
+using namespace gltf2;
+
+struct TestSampler {
+    std::vector<float> times;
+    std::vector<float> values;
+    const char* type;
+    const char* interpolation;
+};
+
+struct TestChannel {
+    size_t sampler;
+    size_t node;
+    const char* path;
+};
+
+/// Loads a glTF with nodeCount nodes and one animation. The sampler data is in an external buffer.
+static bool loadAnimation(Gltf& gltf, const std::vector<TestSampler>& samplers, const std::vector<TestChannel>& channels,
+                          size_t nodeCount = 4) {
+    std::vector<float> data;
+    std::string views, accessors, animationSamplers, animationChannels;
+    for (const auto& sampler : samplers) {
+        for (const auto* values : { &sampler.times, &sampler.values }) {
+            const size_t index = accessors.empty() ? 0 : std::count(accessors.begin(), accessors.end(), '{');
+            const size_t components = values == &sampler.times ? 1 : std::string(sampler.type) == "VEC4" ? 4
+                                    : std::string(sampler.type) == "VEC3" ? 3 : 1;
+            const char* type = values == &sampler.times ? "SCALAR" : sampler.type;
+            views += std::string(views.empty() ? "" : ", ") + R"({ "buffer": 0, "byteOffset": )"
+                + std::to_string(data.size() * 4) + R"(, "byteLength": )" + std::to_string(values->size() * 4) + " }";
+            accessors += std::string(accessors.empty() ? "" : ", ") + R"({ "bufferView": )" + std::to_string(index)
+                + R"(, "componentType": 5126, "count": )" + std::to_string(values->size() / components)
+                + R"(, "type": ")" + type + "\" }";
+            data.insert(data.end(), values->begin(), values->end());
+        }
+        const size_t input = animationSamplers.empty() ? 0 : std::count(animationSamplers.begin(), animationSamplers.end(), '{') * 2;
+        animationSamplers += std::string(animationSamplers.empty() ? "" : ", ") + R"({ "input": )" + std::to_string(input)
+            + R"(, "output": )" + std::to_string(input + 1) + R"(, "interpolation": ")" + sampler.interpolation + "\" }";
+    }
+    for (const auto& channel : channels) {
+        animationChannels += std::string(animationChannels.empty() ? "" : ", ") + R"({ "sampler": )"
+            + std::to_string(channel.sampler) + R"(, "target": { "node": )" + std::to_string(channel.node)
+            + R"(, "path": ")" + channel.path + "\" } }";
+    }
+    std::string nodes;
+    for (size_t i = 0; i < nodeCount; ++i) {
+        nodes += i > 0 ? ", { }" : "{ }";
+    }
+    const std::string json = R"({ "asset": { "version": "2.0" }, "nodes": [ )" + nodes
+        + R"( ], "buffers": [ { "uri": "animation.bin", "byteLength": )" + std::to_string(data.size() * 4)
+        + R"( } ], "bufferViews": [ )" + views + R"( ], "accessors": [ )" + accessors
+        + R"( ], "animations": [ { "samplers": [ )" + animationSamplers + R"( ], "channels": [ )"
+        + animationChannels + " ] } ] }";
+    auto resolver = [data](const char*, std::vector<unsigned char>& bytes) {
+        bytes.resize(data.size() * 4);
+        memcpy(bytes.data(), data.data(), bytes.size());
+        return true;
+    };
+    return gltf.load(json.data(), json.size(), resolver);
+}
+
+TEST(animation, findKeyframe) {
+    const float times[] = { 0, 1, 2, 3, 4, 5 };
+    std::uint32_t cursor = 0;
+    EXPECT_EQ(0, findKeyframe(times, 6, -1.0f, cursor));
+    EXPECT_EQ(0, findKeyframe(times, 6, 0.5f, cursor));
+    EXPECT_EQ(1, findKeyframe(times, 6, 1.0f, cursor));
+    EXPECT_EQ(1, cursor);
+    EXPECT_EQ(3, findKeyframe(times, 6, 3.5f, cursor));
+    // past the end stays on the last interval
+    EXPECT_EQ(4, findKeyframe(times, 6, 9.0f, cursor));
+    // backwards
+    EXPECT_EQ(2, findKeyframe(times, 6, 2.5f, cursor));
+    EXPECT_EQ(0, findKeyframe(times, 6, 0.0f, cursor));
+    cursor = 100;
+    EXPECT_EQ(4, findKeyframe(times, 6, 4.5f, cursor));
+    EXPECT_EQ(0, findKeyframe(times, 1, 4.5f, cursor));
+}
+
+TEST(animation, slerp) {
+    const float h = std::sqrt(0.5f);
+    const float a[4] = { 0, 0, 0, 1 };
+    const float b[4] = { 0, 0, h, h };
+    float q[4];
+    slerp(a, b, 0.5f, q);
+    EXPECT_NEAR(std::sin(3.14159265f / 8), q[2], 1e-6f);
+    EXPECT_NEAR(std::cos(3.14159265f / 8), q[3], 1e-6f);
+    // the shortest path is used when the quaternions are in opposite hemispheres
+    const float c[4] = { 0, 0, -h, -h };
+    slerp(a, c, 0.5f, q);
+    EXPECT_NEAR(std::sin(3.14159265f / 8), q[2], 1e-6f);
+    EXPECT_NEAR(std::cos(3.14159265f / 8), q[3], 1e-6f);
+    slerp(a, a, 0.3f, q);
+    EXPECT_FLOAT_EQ(1.0f, q[3]);
+}
+
+TEST(animation, evaluator) {
+    const float h = std::sqrt(0.5f);
+    Gltf gltf;
+    ASSERT_TRUE(loadAnimation(gltf, {
+        { { 0, 1, 2 }, { 0, 0, 0, 1, 2, 3, 2, 4, 6 }, "VEC3", "LINEAR" },
+        { { 0, 1 }, { 0, 0, 0, 1, 0, 0, h, h }, "VEC4", "LINEAR" },
+        { { 0, 1, 2 }, { 1, 1, 1, 2, 2, 2, 3, 3, 3 }, "VEC3", "STEP" },
+        // in-tangent, value and out-tangent of each key
+        { { 0, 2 }, { 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 4, 0, 0, 0, 0, 0 }, "VEC3", "CUBICSPLINE" },
+        // two morph target weights
+        { { 0, 4 }, { 0, 1, 1, 0 }, "SCALAR", "LINEAR" },
+    }, {
+        { 0, 1, "translation" }, { 1, 1, "rotation" }, { 2, 2, "scale" }, { 3, 3, "translation" }, { 4, 0, "weights" },
+    }));
+    AnimationEvaluator evaluator(gltf.animation(0));
+    ASSERT_EQ(5, evaluator.channelCount());
+    EXPECT_EQ(5, evaluator.samplerCount());
+    EXPECT_EQ(4.0f, evaluator.duration());
+    EXPECT_EQ(1, evaluator.channel(0).node);
+    EXPECT_EQ(TargetPath::ROTATION, evaluator.channel(1).path);
+    EXPECT_EQ(3, evaluator.components(0));
+    EXPECT_EQ(4, evaluator.components(1));
+    EXPECT_EQ(2, evaluator.components(4));
+
+    std::uint32_t cursor = 0;
+    float v[4];
+    evaluator.sample(0, 0.5f, cursor, v);
+    EXPECT_FLOAT_EQ(0.5f, v[0]);
+    EXPECT_FLOAT_EQ(1.5f, v[2]);
+    evaluator.sample(0, 1.5f, cursor, v);
+    EXPECT_FLOAT_EQ(1.5f, v[0]);
+    EXPECT_FLOAT_EQ(4.5f, v[2]);
+    EXPECT_EQ(1, cursor);
+    evaluator.sample(0, 10.0f, cursor, v);
+    EXPECT_FLOAT_EQ(2.0f, v[0]);
+    evaluator.sample(0, -1.0f, cursor, v);
+    EXPECT_FLOAT_EQ(0.0f, v[0]);
+
+    cursor = 0;
+    evaluator.sample(1, 0.5f, cursor, v);
+    EXPECT_NEAR(std::sin(3.14159265f / 8), v[2], 1e-6f);
+    EXPECT_NEAR(std::cos(3.14159265f / 8), v[3], 1e-6f);
+
+    cursor = 0;
+    evaluator.sample(2, 1.9f, cursor, v);
+    EXPECT_FLOAT_EQ(2.0f, v[0]);
+
+    // hermite spline from 0 with an out-tangent of 1 to 4 with an in-tangent of 0 over 2 seconds
+    cursor = 0;
+    evaluator.sample(3, 1.0f, cursor, v);
+    const float t = 0.5f;
+    const float expected = (t * t * t - 2 * t * t + t) * 2 * 1 + (-2 * t * t * t + 3 * t * t) * 4;
+    EXPECT_FLOAT_EQ(expected, v[0]);
+    evaluator.sample(3, 2.0f, cursor, v);
+    EXPECT_FLOAT_EQ(4.0f, v[0]);
+
+    cursor = 0;
+    evaluator.sample(4, 1.0f, cursor, v);
+    EXPECT_FLOAT_EQ(0.25f, v[0]);
+    EXPECT_FLOAT_EQ(0.75f, v[1]);
+
+    // every channel at once
+    std::vector<std::uint32_t> cursors(evaluator.channelCount(), 0);
+    std::vector<float> all(3 + 4 + 3 + 3 + 2);
+    evaluator.sample(0.5f, cursors.data(), all.data());
+    EXPECT_FLOAT_EQ(0.5f, all[0]);
+    EXPECT_NEAR(std::cos(3.14159265f / 8), all[6], 1e-6f);
+    EXPECT_FLOAT_EQ(1.0f, all[7]);
+    EXPECT_FLOAT_EQ(0.125f, all[13]);
+    EXPECT_FLOAT_EQ(0.875f, all[14]);
+}
+
+TEST(animation, evaluator_invalid) {
+    Gltf gltf;
+    ASSERT_TRUE(loadAnimation(gltf, {
+        { { 0, 1 }, { 0, 0, 0, 1, 1, 1 }, "VEC3", "LINEAR" },
+        // a cubic spline needs three values per key
+        { { 0, 1 }, { 0, 0, 0, 1, 1, 1 }, "VEC3", "CUBICSPLINE" },
+    }, {
+        { 1, 1, "translation" }, { 0, 0, "translation" }, { 0, 2, "scale" },
+    }));
+    AnimationEvaluator evaluator;
+    EXPECT_FALSE(evaluator.load(gltf.animation(0)));
+    // the channels that are left still know their glTF channel
+    ASSERT_EQ(2, evaluator.channelCount());
+    EXPECT_EQ(1, evaluator.channel(0).index);
+    EXPECT_EQ(2, evaluator.channel(1).index);
+    EXPECT_EQ(2, evaluator.channel(1).node);
+    CompressedAnimation compressed;
+    ASSERT_TRUE(compressed.build(evaluator, 30.0f, 0.001f));
+    ASSERT_EQ(2, compressed.trackCount());
+    EXPECT_EQ(1, compressed.track(0).channel);
+    EXPECT_EQ(2, compressed.track(1).channel);
+    EXPECT_FALSE(evaluator.load(Animation()));
+    EXPECT_EQ(0, evaluator.channelCount());
+}
+
+TEST(animation, batch) {
+    const float h = std::sqrt(0.5f);
+    Gltf gltf;
+    ASSERT_TRUE(loadAnimation(gltf, {
+        { { 0, 1, 2 }, { 0, 0, 0, 1, 2, 3, 2, 4, 6 }, "VEC3", "LINEAR" },
+        { { 0, 1, 3 }, { 0, 0, 0, 1, 0, 0, h, h, 0, 0, -h, -h }, "VEC4", "LINEAR" },
+        { { 0, 1, 2 }, { 1, 1, 1, 2, 2, 2, 3, 3, 3 }, "VEC3", "STEP" },
+        { { 0, 2 }, { 0, 1 }, "SCALAR", "LINEAR" },
+    }, {
+        { 0, 1, "translation" }, { 1, 1, "rotation" }, { 2, 2, "scale" }, { 3, 0, "weights" }, { 0, 9, "translation" },
+    }));
+    AnimationEvaluator evaluator(gltf.animation(0));
+    ASSERT_EQ(5, evaluator.channelCount());
+
+    // not a multiple of four so the last instances are sampled one at a time
+    const size_t count = 11;
+    PoseBatch pose(gltf.nodeCount(), count);
+    EXPECT_FLOAT_EQ(1.0f, pose.rotation(3, 3)[count - 1]);
+    EXPECT_FLOAT_EQ(1.0f, pose.scale(0, 2)[0]);
+    std::vector<float> times;
+    for (size_t i = 0; i < count; ++i) {
+        times.push_back(-0.5f + i * 0.37f);
+    }
+    std::vector<std::uint32_t> cursors(evaluator.channelCount() * count, 0);
+    // twice to move the cursors
+    evaluator.sampleBatch(times.data(), cursors.data(), pose);
+    for (auto& time : times) {
+        time += 0.1f;
+    }
+    evaluator.sampleBatch(times.data(), cursors.data(), pose);
+
+    for (size_t i = 0; i < count; ++i) {
+        std::uint32_t cursor = 0;
+        float v[4];
+        evaluator.sample(0, times[i], cursor, v);
+        for (size_t j = 0; j < 3; ++j) {
+            EXPECT_NEAR(v[j], pose.translation(1, j)[i], 1e-6f) << i;
+        }
+        evaluator.sample(1, times[i], cursor, v);
+        for (size_t j = 0; j < 4; ++j) {
+            EXPECT_NEAR(v[j], pose.rotation(1, j)[i], 1e-6f) << i;
+        }
+        evaluator.sample(2, times[i], cursor, v);
+        for (size_t j = 0; j < 3; ++j) {
+            EXPECT_NEAR(v[j], pose.scale(2, j)[i], 1e-6f) << i;
+        }
+        // untargeted nodes keep the identity
+        EXPECT_EQ(0.0f, pose.translation(3, 0)[i]);
+        EXPECT_EQ(1.0f, pose.scale(1, 0)[i]);
+    }
+}
+
+TEST(animation, batch_rest_pose) {
+    static const char json[] = R"({
+        "asset": { "version": "2.0" },
+        "nodes": [ { "translation": [ 1, 2, 3 ], "scale": [ 2, 2, 2 ] }, { "matrix": [ 2, 0, 0, 0, 0, 2, 0, 0, 0, 0, 2, 0, 0, 0, 0, 1 ] } ]
+    })";
+    Gltf gltf;
+    ASSERT_TRUE(gltf.load(json, sizeof(json) - 1));
+    PoseBatch pose(2, 5);
+    pose.setRestPose(gltf);
+    EXPECT_EQ(3.0f, pose.translation(0, 2)[4]);
+    EXPECT_EQ(2.0f, pose.scale(0, 1)[0]);
+    EXPECT_EQ(1.0f, pose.rotation(0, 3)[2]);
+    EXPECT_EQ(1.0f, pose.scale(1, 0)[0]);
+}
+
+TEST(animation, packQuaternion) {
+    const float quaternions[][4] = {
+        { 0, 0, 0, 1 }, { 0, 0, 0, -1 }, { 1, 0, 0, 0 }, { 0.5f, -0.5f, 0.5f, -0.5f },
+        { 0.1825742f, 0.3651484f, -0.5477226f, 0.7302967f }, { -0.9f, 0.1f, 0.3f, 0.3f },
+    };
+    for (const auto& quaternion : quaternions) {
+        float q[4];
+        float length = 0.0f;
+        for (size_t i = 0; i < 4; ++i) {
+            length += quaternion[i] * quaternion[i];
+        }
+        for (size_t i = 0; i < 4; ++i) {
+            q[i] = quaternion[i] / std::sqrt(length);
+        }
+        std::uint16_t packed[3];
+        packQuaternion(q, packed);
+        float unpacked[4];
+        unpackQuaternion(packed, unpacked);
+        // q and -q are the same rotation
+        const float dot = q[0] * unpacked[0] + q[1] * unpacked[1] + q[2] * unpacked[2] + q[3] * unpacked[3];
+        EXPECT_NEAR(1.0f, std::fabs(dot), 1e-6f);
+        for (size_t i = 0; i < 4; ++i) {
+            EXPECT_NEAR(q[i], dot < 0.0f ? -unpacked[i] : unpacked[i], 1e-4f);
+        }
+    }
+}
+
+TEST(animation, compress) {
+    const float h = std::sqrt(0.5f);
+    Gltf gltf;
+    ASSERT_TRUE(loadAnimation(gltf, {
+        { { 0, 2 }, { 0, 0, 0, 2, 4, -6 }, "VEC3", "LINEAR" },
+        { { 0, 1 }, { 0, 0, 0, 1, 0, 0, h, h }, "VEC4", "LINEAR" },
+        { { 0, 1, 2 }, { 1, 1, 1, 2, 2, 2, 3, 3, 3 }, "VEC3", "STEP" },
+        { { 0, 2 }, { 0, 0, 0, 0, 0, 0, 3, 0, 0, 0, 0, 0, 1, 1, 1, 0, 0, 0 }, "VEC3", "CUBICSPLINE" },
+    }, {
+        { 0, 0, "translation" }, { 1, 0, "rotation" }, { 2, 1, "scale" }, { 3, 2, "translation" },
+    }));
+    AnimationEvaluator evaluator(gltf.animation(0));
+    CompressedAnimation compressed;
+    EXPECT_FALSE(compressed.build(evaluator, 0.0f, 0.001f));
+    const float tolerance = 0.001f;
+    ASSERT_TRUE(compressed.build(evaluator, 120.0f, tolerance));
+    ASSERT_EQ(4, compressed.trackCount());
+    EXPECT_EQ(2.0f, compressed.duration());
+    // 241 frames; the linear tracks only need their ends
+    EXPECT_EQ(2, compressed.track(0).keyCount);
+    // the rotation stops after 1 second but the rotation keys are at most MAX_ROTATION_KEY_GAP frames apart
+    const CompressedAnimation::Track& rotation = compressed.track(1);
+    EXPECT_EQ(TargetPath::ROTATION, rotation.path);
+    EXPECT_EQ(5, rotation.keyCount);
+    for (size_t k = 1; k < rotation.keyCount; ++k) {
+        const std::uint32_t* frames = &compressed.frames()[rotation.keyOffset];
+        EXPECT_LE(frames[k] - frames[k - 1], CompressedAnimation::MAX_ROTATION_KEY_GAP);
+    }
+    // each step needs a key on both sides
+    EXPECT_LE(compressed.track(2).keyCount, 6);
+    EXPECT_GT(compressed.track(3).keyCount, 2);
+    EXPECT_LT(compressed.track(3).keyCount, 241);
+    EXPECT_LT(compressed.byteSize(), evaluator.values().size() * sizeof(float) * 241 / 2);
+
+    // quantization adds up to half a step of the range
+    const float quantization[] = { 6.0f / 65535, 1e-4f, 2.0f / 65535, 1.0f / 65535 };
+    for (size_t track = 0; track < compressed.trackCount(); ++track) {
+        std::uint32_t cursor = 0;
+        std::uint32_t compressedCursor = 0;
+        for (size_t f = 0; f <= 250; ++f) {
+            // the steps are between frames so only the frames are compared
+            const float time = f / 120.0f;
+            float expected[4], actual[4];
+            evaluator.sample(track, time, cursor, expected);
+            compressed.sample(track, time, compressedCursor, actual);
+            for (size_t i = 0; i < compressed.track(track).components; ++i) {
+                ASSERT_NEAR(expected[i], actual[i], tolerance + quantization[track]) << track << " " << f;
+            }
+        }
+    }
+}
+
+TEST(animation, compress_long) {
+    // ten minutes with a few keys must not check every frame against every later frame
+    Gltf gltf;
+    ASSERT_TRUE(loadAnimation(gltf, {
+        { { 0, 300, 600 }, { 0, 0, 0, 3, 6, 9, 0, 0, 0 }, "VEC3", "LINEAR" },
+        { { 0, 600 }, { 0, 0, 0, 1, 0, 0, 0, 1 }, "VEC4", "LINEAR" },
+    }, {
+        { 0, 0, "translation" }, { 1, 0, "rotation" },
+    }));
+    AnimationEvaluator evaluator(gltf.animation(0));
+    CompressedAnimation compressed;
+    ASSERT_TRUE(compressed.build(evaluator, 120.0f, 0.001f));
+    EXPECT_EQ(3, compressed.track(0).keyCount);
+    EXPECT_EQ(600 * 120 / CompressedAnimation::MAX_ROTATION_KEY_GAP + 1, compressed.track(1).keyCount);
+}
+
+/// Compares KeyframeIndex::find() with a binary search over the times.
+static void testKeyframeIndex(const std::vector<float>& times, bool uniform) {
+    const KeyframeIndex index(times.data(), times.size());
+    EXPECT_EQ(uniform, index.uniform());
+    const float first = times.front() - 1.0f;
+    const float range = times.back() - times.front() + 2.0f;
+    std::uint32_t cursor = 0;
+    for (size_t i = 0; i <= 5000; ++i) {
+        // scrub back and forth and include every key exactly
+        const float time = i % 2 == 0 ? first + range * ((i * 7919) % 5001) / 5000.0f : times[(i * 31) % times.size()];
+        size_t expected = std::upper_bound(times.begin(), times.end(), time) - times.begin();
+        expected = std::min(expected > 0 ? expected - 1 : 0, times.size() - 2);
+        ASSERT_EQ(expected, index.find(times.data(), time)) << time;
+        ASSERT_EQ(expected, index.find(times.data(), time, cursor)) << time;
+        ASSERT_EQ(expected, cursor);
+        // playing forward from the cursor
+        const float next = time + 0.01f;
+        expected = std::upper_bound(times.begin(), times.end(), next) - times.begin();
+        expected = std::min(expected > 0 ? expected - 1 : 0, times.size() - 2);
+        ASSERT_EQ(expected, index.find(times.data(), next, cursor)) << next;
+    }
+}
+
+TEST(animation, keyframeIndex) {
+    std::vector<float> times;
+    // rounded frame times are still uniform
+    for (size_t i = 0; i < 3000; ++i) {
+        times.push_back(0.5f + i / 30.0f);
+    }
+    testKeyframeIndex(times, true);
+
+    // dense in the middle and sparse at the ends
+    times.clear();
+    for (size_t i = 0; i < 1000; ++i) {
+        const float x = (i - 500.0f) / 500.0f;
+        times.push_back(x * x * x * 10.0f);
+    }
+    testKeyframeIndex(times, false);
+
+    // repeated times
+    testKeyframeIndex({ 0, 1, 1, 1, 2, 5, 5, 9 }, false);
+    testKeyframeIndex({ 0, 1 }, true);
+
+    KeyframeIndex empty;
+    EXPECT_EQ(0, empty.find(nullptr, 1.0f));
+    const float one = 1.0f;
+    KeyframeIndex single(&one, 1);
+    EXPECT_FALSE(single.uniform());
+    EXPECT_EQ(0, single.find(&one, 2.0f));
+
+    // times that aren't finite find the first key
+    const float keys[] = { 0, 1, 2, 3 };
+    KeyframeIndex index(keys, 4);
+    std::uint32_t cursor = 2;
+    for (float time : { std::nanf(""), std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity() }) {
+        EXPECT_EQ(0, index.find(keys, time));
+        EXPECT_EQ(0, index.find(keys, time, cursor));
+    }
+}
+
+TEST(animation, animationIndex) {
+    static const char json[] = R"({
+        "asset": { "version": "2.0" },
+        "nodes": [ { }, { }, { } ],
+        "animations": [
+            { "channels": [
+                { "sampler": 0, "target": { "node": 2, "path": "rotation" } },
+                { "sampler": 1, "target": { "node": 0, "path": "translation" } },
+                { "sampler": 2, "target": { "node": 2, "path": "translation" } },
+                { "sampler": 3, "target": { "path": "weights" } },
+                { "sampler": 4, "target": { "node": 7, "path": "scale" } },
+                5
+            ] },
+            { "channels": [ ] },
+            { "channels": [ { "sampler": 0, "target": { "node": 2, "path": "scale" } } ] }
+        ]
+    })";
+    Gltf gltf;
+    ASSERT_TRUE(gltf.load(json, sizeof(json) - 1));
+    const AnimationIndex& index = gltf.animationIndex();
+    ASSERT_EQ(3, index.animationCount());
+    ASSERT_EQ(3, index.nodeCount());
+
+    size_t count;
+    const AnimationIndex::Entry* entries = index.channels(0, 2, count);
+    ASSERT_EQ(2, count);
+    EXPECT_EQ(TargetPath::TRANSLATION, entries[0].path);
+    EXPECT_EQ(2, entries[0].channel);
+    EXPECT_EQ(TargetPath::ROTATION, entries[1].path);
+    EXPECT_EQ(0, entries[1].channel);
+    index.channels(0, 1, count);
+    EXPECT_EQ(0, count);
+    index.channels(1, 2, count);
+    EXPECT_EQ(0, count);
+
+    EXPECT_EQ(1, index.findChannel(0, 0, TargetPath::TRANSLATION));
+    EXPECT_EQ(0, index.findChannel(0, 2, TargetPath::ROTATION));
+    EXPECT_EQ(AnimationIndex::NONE, index.findChannel(0, 2, TargetPath::SCALE));
+    EXPECT_EQ(0, index.findChannel(2, 2, TargetPath::SCALE));
+
+    ASSERT_EQ(1, index.animationCount(0));
+    EXPECT_EQ(0, index.animations(0)[0]);
+    EXPECT_EQ(0, index.animationCount(1));
+    ASSERT_EQ(2, index.animationCount(2));
+    EXPECT_EQ(0, index.animations(2)[0]);
+    EXPECT_EQ(2, index.animations(2)[1]);
+
+    EXPECT_EQ(0, Gltf().animationIndex().animationCount());
+}
@@ -1,6 +1,11 @@
 #include <lazy_gltf2.hpp>
 #include <gtest/gtest.h>
 #include <array>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iterator>
+#include <map>
 
 #include "common.hpp"
 
@@ -11,6 +16,13 @@ static const char* BINARY_BOX_PATH = LAZY_GLTF2_BASE_SAMPLE_DIR "/2.0/Box/glTF-B
 static const char* BASE64_BOX_PATH = LAZY_GLTF2_BASE_SAMPLE_DIR "/2.0/Box/glTF-Embedded/Box.gltf";
 static const char* DARCO_BOX_PATH = LAZY_GLTF2_BASE_SAMPLE_DIR "/2.0/Box/glTF-Draco/Box.gltf";
 
+static std::vector<unsigned char> readFile(const std::string& path) {
+    std::vector<unsigned char> data;
+    std::ifstream file(path, std::ios::binary);
+    data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return data;
+}
+
 void testBoxCommon(Gltf& gltf) {
     // counts
     EXPECT_EQ(2, gltf.nodeCount());
@@ -155,6 +167,76 @@ void testBoxCommon(Gltf& gltf) {
         EXPECT_EQ(12, bufferView.byteStride());
         EXPECT_EQ(BufferView::Target::ARRAY_BUFFER, bufferView.target());
     }
+    // buffer data is loaded once and shared by the buffer views
+    {
+        auto buffer = gltf.buffer(0);
+        auto data = buffer.data();
+        ASSERT_TRUE(data);
+        EXPECT_EQ(648, data.byteLength());
+        EXPECT_EQ(data.data(), gltf.bufferData(0).data());
+        std::vector<unsigned char> loaded;
+        EXPECT_TRUE(buffer.load(loaded));
+        EXPECT_TRUE(std::equal(data.begin(), data.end(), loaded.begin()));
+
+        auto indices = gltf.bufferView(0).data();
+        EXPECT_EQ(data.data() + 576, indices.data());
+        EXPECT_EQ(72, indices.byteLength());
+        EXPECT_EQ(0, indices.byteStride());
+        auto vertices = gltf.bufferView(1).data();
+        EXPECT_EQ(data.data(), vertices.data());
+        EXPECT_EQ(12, vertices.byteStride());
+        EXPECT_FALSE(gltf.bufferData(1));
+    }
+
+    // read accessors
+    {
+        std::vector<std::uint32_t> indices;
+        EXPECT_TRUE(gltf.accessor(0).read(indices));
+        ASSERT_EQ(36, indices.size());
+        EXPECT_EQ(23, *std::max_element(indices.begin(), indices.end()));
+        std::vector<std::uint16_t> shortIndices;
+        EXPECT_TRUE(gltf.accessor(0).read(shortIndices));
+        EXPECT_TRUE(std::equal(indices.begin(), indices.end(), shortIndices.begin()));
+
+        // normals and positions share a buffer view with a byteStride
+        std::vector<float> normals;
+        EXPECT_TRUE(gltf.accessor(1).read(normals));
+        ASSERT_EQ(72, normals.size());
+        for (size_t i = 0; i < normals.size(); i += 3) {
+            EXPECT_FLOAT_EQ(1.0f, std::abs(normals[i]) + std::abs(normals[i + 1]) + std::abs(normals[i + 2]));
+        }
+        std::vector<double> positions;
+        EXPECT_TRUE(gltf.accessor(2).read(positions));
+        ASSERT_EQ(72, positions.size());
+        for (auto p : positions) {
+            EXPECT_EQ(0.5, std::abs(p));
+        }
+
+        // views read the same values directly from the buffer
+        AccessorView<float, 3> positionView(gltf.accessor(2));
+        ASSERT_TRUE(positionView);
+        ASSERT_EQ(24, positionView.size());
+        EXPECT_EQ(12, positionView.stride());
+        size_t i = 0;
+        for (const auto& p : positionView) {
+            EXPECT_EQ(positions[i], p[0]);
+            EXPECT_EQ(positions[i + 1], p[1]);
+            EXPECT_EQ(positions[i + 2], p[2]);
+            i += 3;
+        }
+        EXPECT_EQ(normals[3], (AccessorView<float, 3>(gltf.accessor(1))[1][0]));
+        AccessorView<std::uint32_t, 1> indexView(gltf.accessor(0));
+        EXPECT_EQ(36, std::distance(indexView.begin(), indexView.end()));
+        EXPECT_EQ(36, indexView.end() - indexView.begin());
+        // standard algorithms treat the view as an input range
+        const std::vector<std::array<std::uint32_t, 1>> indexCopy(indexView.begin(), indexView.end());
+        ASSERT_EQ(36, indexCopy.size());
+        EXPECT_EQ(indices[35], indexCopy[35][0]);
+        EXPECT_EQ(indices[35], indexView[35][0]);
+        // the number of components must match the accessor type
+        EXPECT_FALSE((AccessorView<float, 4>(gltf.accessor(2))));
+    }
+
     // animations
     EXPECT_EQ(0, gltf.animationCount());
 
@@ -221,12 +303,452 @@ TEST(gltf, box_binary) {
     testMove(std::move(gltf));
 }
 
+TEST(gltf, box_binary_mapped) {
+    Gltf gltf;
+    gltf.setMemoryMapping(true);
+    EXPECT_TRUE(gltf.memoryMapping());
+    ASSERT_TRUE(gltf.load(BINARY_BOX_PATH));
+    testBoxCommon(gltf);
+
+    auto buffer = gltf.buffer(0);
+    auto view = buffer.data();
+    ASSERT_TRUE(view);
+    EXPECT_EQ(buffer.byteLength(), view.byteLength());
+
+    // the mapped chunk should match the data read with fread
+    std::vector<unsigned char> data;
+    EXPECT_TRUE(buffer.load(data));
+    std::vector<unsigned char> mapped(view.begin(), view.end());
+    EXPECT_EQ(data, mapped);
+
+    Gltf unmapped(BINARY_BOX_PATH);
+    std::vector<unsigned char> expected;
+    EXPECT_TRUE(unmapped.buffer(0).load(expected));
+    EXPECT_EQ(expected, data);
+    EXPECT_NE(view.data(), unmapped.buffer(0).data().data());
+
+    auto bufferView = gltf.bufferView(1);
+    auto bufferViewData = bufferView.data();
+    ASSERT_TRUE(bufferViewData);
+    EXPECT_EQ(view.data() + bufferView.byteOffset(), bufferViewData.data());
+    EXPECT_EQ(576, bufferViewData.byteLength());
+    EXPECT_EQ(12, bufferViewData.byteStride());
+}
+
 TEST(gltf, box_base64) {
     Gltf gltf = createGltf(BASE64_BOX_PATH);
     EXPECT_TRUE(gltf);
     testBoxCommon(gltf);
 }
 
+TEST(gltf, box_in_situ) {
+    Gltf gltf;
+    gltf.setInSituParsing(true);
+    EXPECT_TRUE(gltf.inSituParsing());
+    for (const char* path : { BOX_PATH, BASE64_BOX_PATH, BINARY_BOX_PATH }) {
+        ASSERT_TRUE(gltf.load(path));
+        testBoxCommon(gltf);
+        Gltf copied(path);
+        std::vector<unsigned char> expected;
+        std::vector<unsigned char> data;
+        EXPECT_TRUE(copied.buffer(0).load(expected));
+        EXPECT_TRUE(gltf.buffer(0).load(data));
+        EXPECT_EQ(expected, data);
+    }
+    // the strings must stay valid after the Gltf is moved
+    Gltf moved(std::move(gltf));
+    testBoxCommon(moved);
+}
+
+TEST(gltf, box_arena) {
+    // the caller provided buffer must outlive the arena
+    std::vector<std::uint64_t> storage;
+    auto arena = std::make_shared<JsonArena>();
+    Gltf gltf;
+    gltf.setArena(arena);
+    EXPECT_EQ(arena, gltf.arena());
+    ASSERT_TRUE(gltf.load(BASE64_BOX_PATH));
+    testBoxCommon(gltf);
+    const size_t used = arena->size();
+    EXPECT_LT(0, used);
+
+    // the backing buffer grows to the high water mark and is then reused
+    ASSERT_TRUE(gltf.load(BASE64_BOX_PATH));
+    testBoxCommon(gltf);
+    EXPECT_EQ(used, arena->highWaterMark());
+    const size_t capacity = arena->capacity();
+    EXPECT_LE(used, capacity);
+    for (const char* path : { BOX_PATH, BINARY_BOX_PATH, BASE64_BOX_PATH }) {
+        ASSERT_TRUE(gltf.load(path));
+        testBoxCommon(gltf);
+        EXPECT_EQ(capacity, arena->capacity());
+    }
+
+    // caller provided buffer
+    storage.resize(used);
+    auto userArena = std::make_shared<JsonArena>(storage.data(), storage.size() * sizeof(std::uint64_t));
+    EXPECT_LE(used, userArena->capacity());
+    gltf.setArena(userArena);
+    ASSERT_TRUE(gltf.load(BASE64_BOX_PATH));
+    testBoxCommon(gltf);
+    EXPECT_EQ(used, userArena->size());
+}
+
+TEST(gltf, box_memory) {
+    Gltf gltf;
+    const auto glb = readFile(BINARY_BOX_PATH);
+    ASSERT_TRUE(gltf.load(glb.data(), glb.size()));
+    testBoxCommon(gltf);
+    // the BIN chunk is used in place
+    const auto view = gltf.buffer(0).data();
+    ASSERT_TRUE(view);
+    EXPECT_LE(glb.data(), view.data());
+    EXPECT_GE(glb.data() + glb.size(), view.data() + view.byteLength());
+
+    const auto base64 = readFile(BASE64_BOX_PATH);
+    ASSERT_TRUE(gltf.load(base64.data(), base64.size()));
+    testBoxCommon(gltf);
+
+    // external buffers are loaded with the resolver
+    const std::string baseDir = Gltf(BOX_PATH).baseDir();
+    std::vector<std::string> resolved;
+    auto resolver = [&](const char* uri, std::vector<unsigned char>& data) {
+        resolved.push_back(uri);
+        data = readFile(baseDir + uri);
+        return !data.empty();
+    };
+    const auto json = readFile(BOX_PATH);
+    gltf.setInSituParsing(true);
+    ASSERT_TRUE(gltf.load(json.data(), json.size(), resolver));
+    testBoxCommon(gltf);
+    ASSERT_FALSE(resolved.empty());
+    EXPECT_EQ("Box0.bin", resolved.front());
+
+    // without a resolver external buffers can't be loaded
+    ASSERT_TRUE(gltf.load(json.data(), json.size()));
+    std::vector<unsigned char> data;
+    EXPECT_FALSE(gltf.buffer(0).load(data));
+    EXPECT_FALSE(gltf.load(json.data(), 0));
+}
+
+// A file system that serves files from memory and records what was opened.
+class MemoryFileSystem : public FileSystem {
+    class File : public InputFile {
+    public:
+        File(const std::vector<unsigned char>& data, bool mappable) : m_data(data), m_mappable(mappable) {}
+        size_t size() const noexcept override {
+            return m_data.size();
+        }
+        size_t read(size_t offset, void* data, size_t size) noexcept override {
+            if (offset > m_data.size()) {
+                return 0;
+            }
+            size = std::min(size, m_data.size() - offset);
+            memcpy(data, m_data.data() + offset, size);
+            return size;
+        }
+        DataView map() noexcept override {
+            return m_mappable ? DataView(m_data.data(), m_data.size()) : DataView();
+        }
+    private:
+        const std::vector<unsigned char>& m_data;
+        bool m_mappable;
+    };
+public:
+    explicit MemoryFileSystem(bool mappable) : m_mappable(mappable) {}
+    void add(const std::string& path, std::vector<unsigned char> data) {
+        m_files[path] = std::move(data);
+    }
+    std::unique_ptr<InputFile> open(const char* path) noexcept override {
+        opened.push_back(path);
+        const auto it = m_files.find(path);
+        if (it == m_files.end()) {
+            return nullptr;
+        }
+        return std::unique_ptr<InputFile>(new File(it->second, m_mappable));
+    }
+    std::vector<std::string> opened;
+private:
+    std::map<std::string, std::vector<unsigned char>> m_files;
+    bool m_mappable;
+};
+
+TEST(gltf, box_file_system) {
+    for (bool mappable : { false, true }) {
+        // the files only exist in memory
+        auto fileSystem = std::make_shared<MemoryFileSystem>(mappable);
+        const std::string baseDir = Gltf(BOX_PATH).baseDir();
+        fileSystem->add("mem/Box.gltf", readFile(BOX_PATH));
+        fileSystem->add("mem/Box0.bin", readFile(baseDir + "Box0.bin"));
+        fileSystem->add("mem/Box.glb", readFile(BINARY_BOX_PATH));
+
+        Gltf gltf;
+        gltf.setFileSystem(fileSystem);
+        EXPECT_EQ(fileSystem.get(), &gltf.fileSystem());
+        for (bool inSitu : { false, true }) {
+            gltf.setInSituParsing(inSitu);
+            ASSERT_TRUE(gltf.load("mem/Box.gltf"));
+            EXPECT_EQ("mem/", gltf.baseDir());
+            testBoxCommon(gltf);
+            EXPECT_NE(fileSystem->opened.end(), std::find(fileSystem->opened.begin(), fileSystem->opened.end(), "mem/Box0.bin"));
+        }
+        for (bool mapped : { false, true }) {
+            gltf.setMemoryMapping(mapped);
+            ASSERT_TRUE(gltf.load("mem/Box.glb"));
+            testBoxCommon(gltf);
+            EXPECT_EQ(mapped && mappable, static_cast<bool>(gltf.glbData()));
+        }
+        EXPECT_FALSE(gltf.load("mem/Missing.gltf"));
+
+        // a file loaded from memory without a resolver doesn't open relative URIs
+        fileSystem->add("Box0.bin", readFile(baseDir + "Box0.bin"));
+        fileSystem->opened.clear();
+        const auto json = readFile(BOX_PATH);
+        ASSERT_TRUE(gltf.load(json.data(), json.size()));
+        EXPECT_TRUE(gltf.loadedFromMemory());
+        EXPECT_FALSE(gltf.buffer(0).data());
+        EXPECT_TRUE(fileSystem->opened.empty());
+    }
+}
+
+TEST(gltf, box_file_system_shared_cache) {
+    // two file systems with the same paths but different bytes
+    const std::string baseDir = Gltf(BOX_PATH).baseDir();
+    auto cache = std::make_shared<BufferCache>();
+    std::vector<std::shared_ptr<MemoryFileSystem>> fileSystems;
+    std::vector<Gltf> gltfs(2);
+    for (size_t i = 0; i < gltfs.size(); ++i) {
+        fileSystems.push_back(std::make_shared<MemoryFileSystem>(false));
+        fileSystems[i]->add("mem/Box.gltf", readFile(BOX_PATH));
+        fileSystems[i]->add("mem/Box0.bin", std::vector<unsigned char>(648, static_cast<unsigned char>(i + 1)));
+        gltfs[i].setFileSystem(fileSystems[i]);
+        gltfs[i].setBufferCache(cache);
+        ASSERT_TRUE(gltfs[i].load("mem/Box.gltf"));
+    }
+    EXPECT_NE(fileSystems[0]->id(), fileSystems[1]->id());
+    for (size_t i = 0; i < gltfs.size(); ++i) {
+        const auto data = gltfs[i].bufferData(0);
+        ASSERT_TRUE(data);
+        EXPECT_EQ(i + 1, data.data()[0]);
+    }
+    EXPECT_EQ(2, cache->count());
+}
+
+TEST(gltf, collections) {
+    Gltf gltf(BOX_PATH);
+    ASSERT_TRUE(gltf);
+    EXPECT_EQ(gltf.nodeCount(), gltf.count(Collection::NODES));
+    EXPECT_EQ(2, gltf.count(Collection::NODES));
+    EXPECT_EQ(0, gltf.count(Collection::SKINS));
+    EXPECT_EQ(&gltf.doc()->FindMember("nodes")->value[1], gltf.object(Collection::NODES, 1));
+    EXPECT_EQ(nullptr, gltf.object(Collection::NODES, 2));
+    EXPECT_EQ(nullptr, gltf.object(Collection::SKINS, 0));
+    EXPECT_FALSE(gltf.node(2));
+    EXPECT_FALSE(gltf.skin(0));
+    EXPECT_EQ(gltf.accessorCount(), gltf.accessors().size());
+
+    // the tables are cleared when a new file is loaded
+    EXPECT_FALSE(gltf.load(LAZY_GLTF2_BASE_SAMPLE_DIR "/missing.gltf"));
+    EXPECT_EQ(0, gltf.nodeCount());
+    EXPECT_EQ(nullptr, gltf.object(Collection::NODES, 0));
+}
+
+TEST(gltf, compile) {
+    Gltf gltf(BOX_PATH);
+    Gltf expected(BOX_PATH);
+    EXPECT_EQ(nullptr, gltf.compiled());
+    const auto tables = gltf.compile();
+    ASSERT_TRUE(tables);
+    EXPECT_EQ(tables.get(), gltf.compiled());
+    testBoxCommon(gltf);
+
+    // the getters read the same values from the tables
+    ASSERT_EQ(expected.nodeCount(), tables->nodes.size());
+    for (size_t i = 0; i < expected.nodeCount(); ++i) {
+        const Node a = expected.node(i);
+        const Node b = gltf.node(i);
+        std::array<float, 16> ma, mb;
+        EXPECT_EQ(a.matrix(ma.data()), b.matrix(mb.data()));
+        EXPECT_EQ(a.rotation(ma.data()), b.rotation(mb.data()));
+        EXPECT_EQ(a.childCount(), b.childCount());
+        EXPECT_EQ(a.child(0).name() != nullptr, b.child(0).name() != nullptr);
+        size_t ia = 0, ib = 0;
+        EXPECT_EQ(a.mesh(ia), b.mesh(ib));
+        EXPECT_EQ(ia, ib);
+    }
+    ASSERT_EQ(expected.accessorCount(), tables->accessors.size());
+    for (size_t i = 0; i < expected.accessorCount(); ++i) {
+        const Accessor a = expected.accessor(i);
+        const Accessor b = gltf.accessor(i);
+        EXPECT_EQ(a.count(), b.count());
+        EXPECT_EQ(a.type(), b.type());
+        EXPECT_EQ(a.componentType(), b.componentType());
+        EXPECT_EQ(a.byteOffset(), b.byteOffset());
+        EXPECT_EQ(a.bufferView().byteStride(), b.bufferView().byteStride());
+        EXPECT_EQ(a.bufferView().byteLength(), b.bufferView().byteLength());
+    }
+    EXPECT_EQ(1, tables->meshes.size());
+    EXPECT_EQ(1, tables->primitives.size());
+    EXPECT_EQ(2, tables->primitives.attributes.size());
+    EXPECT_EQ(1, tables->materials.size());
+    EXPECT_EQ(expected.material(0).alphaMode(), gltf.material(0).alphaMode());
+    EXPECT_FLOAT_EQ(0.0f, tables->materials.metallicFactor[0]);
+
+    // the tables outlive the document and the handles read from them
+    gltf.releaseDocument();
+    EXPECT_FALSE(gltf);
+    EXPECT_EQ(2, tables->nodes.size());
+    EXPECT_EQ(CompiledGltf::NONE, tables->nodes.mesh[0]);
+    EXPECT_EQ(0, tables->nodes.mesh[1]);
+    ASSERT_EQ(expected.nodeCount(), gltf.nodeCount());
+    EXPECT_EQ(expected.accessorCount(), gltf.accessorCount());
+    EXPECT_EQ(expected.bufferViewCount(), gltf.bufferViewCount());
+    EXPECT_EQ(expected.materialCount(), gltf.materialCount());
+    EXPECT_EQ(0, gltf.sceneCount());
+    EXPECT_EQ(nullptr, gltf.node(0).name());
+    std::array<float, 16> ma, mb;
+    EXPECT_TRUE(expected.node(0).matrix(ma.data()));
+    EXPECT_TRUE(gltf.node(0).matrix(mb.data()));
+    EXPECT_EQ(ma, mb);
+    EXPECT_EQ(gltf.node(1), gltf.node(0).child(0));
+    EXPECT_EQ(gltf.node(0), gltf.node(1).parent());
+    EXPECT_EQ(expected.accessor(1).count(), gltf.accessor(1).count());
+
+    const Primitive a = expected.mesh(0).primitive(0);
+    ASSERT_EQ(1, gltf.mesh(0).primitiveCount());
+    const Primitive b = gltf.mesh(0).primitive(0);
+    ASSERT_TRUE(b);
+    EXPECT_EQ(b, gltf.mesh(0).primitives()[0]);
+    EXPECT_EQ(a.mode(), b.mode());
+    EXPECT_EQ(a.attributeCount(), b.attributeCount());
+    EXPECT_STREQ(a.attributeStrings()[1], b.attributeStrings()[1]);
+    ASSERT_TRUE(b.position());
+    EXPECT_EQ(a.position().count(), b.position().count());
+    size_t ia = 0, ib = 0;
+    EXPECT_TRUE(a.indices(ia));
+    EXPECT_TRUE(b.indices(ib));
+    EXPECT_EQ(ia, ib);
+    EXPECT_EQ(gltf.material(0), b.material());
+    const PbrMetallicRoughness pbr = gltf.material(0).pbrMetallicRoughness();
+    ASSERT_TRUE(pbr);
+    EXPECT_EQ(expected.material(0).pbrMetallicRoughness().baseColorFactor(), pbr.baseColorFactor());
+    EXPECT_FLOAT_EQ(0.0f, pbr.metallicFactor());
+    EXPECT_FALSE(pbr.baseColorTexture());
+
+    // loading releases the tables
+    ASSERT_TRUE(gltf.load(BOX_PATH));
+    EXPECT_EQ(nullptr, gltf.compiled());
+}
+
+TEST(gltf, compile_materials) {
+    static const char json[] = R"({
+        "asset": { "version": "2.0" },
+        "meshes": [ { "primitives": [
+            { "attributes": { "POSITION": 0, "TEXCOORD_0": 1 }, "material": 1, "mode": 1 },
+            { "attributes": { "POSITION": 1 } }
+        ] } ],
+        "accessors": [ { "count": 3, "componentType": 5126, "type": "VEC3" },
+                       { "count": 3, "componentType": 5126, "type": "VEC2" } ],
+        "materials": [
+            { "emissiveFactor": [ 1, 0.5, 0 ] },
+            { "pbrMetallicRoughness": { "baseColorTexture": { "index": 1 }, "roughnessFactor": 0.25 },
+              "normalTexture": { "index": 0, "scale": 2 } }
+        ],
+        "samplers": [ { "magFilter": 9728 } ],
+        "textures": [ { "source": 0 }, { "source": 1, "sampler": 0 } ]
+    })";
+    Gltf gltf;
+    ASSERT_TRUE(gltf.load(json, sizeof(json) - 1));
+    ASSERT_TRUE(gltf.compile());
+    for (int released = 0; released < 2; ++released) {
+        SCOPED_TRACE(released);
+        const Mesh mesh = gltf.mesh(0);
+        ASSERT_EQ(2, mesh.primitiveCount());
+        const Primitive p0 = mesh.primitive(0);
+        const Primitive p1 = mesh.primitive(1);
+        EXPECT_NE(p0, p1);
+        EXPECT_FALSE(mesh.primitive(2));
+        EXPECT_EQ(Primitive::Mode::LINES, p0.mode());
+        EXPECT_EQ(Primitive::Mode::TRIANGLES, p1.mode());
+        EXPECT_EQ(gltf.accessor(1), p0.texcoord(0));
+        EXPECT_EQ(gltf.accessor(1), p1.position());
+        EXPECT_FALSE(p1.texcoord(0));
+        EXPECT_EQ(gltf.material(1), p0.material());
+        EXPECT_FALSE(p1.material());
+
+        float emissive[3];
+        EXPECT_TRUE(gltf.material(0).emissiveFactor(emissive));
+        EXPECT_FLOAT_EQ(0.5f, emissive[1]);
+        EXPECT_FALSE(gltf.material(0).pbrMetallicRoughness());
+        EXPECT_FALSE(gltf.material(0).normalTexture());
+        const Material material = gltf.material(1);
+        const PbrMetallicRoughness pbr = material.pbrMetallicRoughness();
+        ASSERT_TRUE(pbr);
+        EXPECT_FLOAT_EQ(0.25f, pbr.roughnessFactor());
+        EXPECT_FLOAT_EQ(1.0f, pbr.metallicFactor());
+        EXPECT_EQ(1, pbr.baseColorTexture().index());
+        EXPECT_FALSE(pbr.metallicRoughnessTexture());
+        EXPECT_EQ(gltf.texture(0), material.normalTexture().texture());
+
+        size_t index = 0;
+        EXPECT_TRUE(gltf.texture(1).source(index));
+        EXPECT_EQ(1, index);
+        EXPECT_EQ(gltf.sampler(0), gltf.texture(1).sampler());
+        EXPECT_FALSE(gltf.texture(0).sampler());
+        EXPECT_EQ(Sampler::MagFilter::NEAREST, gltf.texture(1).sampler().magFilter());
+        gltf.releaseDocument();
+    }
+    // collections that aren't compiled are gone
+    EXPECT_EQ(0, gltf.imageCount());
+}
+
+TEST(gltf, find_by_name) {
+    static const char json[] = R"({
+        "asset": { "version": "2.0" },
+        "scenes": [ { "name": "Scene", "nodes": [ 0, 4 ] } ],
+        "nodes": [
+            { "name": "Root", "children": [ 1, 3 ] },
+            { "name": "Arm", "children": [ 2 ] },
+            { "name": "Hand" },
+            { "name": "Arm", "children": [ 5 ] },
+            { "name": "Root", "children": [ 6 ] },
+            { "name": "Finger" },
+            { "name": "Hand" }
+        ],
+        "materials": [ { "name": "Red" }, { }, { "name": "Red" } ],
+        "cameras": [ { "name": "Main", "type": "perspective" } ]
+    })";
+    Gltf gltf;
+    ASSERT_TRUE(gltf.load(json, sizeof(json) - 1));
+    ASSERT_EQ(7, gltf.nodeCount());
+
+    EXPECT_EQ(gltf.node(0), gltf.findNode("Root"));
+    EXPECT_EQ(gltf.node(2), gltf.findNode("Hand"));
+    EXPECT_FALSE(gltf.findNode("Missing"));
+    EXPECT_FALSE(gltf.findNode(nullptr));
+    EXPECT_EQ((std::vector<size_t>{ 0, 4 }), gltf.findIndices(Collection::NODES, "Root"));
+    EXPECT_EQ((std::vector<size_t>{ 1, 3 }), gltf.findIndices(Collection::NODES, "Arm"));
+    EXPECT_EQ((std::vector<size_t>{ 0, 2 }), gltf.findIndices(Collection::MATERIALS, "Red"));
+    EXPECT_TRUE(gltf.findIndices(Collection::SKINS, "Red").empty());
+    EXPECT_EQ(gltf.camera(0), gltf.findCamera("Main"));
+    EXPECT_EQ(gltf.scene(0), gltf.findScene("Scene"));
+
+    // paths
+    EXPECT_EQ(gltf.node(0), gltf.findNodeByPath("Root"));
+    EXPECT_EQ(gltf.node(2), gltf.findNodeByPath("Root/Arm/Hand"));
+    EXPECT_EQ(gltf.node(5), gltf.findNodeByPath("Root/Arm/Finger"));
+    EXPECT_EQ(gltf.node(6), gltf.findNodeByPath("Root/Hand"));
+    EXPECT_FALSE(gltf.findNodeByPath("Arm/Hand"));
+    EXPECT_FALSE(gltf.findNodeByPath("Root/Hand/Finger"));
+    EXPECT_FALSE(gltf.findNodeByPath("Root/"));
+    EXPECT_FALSE(gltf.findNodeByPath(nullptr));
+
+    // the index is rebuilt for the next file
+    ASSERT_TRUE(gltf.load(BOX_PATH));
+    EXPECT_FALSE(gltf.findNode("Root"));
+    EXPECT_TRUE(gltf.findMaterial("Red"));
+}
+
 TEST(gltf, compare_buffers) {
     Gltf g1(BOX_PATH);
     ASSERT_TRUE(g1);
@@ -258,6 +780,145 @@ TEST(gltf, compare_buffers) {
     EXPECT_NE(g1, Gltf());
 }
 
+TEST(gltf, box_shared_buffer_cache) {
+    auto cache = std::make_shared<BufferCache>();
+    Gltf g1;
+    g1.setBufferCache(cache);
+    ASSERT_TRUE(g1.load(BOX_PATH));
+    Gltf g2;
+    g2.setBufferCache(cache);
+    ASSERT_TRUE(g2.load(BOX_PATH));
+    EXPECT_EQ(cache, g1.bufferCache());
+
+    // external bin files are shared
+    auto d1 = g1.bufferData(0);
+    ASSERT_TRUE(d1);
+    EXPECT_EQ(d1.data(), g2.bufferData(0).data());
+    EXPECT_EQ(1, cache->count());
+    EXPECT_EQ(648, cache->size());
+
+    // pinned buffers stay valid after they are released
+    {
+        auto handle = g1.pinBuffer(0);
+        ASSERT_TRUE(handle);
+        EXPECT_TRUE(g1.releaseBuffer(0));
+        EXPECT_FALSE(g1.releaseBuffer(0));
+        EXPECT_EQ(0, cache->size());
+        EXPECT_EQ(d1.data(), handle.data());
+        EXPECT_EQ(648, handle.byteLength());
+    }
+
+    // embedded buffers are removed from the cache when the gltf is unloaded
+    {
+        Gltf g3;
+        g3.setBufferCache(cache);
+        ASSERT_TRUE(g3.load(BASE64_BOX_PATH));
+        EXPECT_TRUE(g3.bufferData(0));
+        EXPECT_EQ(1, cache->count());
+    }
+    EXPECT_EQ(0, cache->count());
+
+    // and when another gltf is moved over it
+    Gltf g4;
+    g4.setBufferCache(cache);
+    ASSERT_TRUE(g4.load(BASE64_BOX_PATH));
+    EXPECT_TRUE(g4.bufferData(0));
+    EXPECT_EQ(1, cache->count());
+    g4 = std::move(g2);
+    EXPECT_EQ(0, cache->count());
+    EXPECT_EQ(cache, g4.bufferCache());
+    EXPECT_TRUE(g4.bufferData(0));
+
+    // files loaded from memory that use the same URI don't share buffers
+    const auto json = readFile(BOX_PATH);
+    auto resolver = [](unsigned char fill) {
+        return [fill](const char*, std::vector<unsigned char>& data) {
+            data.assign(648, fill);
+            return true;
+        };
+    };
+    Gltf m1;
+    m1.setBufferCache(cache);
+    ASSERT_TRUE(m1.load(json.data(), json.size(), resolver(1)));
+    Gltf m2;
+    m2.setBufferCache(cache);
+    ASSERT_TRUE(m2.load(json.data(), json.size(), resolver(2)));
+    ASSERT_TRUE(m1.bufferData(0));
+    ASSERT_TRUE(m2.bufferData(0));
+    EXPECT_EQ(1, m1.bufferData(0).data()[0]);
+    EXPECT_EQ(2, m2.bufferData(0).data()[0]);
+}
+
+TEST(gltf, default_buffer_cache) {
+    Gltf gltf;
+    ASSERT_TRUE(gltf.bufferCache());
+    EXPECT_FALSE(gltf.pinBuffer(0));
+    EXPECT_EQ(0, gltf.bufferCache()->count());
+
+    // the default cache only holds the buffers of the loaded file
+    const auto cache = gltf.bufferCache();
+    for (const char* path : { BOX_PATH, BINARY_BOX_PATH, BOX_PATH }) {
+        ASSERT_TRUE(gltf.load(path));
+        EXPECT_TRUE(gltf.bufferData(0));
+        EXPECT_EQ(cache, gltf.bufferCache());
+        EXPECT_EQ(1, cache->count());
+        EXPECT_EQ(648, cache->size());
+    }
+    // pinned buffers outlive the load
+    auto handle = gltf.pinBuffer(0);
+    ASSERT_TRUE(gltf.load(BASE64_BOX_PATH));
+    EXPECT_EQ(0, cache->count());
+    EXPECT_EQ(648, handle.byteLength());
+
+    // a cache that was set is shared so the buffers of files are kept
+    auto shared = std::make_shared<BufferCache>();
+    gltf.setBufferCache(shared);
+    ASSERT_TRUE(gltf.load(BOX_PATH));
+    EXPECT_TRUE(gltf.bufferData(0));
+    ASSERT_TRUE(gltf.load(BOX_PATH));
+    EXPECT_EQ(1, shared->count());
+    gltf.setBufferCache(nullptr);
+    EXPECT_NE(shared, gltf.bufferCache());
+    ASSERT_TRUE(gltf.load(BOX_PATH));
+    EXPECT_EQ(1, shared->count());
+}
+
+TEST(buffer_cache, lru) {
+    BufferCache cache(250);
+    EXPECT_EQ(250, cache.budget());
+    cache.insert("a", std::vector<unsigned char>(100, 'a'));
+    cache.insert("b", std::vector<unsigned char>(100, 'b'));
+    EXPECT_EQ(200, cache.size());
+    // touch a so that b is the least recently used
+    EXPECT_TRUE(cache.find("a"));
+    cache.insert("c", std::vector<unsigned char>(100, 'c'));
+    EXPECT_EQ(2, cache.count());
+    EXPECT_TRUE(cache.find("a"));
+    EXPECT_FALSE(cache.find("b"));
+    EXPECT_TRUE(cache.find("c"));
+
+    // pinned buffers are not evicted
+    {
+        auto pinned = cache.find("a");
+        cache.setBudget(50);
+        EXPECT_EQ(1, cache.count());
+        ASSERT_TRUE(pinned);
+        EXPECT_EQ('a', pinned.data()[99]);
+    }
+    EXPECT_EQ(100, cache.size());
+    cache.trim();
+    EXPECT_EQ(0, cache.size());
+
+    // inserting an existing key keeps the old data
+    cache.setBudget(0);
+    cache.insert("d", std::vector<unsigned char>(10, 'd'));
+    auto d = cache.insert("d", std::vector<unsigned char>(20, 'x'));
+    EXPECT_EQ(10, d.byteLength());
+    cache.clear();
+    EXPECT_EQ(0, cache.count());
+    EXPECT_EQ('d', d.data()[0]);
+}
+
 TEST(gltf, box_darco) {
     Gltf gltf;
     ASSERT_TRUE(gltf.load(DARCO_BOX_PATH));
@@ -1,6 +1,8 @@
 #include <lazy_gltf2.hpp>
 #include <gtest/gtest.h>
 #include <array>
+#include <algorithm>
+#include <string>
 
 #include "common.hpp"
 
@@ -33,10 +35,139 @@ TEST(strings, dirName) {
     EXPECT_EQ("../../../", dirName("../../../box.gltf"));
 }
 
+TEST(strings, jsonKey) {
+    const JsonKey literal("translation");
+    EXPECT_EQ(11, literal.length());
+    char buffer[32] = "scale";
+    EXPECT_EQ(5, JsonKey(buffer).length());
+    const char* pointer = "rotation";
+    EXPECT_EQ(8, JsonKey(pointer).length());
+    EXPECT_EQ(0, JsonKey(static_cast<const char*>(nullptr)).length());
+    const char padded[16] = "name";
+    EXPECT_EQ(4, JsonKey(padded).length());
+}
+
+TEST(strings, str) {
+    JsonDocument doc;
+    doc.Parse(R"({ "name": "box", "uri": "box.bin" })");
+    Gltf gltf;
+    const Object object(&gltf, &doc);
+    EXPECT_STREQ("box", object.str("name"));
+    const std::string key = "uri";
+    EXPECT_STREQ("box.bin", object.str(key.c_str()));
+    const char padded[16] = "name";
+    EXPECT_STREQ("box", object.str(padded));
+    EXPECT_EQ(nullptr, object.str("missing"));
+    EXPECT_EQ(nullptr, object.str(static_cast<const char*>(nullptr)));
+}
+
+TEST(strings, findMember) {
+    JsonDocument doc;
+    doc.Parse(R"({ "a": 0, "ab": 1, "abc": 2, "b": 3, "c": 4, "d": 5, "e": 6, "f": 7, "g": 8, "h": 9 })");
+    ASSERT_TRUE(doc.IsObject());
+    EXPECT_EQ(1, findMember(doc, "ab")->value.GetInt());
+    EXPECT_EQ(2, findMember(doc, "abc")->value.GetInt());
+    EXPECT_EQ(9, findMember(doc, "h")->value.GetInt());
+    EXPECT_EQ(doc.MemberEnd(), findMember(doc, "x"));
+    EXPECT_EQ(doc.MemberEnd(), findMember(doc, "abcd"));
+    // a different object of the same kind with the members in another order
+    JsonDocument other;
+    other.Parse(R"({ "h": 0, "g": 1, "f": 2, "e": 3, "d": 4, "c": 5, "b": 6, "abc": 7, "ab": 8, "a": 9 })");
+    EXPECT_EQ(8, findMember(other, "ab")->value.GetInt());
+    EXPECT_EQ(1, findMember(doc, "ab")->value.GetInt());
+}
+
 TEST(base64, readBsae64) {
     std::vector<unsigned char> data;
     std::vector<unsigned char> expected{'1','2','3','4','5','6'};
     EXPECT_TRUE(readBase64("MTIzNDU2", 6, data));
     EXPECT_EQ(6, data.size());
     EXPECT_EQ(expected, data);
+}
+
+static std::string encodeBase64(const std::vector<unsigned char>& data, bool pad) {
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string text;
+    for (size_t i = 0; i < data.size(); i += 3) {
+        const size_t n = std::min<size_t>(3, data.size() - i);
+        std::uint32_t bits = data[i] << 16;
+        if (n > 1) bits |= data[i + 1] << 8;
+        if (n > 2) bits |= data[i + 2];
+        for (size_t j = 0; j < 4; ++j) {
+            if (j <= n) {
+                text.push_back(alphabet[(bits >> (18 - 6 * j)) & 0x3F]);
+            }
+            else if (pad) {
+                text.push_back('=');
+            }
+        }
+    }
+    return text;
+}
+
+TEST(base64, decodeBase64) {
+    std::vector<unsigned char> data;
+    std::vector<unsigned char> decoded;
+    for (size_t length = 0; length < 300; ++length) {
+        data.push_back(static_cast<unsigned char>(length * 7919 + (length >> 3)));
+        for (bool pad : { true, false }) {
+            const std::string text = encodeBase64(data, pad);
+            EXPECT_EQ(data.size(), base64DecodedSize(text.c_str(), text.size()));
+            decoded.assign(data.size(), 0);
+            ASSERT_TRUE(decodeBase64(text.c_str(), text.size(), decoded.data()));
+            EXPECT_EQ(data, decoded);
+            ASSERT_TRUE(readBase64(text.c_str(), data.size(), decoded));
+            EXPECT_EQ(data, decoded);
+        }
+    }
+
+    // invalid characters anywhere are detected
+    std::string text = encodeBase64(data, true);
+    for (size_t i : { size_t(0), size_t(17), size_t(100), text.size() - 5 }) {
+        std::string invalid = text;
+        invalid[i] = '*';
+        decoded.assign(data.size(), 0);
+        EXPECT_FALSE(decodeBase64(invalid.c_str(), invalid.size(), decoded.data()));
+    }
+
+    // line breaks are skipped by the fallback decoder
+    text.insert(76, "\n");
+    text.insert(200, "\r\n");
+    ASSERT_TRUE(readBase64(text.c_str(), data.size(), decoded));
+    EXPECT_EQ(data, decoded);
+}
+
+TEST(base64, parallel) {
+    std::vector<unsigned char> data(BASE64_MIN_CHUNK_LENGTH * 3 + 1000);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<unsigned char>(i * 31 + (i >> 11));
+    }
+    const std::string text = encodeBase64(data, true);
+    for (size_t threads : { 1, 2, 3, 8 }) {
+        std::vector<unsigned char> decoded(data.size());
+        ASSERT_TRUE(decodeBase64(text.c_str(), text.size(), decoded.data(), threads));
+        EXPECT_EQ(data, decoded);
+        ASSERT_TRUE(readBase64(text.c_str(), data.size(), decoded, threads));
+        EXPECT_EQ(data, decoded);
+    }
+    // an invalid character in any chunk is detected
+    std::string invalid = text;
+    invalid[text.size() / 2] = '*';
+    std::vector<unsigned char> decoded(data.size());
+    EXPECT_FALSE(decodeBase64(invalid.c_str(), invalid.size(), decoded.data(), 4));
+
+    // large buffers are decoded using the gltf's thread count
+    const std::string json = R"({ "asset": { "version": "2.0" }, "buffers": [ { "byteLength": )"
+        + std::to_string(data.size()) + R"(, "uri": "data:application/octet-stream;base64,)" + text + R"(" } ] })";
+    Gltf gltf;
+    EXPECT_EQ(1, gltf.decodeThreadCount());
+    gltf.setDecodeThreadCount(0);
+    EXPECT_LE(1, gltf.decodeThreadCount());
+    for (size_t threads : { 1, 4 }) {
+        gltf.setDecodeThreadCount(threads);
+        ASSERT_TRUE(gltf.load(json.c_str(), json.size()));
+        const DataView view = gltf.buffer(0).data();
+        ASSERT_EQ(data.size(), view.byteLength());
+        EXPECT_TRUE(std::equal(data.begin(), data.end(), view.data()));
+    }
 }
\ No newline at end of file
@@ -0,0 +1,359 @@
+#include <lazy_gltf2.hpp>
+#include <gtest/gtest.h>
+#include <string>
+#include <cstring>
+
+#include "common.hpp"
+
+using namespace gltf2;
+
+static void expectMatrixNear(const float* expected, const float* actual) {
+    for (size_t i = 0; i < 16; ++i) {
+        EXPECT_NEAR(expected[i], actual[i], 1e-5f) << i;
+    }
+}
+
+/// Computes the world matrix of a node by walking up to the root.
+static void referenceWorldMatrix(const SceneTransforms& transforms, size_t position, float* m) {
+    const float* local = transforms.localMatrix(position);
+    std::copy(local, local + 16, m);
+    for (std::uint32_t p = transforms.parent(position); p != SceneTransforms::NONE; p = transforms.parent(p)) {
+        const float* a = transforms.localMatrix(p);
+        float result[16];
+        for (size_t j = 0; j < 4; ++j) {
+            for (size_t i = 0; i < 4; ++i) {
+                result[j * 4 + i] = 0.0f;
+                for (size_t k = 0; k < 4; ++k) {
+                    result[j * 4 + i] += a[k * 4 + i] * m[j * 4 + k];
+                }
+            }
+        }
+        std::copy(result, result + 16, m);
+    }
+}
+
+TEST(transforms, composeMatrix) {
+    const float t[3] = { 1, 2, 3 };
+    const float identity[4] = { 0, 0, 0, 1 };
+    const float s[3] = { 2, 3, 4 };
+    float m[16];
+    composeMatrix(t, identity, s, m);
+    const float scaled[16] = { 2, 0, 0, 0, 0, 3, 0, 0, 0, 0, 4, 0, 1, 2, 3, 1 };
+    expectMatrixNear(scaled, m);
+
+    // 90 degrees around z
+    const float h = std::sqrt(0.5f);
+    const float r[4] = { 0, 0, h, h };
+    const float one[3] = { 1, 1, 1 };
+    composeMatrix(t, r, one, m);
+    const float rotated[16] = { 0, 1, 0, 0, -1, 0, 0, 0, 0, 0, 1, 0, 1, 2, 3, 1 };
+    expectMatrixNear(rotated, m);
+
+    // an arbitrary rotation gives the columns of the rotated and scaled axes
+    const float q[4] = { 0.18257419f, 0.36514837f, 0.54772256f, 0.73029674f };
+    composeMatrix(t, q, s, m);
+    const float x = q[0], y = q[1], z = q[2], w = q[3];
+    const float general[16] = {
+        (1 - 2 * (y * y + z * z)) * 2, 2 * (x * y + w * z) * 2, 2 * (x * z - w * y) * 2, 0,
+        2 * (x * y - w * z) * 3, (1 - 2 * (x * x + z * z)) * 3, 2 * (y * z + w * x) * 3, 0,
+        2 * (x * z + w * y) * 4, 2 * (y * z - w * x) * 4, (1 - 2 * (x * x + y * y)) * 4, 0,
+        1, 2, 3, 1
+    };
+    expectMatrixNear(general, m);
+}
+
+TEST(transforms, multiplyMatrices) {
+    float a[16], b[16], expected[16], out[16];
+    for (size_t i = 0; i < 16; ++i) {
+        a[i] = static_cast<float>(i + 1);
+        b[i] = static_cast<float>(16 - i) * 0.5f;
+    }
+    for (size_t j = 0; j < 4; ++j) {
+        for (size_t i = 0; i < 4; ++i) {
+            expected[j * 4 + i] = 0.0f;
+            for (size_t k = 0; k < 4; ++k) {
+                expected[j * 4 + i] += a[k * 4 + i] * b[j * 4 + k];
+            }
+        }
+    }
+    multiplyMatrices(a, b, out);
+    expectMatrixNear(expected, out);
+    // out may be b
+    multiplyMatrices(a, b, b);
+    expectMatrixNear(expected, b);
+}
+
+TEST(transforms, scene) {
+    static const char json[] = R"({
+        "asset": { "version": "2.0" },
+        "scenes": [ { "nodes": [ 0, 5, 9 ] } ],
+        "nodes": [
+            { "translation": [ 1, 0, 0 ], "children": [ 1, 2 ] },
+            { "rotation": [ 0, 0, 0.7071068, 0.7071068 ], "children": [ 3 ] },
+            { "scale": [ 2, 2, 2 ], "children": [ 3 ] },
+            { "translation": [ 0, 1, 0 ], "children": [ 0 ] },
+            { "name": "not in the scene" },
+            { "matrix": [ 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 5, 6, 7, 1 ], "children": [ 6, 99 ] },
+            { }
+        ]
+    })";
+    Gltf gltf;
+    ASSERT_TRUE(gltf.load(json, sizeof(json) - 1));
+    SceneTransforms transforms(gltf, gltf.scene(0));
+    // node 3 has two parents and a cycle back to node 0 and nodes 9 and 99 don't exist
+    ASSERT_EQ(6, transforms.size());
+    EXPECT_EQ(SceneTransforms::NONE, transforms.position(4));
+    EXPECT_EQ(SceneTransforms::NONE, transforms.position(99));
+    EXPECT_EQ(transforms.position(1), transforms.parent(transforms.position(3)));
+    EXPECT_EQ(SceneTransforms::NONE, transforms.parent(transforms.position(0)));
+    EXPECT_EQ(SceneTransforms::NONE, transforms.parent(transforms.position(5)));
+    for (size_t i = 0; i < transforms.size(); ++i) {
+        EXPECT_EQ(i, transforms.position(transforms.node(i)));
+        if (transforms.parent(i) != SceneTransforms::NONE) {
+            EXPECT_LT(transforms.parent(i), i);
+        }
+    }
+
+    transforms.evaluate();
+    // rotating (0, 1, 0) by 90 degrees around z gives (-1, 0, 0) then node 0 moves it back to the origin
+    const float node3[16] = { 0, 1, 0, 0, -1, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+    expectMatrixNear(node3, transforms.worldMatrix(transforms.position(3)));
+    const float node6[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 5, 6, 7, 1 };
+    expectMatrixNear(node6, transforms.worldMatrix(transforms.position(6)));
+
+    EXPECT_FALSE(transforms.build(gltf, Scene()));
+    EXPECT_TRUE(transforms.empty());
+}
+
+/// Creates a root with branches children that each have a chain of depth nodes.
+static std::string branchesJson(size_t branches, size_t depth) {
+    std::string json = R"({ "asset": { "version": "2.0" }, "scenes": [ { "nodes": [ 0 ] } ], "nodes": [ )";
+    json += R"({ "rotation": [ 0, 0.3826834, 0, 0.9238795 ], "children": [ )";
+    for (size_t i = 0; i < branches; ++i) {
+        json += (i > 0 ? ", " : "") + std::to_string(1 + i * depth);
+    }
+    json += " ] }";
+    for (size_t i = 0; i < branches; ++i) {
+        for (size_t d = 0; d < depth; ++d) {
+            const size_t index = 1 + i * depth + d;
+            json += R"(, { "translation": [ )" + std::to_string(i) + ", " + std::to_string(d) + R"(, 1 ], )";
+            json += R"("scale": [ 1.01, 1, 0.99 ])";
+            if (d + 1 < depth) {
+                json += R"(, "children": [ )" + std::to_string(index + 1) + " ]";
+            }
+            json += " }";
+        }
+    }
+    json += " ] }";
+    return json;
+}
+
+TEST(transforms, scene_parallel) {
+    // enough nodes to use more than one thread
+    const size_t branches = 100;
+    const size_t depth = 41;
+    const std::string json = branchesJson(branches, depth);
+    Gltf gltf;
+    ASSERT_TRUE(gltf.load(json.data(), json.size()));
+    SceneTransforms transforms(gltf, gltf.scene(0));
+    ASSERT_EQ(1 + branches * depth, transforms.size());
+    ASSERT_GE(transforms.size(), SceneTransforms::MIN_PARALLEL_NODES);
+    EXPECT_EQ(branches, transforms.subtreeCount());
+
+    transforms.evaluate(1);
+    std::vector<float> serial(transforms.worldMatrix(0), transforms.worldMatrix(0) + transforms.size() * 16);
+    transforms.evaluate(4);
+    for (size_t i = 0; i < transforms.size(); ++i) {
+        ASSERT_TRUE(std::equal(transforms.worldMatrix(i), transforms.worldMatrix(i) + 16, &serial[i * 16])) << i;
+        float expected[16];
+        referenceWorldMatrix(transforms, i, expected);
+        for (size_t j = 0; j < 16; ++j) {
+            ASSERT_NEAR(expected[j], transforms.worldMatrix(i)[j], 1e-6f * std::max(1000.0f, std::abs(expected[j]))) << i;
+        }
+    }
+}
+
+static const char HIERARCHY_JSON[] = R"({
+    "asset": { "version": "2.0" },
+    "scenes": [ { "nodes": [ 0, 4, 42 ] }, { "nodes": [ 5 ] } ],
+    "nodes": [
+        { "children": [ 1, 2 ] },
+        { "children": [ 3 ] },
+        { "children": [ 3, 7 ] },
+        { "children": [ 0 ] },
+        { },
+        { }
+    ]
+})";
+
+TEST(hierarchy, parents) {
+    Gltf gltf;
+    ASSERT_TRUE(gltf.load(HIERARCHY_JSON, sizeof(HIERARCHY_JSON) - 1));
+    const NodeHierarchy& hierarchy = gltf.hierarchy();
+    ASSERT_EQ(6, hierarchy.nodeCount());
+    ASSERT_EQ(2, hierarchy.sceneCount());
+    // node 0 is a root of the scene but also the child of node 3
+    EXPECT_EQ(3, hierarchy.parent(0));
+    EXPECT_EQ(0, hierarchy.parent(1));
+    EXPECT_EQ(1, hierarchy.parent(3));
+    EXPECT_EQ(2, hierarchy.parentCount(3));
+    EXPECT_EQ(NodeHierarchy::NONE, hierarchy.parent(4));
+    EXPECT_EQ(0, hierarchy.parentCount(4));
+    // node 7 doesn't exist
+    ASSERT_EQ(1, hierarchy.childCount(2));
+    EXPECT_EQ(3, hierarchy.children(2)[0]);
+    ASSERT_EQ(2, hierarchy.rootCount(0));
+    EXPECT_EQ(4, hierarchy.roots(0)[1]);
+    EXPECT_EQ(5, hierarchy.roots(1)[0]);
+
+    EXPECT_EQ(gltf.node(0), gltf.node(1).parent());
+    EXPECT_FALSE(gltf.node(4).parent());
+    size_t index;
+    EXPECT_TRUE(gltf.node(2).parent(index));
+    EXPECT_EQ(0, index);
+    EXPECT_FALSE(Node().parent());
+    EXPECT_EQ(0, Gltf().hierarchy().nodeCount());
+}
+
+TEST(hierarchy, traversal) {
+    Gltf gltf;
+    ASSERT_TRUE(gltf.load(HIERARCHY_JSON, sizeof(HIERARCHY_JSON) - 1));
+    NodeTraversal depthFirst(gltf.hierarchy());
+    depthFirst.startScene(0);
+    std::vector<std::uint32_t> nodes, depths;
+    for (const auto& visit : depthFirst) {
+        nodes.push_back(visit.node);
+        depths.push_back(visit.depth);
+    }
+    EXPECT_EQ((std::vector<std::uint32_t>{ 0, 1, 3, 2, 4 }), nodes);
+    EXPECT_EQ((std::vector<std::uint32_t>{ 0, 1, 2, 1, 0 }), depths);
+    // 3 -> 0 is a cycle and 2 -> 3 is a second parent
+    EXPECT_EQ(2, depthFirst.revisits());
+
+    NodeTraversal breadthFirst(gltf.hierarchy(), NodeTraversal::Order::BREADTH_FIRST);
+    breadthFirst.startScene(0);
+    nodes.clear();
+    std::vector<std::uint32_t> parents;
+    NodeTraversal::Visit visit;
+    while (breadthFirst.next(visit)) {
+        nodes.push_back(visit.node);
+        parents.push_back(visit.parent);
+    }
+    EXPECT_EQ((std::vector<std::uint32_t>{ 0, 4, 1, 2, 3 }), nodes);
+    EXPECT_EQ((std::vector<std::uint32_t>{ NodeHierarchy::NONE, NodeHierarchy::NONE, 0, 0, 1 }), parents);
+
+    // a node and its descendants; restarting reuses the traversal
+    breadthFirst.startNode(2);
+    nodes.clear();
+    for (const auto& v : breadthFirst) {
+        nodes.push_back(v.node);
+    }
+    EXPECT_EQ((std::vector<std::uint32_t>{ 2, 3, 0, 1 }), nodes);
+    EXPECT_EQ(2, breadthFirst.revisits());
+
+    breadthFirst.startNode(42);
+    EXPECT_TRUE(breadthFirst.begin() == breadthFirst.end());
+    breadthFirst.startScene(1);
+    EXPECT_EQ(5, breadthFirst.begin()->node);
+}
+
+TEST(transforms, update) {
+    const size_t depth = 41;
+    const std::string json = branchesJson(100, depth);
+    Gltf gltf;
+    ASSERT_TRUE(gltf.load(json.data(), json.size()));
+    SceneTransforms transforms(gltf, gltf.scene(0));
+    SceneTransforms expected(gltf, gltf.scene(0));
+    // update() evaluates everything the first time
+    transforms.update(4);
+    expected.evaluate();
+    ASSERT_EQ(0, memcmp(expected.worldMatrix(0), transforms.worldMatrix(0), expected.size() * 16 * sizeof(float)));
+
+    const float t[3] = { 1, 2, 3 };
+    const float h = std::sqrt(0.5f);
+    const float r[4] = { h, 0, 0, h };
+    const float s[3] = { 2, 2, 2 };
+    const float m[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 4, 5, 6, 1 };
+    // middle of a chain, two nodes of one chain and the start of another chain
+    for (SceneTransforms* x : { &transforms, &expected }) {
+        x->setTranslation(x->position(1 + 3 * depth + 10), t);
+        x->setRotation(x->position(1 + 7 * depth + 2), r);
+        x->setScale(x->position(1 + 7 * depth + 15), s);
+        x->setMatrix(x->position(1 + 50 * depth), m);
+    }
+    EXPECT_TRUE(transforms.dirty(transforms.position(1 + 3 * depth + 10)));
+    EXPECT_FALSE(transforms.dirty(transforms.position(1 + 3 * depth + 11)));
+    transforms.update(4);
+    expected.evaluate();
+    EXPECT_FALSE(transforms.dirty(transforms.position(1 + 3 * depth + 10)));
+    ASSERT_EQ(0, memcmp(expected.worldMatrix(0), transforms.worldMatrix(0), expected.size() * 16 * sizeof(float)));
+    expectMatrixNear(m, transforms.localMatrix(transforms.position(1 + 50 * depth)));
+
+    // the start of every chain, enough dirty nodes to use the threads
+    ASSERT_LE(SceneTransforms::MIN_PARALLEL_NODES, 100 * depth);
+    for (SceneTransforms* x : { &transforms, &expected }) {
+        for (size_t chain = 0; chain < 100; ++chain) {
+            x->setTranslation(x->position(1 + chain * depth), t);
+        }
+    }
+    transforms.update(4);
+    expected.evaluate();
+    ASSERT_EQ(0, memcmp(expected.worldMatrix(0), transforms.worldMatrix(0), expected.size() * 16 * sizeof(float)));
+
+    // the root moves every node
+    transforms.setTranslation(0, t);
+    expected.setTranslation(0, t);
+    transforms.update(4);
+    expected.evaluate();
+    ASSERT_EQ(0, memcmp(expected.worldMatrix(0), transforms.worldMatrix(0), expected.size() * 16 * sizeof(float)));
+    // nothing changed
+    transforms.update();
+    ASSERT_EQ(0, memcmp(expected.worldMatrix(0), transforms.worldMatrix(0), expected.size() * 16 * sizeof(float)));
+}
+
+TEST(transforms, update_rebuild) {
+    const std::string large = branchesJson(100, 41);
+    const std::string small = branchesJson(70, 3);
+    Gltf largeGltf, smallGltf;
+    ASSERT_TRUE(largeGltf.load(large.data(), large.size()));
+    ASSERT_TRUE(smallGltf.load(small.data(), small.size()));
+    // the subtree ends of the large scene must not be kept
+    SceneTransforms transforms(largeGltf, largeGltf.scene(0));
+    transforms.evaluate();
+    ASSERT_TRUE(transforms.build(smallGltf, smallGltf.scene(0)));
+    ASSERT_EQ(1 + 70 * 3, transforms.size());
+    ASSERT_LT(0, transforms.subtreeCount());
+    transforms.evaluate();
+    const float t[3] = { 1, 2, 3 };
+    for (size_t i = 0; i < transforms.size(); i += 7) {
+        transforms.setTranslation(i, t);
+    }
+    transforms.update(4);
+    for (size_t i = 0; i < transforms.size(); ++i) {
+        float expected[16];
+        referenceWorldMatrix(transforms, i, expected);
+        for (size_t j = 0; j < 16; ++j) {
+            ASSERT_NEAR(expected[j], transforms.worldMatrix(i)[j], 1e-4f) << i;
+        }
+    }
+}
+
+TEST(transforms, update_small_scene) {
+    // every node is in the levels near the roots
+    const std::string json = branchesJson(3, 4);
+    Gltf gltf;
+    ASSERT_TRUE(gltf.load(json.data(), json.size()));
+    SceneTransforms transforms(gltf, gltf.scene(0));
+    ASSERT_EQ(0, transforms.subtreeCount());
+    transforms.evaluate();
+    const float t[3] = { 1, 2, 3 };
+    transforms.setTranslation(transforms.position(2), t);
+    transforms.update();
+    for (size_t i = 0; i < transforms.size(); ++i) {
+        float expected[16];
+        referenceWorldMatrix(transforms, i, expected);
+        for (size_t j = 0; j < 16; ++j) {
+            ASSERT_NEAR(expected[j], transforms.worldMatrix(i)[j], 1e-4f) << i;
+        }
+    }
+}